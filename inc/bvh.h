@@ -0,0 +1,162 @@
+#ifndef TYDF_BVH_H
+#define TYDF_BVH_H
+
+#include <vector>
+#include <limits>
+#include "common.h"
+
+namespace GridTool::COMMON
+{
+    /// Axis-aligned bounding box.
+    class BOX
+    {
+    public:
+        Vector lo, hi;
+
+    public:
+        /// Empty box, expanding it with any point gives that point.
+        BOX();
+
+        BOX(const BOX &rhs) = default;
+
+        ~BOX() = default;
+
+        void expand(const Vector &p);
+
+        void expand(const BOX &b);
+
+        /// Enlarge by "tol" in each direction.
+        void inflate(Scalar tol);
+
+        bool contains(const Vector &p) const;
+
+        /// Squared distance from "p" to the box, 0 if inside.
+        Scalar distance2(const Vector &p) const;
+
+        Scalar center(short dim) const;
+
+        /// 0-based index of the longest dimension.
+        short longest() const;
+    };
+
+    /// Bounding volume hierarchy over a set of boxes.
+    /// Items are referred to by their 0-based index within the input.
+    class BVH
+    {
+    private:
+        struct NODE
+        {
+            BOX box;
+
+            /// Leaf: items within [first, first + num) of "m_item".
+            /// Otherwise "num" is 0, and children are "first" and "first + 1" of "m_node".
+            size_t first, num;
+        };
+
+        std::vector<NODE> m_node;
+        std::vector<size_t> m_item;
+
+    public:
+        BVH() = default;
+
+        BVH(const BVH &rhs) = default;
+
+        ~BVH() = default;
+
+        /// Built in parallel, with at most "leafSize" items in each leaf.
+        void build(const std::vector<BOX> &box, size_t leafSize = 4);
+
+        size_t numOfItem() const;
+
+        bool empty() const;
+
+        /// Find the item closest to "p".
+        /// "dist(item)" gives the exact distance from "p" to "item".
+        /// Returns the item index, and the distance is stored in "d".
+        /// If the tree is empty, "d" is set to infinity and the returned index is meaningless.
+        template<typename F>
+        size_t nearest(const Vector &p, const F &dist, Scalar &d) const
+        {
+            size_t best = 0;
+            d = std::numeric_limits<Scalar>::infinity();
+            if (empty())
+                return best;
+
+            std::vector<size_t> stack;
+            stack.reserve(64);
+            stack.push_back(0);
+            while (!stack.empty())
+            {
+                const auto &cur = m_node[stack.back()];
+                stack.pop_back();
+                if (cur.box.distance2(p) >= d * d)
+                    continue;
+
+                if (cur.num > 0)
+                {
+                    for (size_t i = cur.first; i < cur.first + cur.num; ++i)
+                    {
+                        const Scalar di = dist(m_item[i]);
+                        if (di < d)
+                        {
+                            d = di;
+                            best = m_item[i];
+                        }
+                    }
+                }
+                else
+                {
+                    /// The nearer child is visited first.
+                    const size_t c0 = cur.first, c1 = cur.first + 1;
+                    if (m_node[c0].box.distance2(p) < m_node[c1].box.distance2(p))
+                    {
+                        stack.push_back(c1);
+                        stack.push_back(c0);
+                    }
+                    else
+                    {
+                        stack.push_back(c0);
+                        stack.push_back(c1);
+                    }
+                }
+            }
+            return best;
+        }
+
+        /// Call "f(item)" on each item whose box contains "p",
+        /// stop as soon as "f" returns "true".
+        /// Returns "true" if stopped by "f".
+        template<typename F>
+        bool locate(const Vector &p, const F &f) const
+        {
+            if (empty())
+                return false;
+
+            std::vector<size_t> stack;
+            stack.reserve(64);
+            stack.push_back(0);
+            while (!stack.empty())
+            {
+                const auto &cur = m_node[stack.back()];
+                stack.pop_back();
+                if (!cur.box.contains(p))
+                    continue;
+
+                if (cur.num > 0)
+                {
+                    for (size_t i = cur.first; i < cur.first + cur.num; ++i)
+                        if (f(m_item[i]))
+                            return true;
+                }
+                else
+                {
+                    stack.push_back(cur.first + 1);
+                    stack.push_back(cur.first);
+                }
+            }
+            return false;
+        }
+    };
+}
+
+#endif
@@ -5,6 +5,8 @@
 #include <array>
 #include <string>
 #include <vector>
+#include <thread>
+#include <algorithm>
 #include <exception>
 #include <stdexcept>
 
@@ -14,6 +16,95 @@ namespace GridTool::COMMON
 
     Scalar relaxation(Scalar a, Scalar b, Scalar x);
 
+    /// Num of threads used by "parallel_for".
+    /// Defaults to the num of hardware threads.
+    size_t num_of_thread();
+
+    /// Set to 0 to restore the default.
+    void set_num_of_thread(size_t n);
+
+    /// Whether the calling thread is a worker of "parallel_for".
+    bool &in_parallel_for();
+
+    /// Split [0, n) into at most "num_of_thread()" contiguous chunks,
+    /// and call "f(first, last)" on each chunk concurrently.
+    /// The first exception thrown within any chunk is re-thrown to the caller.
+    /// Nested calls within a worker run serially.
+    template<typename F>
+    void parallel_for(size_t n, const F &f)
+    {
+        const size_t nt = std::min(num_of_thread(), n);
+        if (nt <= 1 || in_parallel_for())
+        {
+            if (n > 0)
+                f(size_t(0), n);
+            return;
+        }
+
+        const size_t chunk = (n + nt - 1) / nt;
+        std::vector<std::exception_ptr> err(nt, nullptr);
+        std::vector<std::thread> worker;
+        worker.reserve(nt);
+        for (size_t t = 0; t < nt; ++t)
+        {
+            const size_t first = t * chunk;
+            const size_t last = std::min(n, first + chunk);
+            if (first >= last)
+                break;
+
+            worker.emplace_back([&f, &err, t, first, last]()
+            {
+                in_parallel_for() = true;
+                try
+                {
+                    f(first, last);
+                }
+                catch (...)
+                {
+                    err[t] = std::current_exception();
+                }
+            });
+        }
+        for (auto &e : worker)
+            e.join();
+        for (auto &e : err)
+            if (e)
+                std::rethrow_exception(e);
+    }
+
+    /// Start "n" threads and call "f(t)" on each, where "t" ranges from 0 to n-1.
+    /// Unlike "parallel_for", "n" is not limited by "num_of_thread()",
+    /// which suits workers taking tasks by themselves.
+    /// The first exception thrown within any worker is re-thrown to the caller.
+    /// Calls of "parallel_for" within a worker run serially.
+    template<typename F>
+    void run_workers(size_t n, const F &f)
+    {
+        std::vector<std::exception_ptr> err(n, nullptr);
+        std::vector<std::thread> worker;
+        worker.reserve(n);
+        for (size_t t = 0; t < n; ++t)
+        {
+            worker.emplace_back([&f, &err, t]()
+            {
+                in_parallel_for() = true;
+                try
+                {
+                    f(t);
+                }
+                catch (...)
+                {
+                    err[t] = std::current_exception();
+                }
+            });
+        }
+        for (auto &e : worker)
+            e.join();
+        for (auto &e : err)
+            if (e)
+                std::rethrow_exception(e);
+    }
+
     struct wrong_index : public std::logic_error
     {
         wrong_index(long long idx, const std::string &reason) :
@@ -157,6 +248,89 @@ namespace GridTool::COMMON
     /// dst_RL: Unit normal vector from "rightCell" to "leftCell".
     void quadrilateral_normal(const Vector &n1, const Vector &n2, const Vector &n3, const Vector &n4, Vector &dst_LR, Vector &dst_RL);
 
+    /// Exact distance from "p" to the line segment "na-nb".
+    Scalar point_line_distance(const Vector &p, const Vector &na, const Vector &nb);
+
+    /// Exact distance from "p" to the triangle "na-nb-nc", interior included.
+    Scalar point_triangle_distance(const Vector &p, const Vector &na, const Vector &nb, const Vector &nc);
+
+    /// Distance from "p" to the quadrilateral, which is split into
+    /// triangles "n1-n2-n3" and "n1-n3-n4" as in "quadrilateral_area".
+    Scalar point_quadrilateral_distance(const Vector &p, const Vector &n1, const Vector &n2, const Vector &n3, const Vector &n4);
+
+    /// Inverse of a 3x3 matrix, both in row-major order.
+    /// Returns "false" if "|det(A)|" is less than "tol" times the product of diagonal entries,
+    /// which is a measure of conditioning for symmetric positive-definite matrices.
+    bool matrix_inverse(const Scalar *A, Scalar *B, Scalar tol = 1e-12);
+
+    /// Uniform spatial hash of points, built in parallel.
+    /// Cells are "2 * tol" wide and hashed into about as many buckets as points,
+    /// so that each query costs O(1) on average.
+    class POINT_HASH
+    {
+    private:
+        const std::vector<Vector> &m_coord;
+        Scalar m_tol;
+        Scalar m_h;
+        size_t m_mask;
+        std::vector<size_t> m_start;
+        std::vector<size_t> m_item;
+
+        long long quantize(Scalar x) const
+        {
+            return static_cast<long long>(std::floor(x / m_h));
+        }
+
+        size_t bucket(long long a, long long b, long long c) const
+        {
+            const auto h = static_cast<unsigned long long>(a) * 73856093ULL ^ static_cast<unsigned long long>(b) * 19349663ULL ^ static_cast<unsigned long long>(c) * 83492791ULL;
+            return static_cast<size_t>(h) & m_mask;
+        }
+
+    public:
+        /// "coord" is referenced, not copied.
+        /// Non-finite coordinates are rejected.
+        POINT_HASH(const std::vector<Vector> &coord, Scalar tol);
+
+        POINT_HASH(const POINT_HASH &rhs) = delete;
+
+        ~POINT_HASH() = default;
+
+        /// Call "f(n)" on each point "n" within the tolerance of "x",
+        /// points in the same cell are visited in ascending order.
+        template<typename F>
+        void query(const Vector &x, F &&f) const
+        {
+            long long lo[3], hi[3];
+            for (short d = 0; d < 3; ++d)
+            {
+                lo[d] = quantize(x[d] - m_tol);
+                hi[d] = quantize(x[d] + m_tol);
+            }
+
+            for (long long a = lo[0]; a <= hi[0]; ++a)
+                for (long long b = lo[1]; b <= hi[1]; ++b)
+                    for (long long c = lo[2]; c <= hi[2]; ++c)
+                    {
+                        const size_t k = bucket(a, b, c);
+                        for (size_t l = m_start[k]; l < m_start[k + 1]; ++l)
+                        {
+                            const size_t n = m_item[l];
+                            const auto &y = m_coord[n];
+
+                            /// Skip points in other cells sharing the same bucket,
+                            /// otherwise they may be visited more than once.
+                            if (quantize(y[0]) != a || quantize(y[1]) != b || quantize(y[2]) != c)
+                                continue;
+
+                            const Scalar dx = y[0] - x[0], dy = y[1] - x[1], dz = y[2] - x[2];
+                            if (dx * dx + dy * dy + dz * dz <= m_tol * m_tol)
+                                f(n);
+                        }
+                    }
+        }
+    };
+
     template <typename T>
     class Array1D : public std::vector<T>
     {
@@ -10,9 +10,13 @@
 #include <cstddef>
 #include <vector>
 #include <utility>
-#include <regex>
 #include "common.h"
 
+namespace GridTool::PLOT3D
+{
+    class GRID;
+}
+
 #define BC_ENUM { UNPROCESSED, ONE_TO_ONE, SYM, WALL, INFLOW, OUTFLOW, FAR }
 #define BC_STR { "UNPROCESSED", "ONE_TO_ONE", "SYM", "WALL", "INFLOW", "OUTFLOW", "FAR" }
 
@@ -308,6 +312,7 @@ namespace GridTool::NMF
             Block3D *dependentBlock = nullptr;
             std::array<SURF*, 2> dependentSurf{ nullptr, nullptr };
             std::array<VERTEX*, 2> includedVertex{ nullptr, nullptr };
+            bool opposite = false; /// Runs against the 1st frame of the same global index.
         };
 
         struct SURF
@@ -324,8 +329,96 @@ namespace GridTool::NMF
             std::array<VERTEX*, 4> counterpartVertex{ nullptr, nullptr, nullptr, nullptr };
         };
 
+        /// Read-only handle to a cell within the contiguous storage of the block.
+        class CONST_CELL_REF
+        {
+        private:
+            const Block3D *m_blk;
+            size_t m_pos; /// 0-based position within the block.
+
+        public:
+            CONST_CELL_REF(const Block3D *blk, size_t pos) : m_blk(blk), m_pos(pos) {}
+
+            CONST_CELL_REF(const CONST_CELL_REF &rhs) = default;
+
+            ~CONST_CELL_REF() = default;
+
+            size_t CellSeq() const;
+
+            /// 1-based indexing of node
+            size_t NodeSeq(size_t n) const;
+
+            /// 1-based indexing of face
+            size_t FaceSeq(size_t n) const;
+        };
+
+        /// Handle to a cell within the contiguous storage of the block.
+        /// Indices are read the same way as "HEX_CELL", and written through setters.
+        class CELL_REF
+        {
+        private:
+            Block3D *m_blk;
+            size_t m_pos; /// 0-based position within the block.
+
+        public:
+            CELL_REF(Block3D *blk, size_t pos) : m_blk(blk), m_pos(pos) {}
+
+            CELL_REF(const CELL_REF &rhs) = default;
+
+            ~CELL_REF() = default;
+
+            operator CONST_CELL_REF() const { return CONST_CELL_REF(m_blk, m_pos); }
+
+            size_t CellSeq() const;
+
+            /// 1-based indexing of node
+            size_t NodeSeq(size_t n) const;
+
+            /// 1-based indexing of face
+            size_t FaceSeq(size_t n) const;
+
+            /// Writing is not allowed under implicit numbering.
+            void setCellSeq(size_t x);
+
+            void setNodeSeq(size_t n, size_t x);
+
+            void setFaceSeq(size_t n, size_t x);
+        };
+
+        /// Layout of indices under implicit numbering.
+        /// Offsets are the global index right before the first entity of each group.
+        /// Cells, faces and nodes not shared with other blocks are affine functions of (i, j, k),
+        /// only those on double-sided surfaces are tabulated.
+        struct NUMBERING
+        {
+            size_t cell = 0;
+            size_t interiorFace = 0; /// Faces inside the block, K, I and J direction in sequence.
+            size_t interiorNode = 0;
+            std::array<size_t, NumOfSurf> surfFace{}; /// Faces on single-sided surfaces.
+            std::array<size_t, NumOfSurf> surfNode{}; /// Internal nodes of single-sided surfaces.
+            std::array<size_t, NumOfFrame> frameNode{}; /// Internal nodes of frames.
+            std::array<bool, NumOfFrame> frameReversed{}; /// Internal nodes of the frame are numbered backwards.
+            std::array<size_t, NumOfVertex> vertexNode{}; /// Global index of each vertex node.
+
+            /// Tables of double-sided surfaces, empty for single-sided ones.
+            /// Face at (pri, sec) is stored at "(pri - 1) + (nPri - 1) * (sec - 1)",
+            /// internal node at (pri, sec) is stored at "(pri - 2) + (nPri - 2) * (sec - 2)",
+            /// where "nPri" is the num of nodes in primary direction.
+            std::array<std::vector<size_t>, NumOfSurf> sharedFace;
+            std::array<std::vector<size_t>, NumOfSurf> sharedNode;
+        };
+
     private:
-        Array1D<HEX_CELL*> m_cell;
+        /// Cell records in SoA form, all in one allocation.
+        /// The cell index comes first, followed by 8 node indices and 6 face indices,
+        /// each field takes "cell_num()" consecutive entries, ordered with I varying fastest.
+        static const short NumOfCellField = 1 + NumOfVertex + NumOfSurf;
+        std::vector<size_t> m_cell;
+
+        /// Used instead of "m_cell" when set.
+        bool m_implicit;
+        NUMBERING m_numbering;
+
         Array1D<VERTEX> m_vertex;
         Array1D<FRAME> m_frame;
         Array1D<SURF> m_surf;
@@ -343,6 +436,18 @@ namespace GridTool::NMF
 
         void allocate_cell_storage();
 
+        /// Switch to implicit numbering, cell storage is released.
+        /// Indices are computed from "x" on demand, and cell records become read-only.
+        void implicit_numbering(NUMBERING &&x);
+
+        bool implicit_numbering() const;
+
+        /// Indices have been assigned, either explicitly or implicitly.
+        bool numbered() const;
+
+        /// Allocate cell storage and fill with indices given by "x".
+        void explicit_numbering(NUMBERING &&x);
+
         /// Access internal cell through 1-based index.
         /// Indexing convention:
         ///      "i" ranges from 1 to IDIM()-1;
@@ -350,9 +455,15 @@ namespace GridTool::NMF
         ///      "k" ranges from 1 to KDIM()-1;
         /// When the IJK-axis follows the right-hand convention, (i, j, k) represents
         /// the left-most, bottom-most and back-most node of the selected cell.
-        HEX_CELL &cell(size_t i, size_t j, size_t k);
+        CELL_REF cell(size_t i, size_t j, size_t k);
+
+        CONST_CELL_REF cell(size_t i, size_t j, size_t k) const;
+
+        /// Start of a field within the cell storage, see "m_cell".
+        /// Field 0 is the cell index, 1 to 8 are node indices, 9 to 14 are face indices.
+        size_t *cell_field(short n);
 
-        const HEX_CELL &cell(size_t i, size_t j, size_t k) const;
+        const size_t *cell_field(short n) const;
 
         /// Access vertex through 1-based index.
         /// The indexing convention follows OpenFOAM specification.
@@ -404,9 +515,33 @@ namespace GridTool::NMF
 
         void frame_internal_node_occurace(short f, size_t idx, std::vector<size_t*> &oc);
 
-        size_t node_index(size_t i, size_t j, size_t k);
+        /// Global index of node (i, j, k), 1-based.
+        size_t node_index(size_t i, size_t j, size_t k) const;
+
+        /// Global index of all nodes in one pass, 1-based.
+        /// "dst" is resized to IDIM() * JDIM() * KDIM(), with node (i, j, k)
+        /// at "(i - 1) + IDIM() * ((j - 1) + JDIM() * (k - 1))", the same as PLOT3D.
+        void node_index_map(std::vector<size_t> &dst) const;
+
+        /// Same as above, but only nodes with "kFirst <= k <= kLast" are included.
+        void node_index_map(size_t kFirst, size_t kLast, std::vector<size_t> &dst) const;
+
+        /// Num of nodes in primary direction of a surface.
+        size_t surface_pri_node_num(short s) const;
 
     private:
+        /// 0-based position of cell (i, j, k) within the cell storage.
+        size_t cell_pos(size_t i, size_t j, size_t k) const;
+
+        /// Writable entry of field "n" of the cell at "pos", see "m_cell".
+        size_t &cell_entry(short n, size_t pos);
+
+        size_t implicit_face_index(size_t i, size_t j, size_t k, short n) const;
+
+        size_t implicit_surface_face_index(short s, size_t pri, size_t sec) const;
+
+        size_t implicit_node_index(size_t i, size_t j, size_t k) const;
+
         void setup_dependence();
 
         void establish_connections();
@@ -649,7 +784,10 @@ namespace GridTool::NMF
         {
             // Copy blocks
             for (size_t i = 0; i < m_blk.size(); ++i)
+            {
                 m_blk[i] = new Block3D(*rhs.m_blk[i]);
+                m_blk[i]->index() = rhs.m_blk[i]->index();
+            }
 
             // Copy entries
             for (size_t i = 0; i < m_entry.size(); ++i)
@@ -669,11 +807,42 @@ namespace GridTool::NMF
 
         void readFromFile(const std::string &path);
 
+        /// Deduce blocks and entries from the geometry of "grid" alone.
+        /// Surface nodes within "tol" are taken as coincident, and cells of 2 surfaces
+        /// with all corners coincident are matched. Matched cells are gathered into
+        /// rectangular ONE_TO_ONE patches, while the rest are covered by "bc" entries.
+        /// Partial interfaces are recorded as is, but only those covering whole surfaces
+        /// are supported by "compute_topology".
+        void detectFromGrid(const PLOT3D::GRID &grid, double tol, const std::string &bc = "WALL");
+
+        /// Split block "b" and its counterpart in "grid" along "dir" ('I', 'J' or 'K')
+        /// at each node index of "idx", which shall be inside the block and ascending.
+        /// The 1st piece keeps the index, the others are appended in sequence, and
+        /// adjacent pieces are joined by new ONE_TO_ONE entries. Entries are split
+        /// along with the block, and as only interfaces covering whole surfaces are
+        /// supported, the cut is propagated through neighbouring blocks as well.
+        /// Topology is re-computed afterwards, while numbering shall be re-assigned.
+        /// Each appended piece is named after the split block ("B" and its index if unnamed),
+        /// followed by "_" and its own index.
+        /// Each cut is applied to both or neither of "grid" and the mapping, so they stay
+        /// consistent on exception, but topology shall be re-computed then.
+        void split(PLOT3D::GRID &grid, size_t b, char dir, const std::vector<size_t> &idx);
+
+        /// Same as above, but blocks are split until none has more than "maxCell" cells.
+        /// Each time, the largest block is split in the middle of its longest direction.
+        void split(PLOT3D::GRID &grid, size_t maxCell);
+
         void compute_topology();
 
         void summary(std::ostream &out);
 
-        void numbering();
+        /// Assign global indices of cells, faces and nodes.
+        /// In implicit mode, cell records are not materialized, see "Block3D::NUMBERING".
+        /// Indices are the same in both modes.
+        void numbering(bool implicit = false);
+
+        /// All blocks have been numbered.
+        bool numbered() const;
 
         void writeToFile(const std::string &path);
 
@@ -760,19 +929,42 @@ namespace GridTool::NMF
     private:
         void release_all();
 
+        /// Split block "b" along direction "d" (0 for I, 1 for J, 2 for K) at node "c",
+        /// with neither propagation nor topology. Nothing is changed on exception.
+        void split_block(PLOT3D::GRID &grid, size_t b, short d, size_t c);
+
+        /// Split blocks until all ONE_TO_ONE entries cover whole surfaces.
+        void split_propagate(PLOT3D::GRID &grid);
+
+        /// Blocks are replaced by fresh ones of the same dimensions before topology is re-computed.
+        void split_rebuild();
+
         void connecting();
 
         int coloring_surface();
 
+        /// Global indices of frames and vertexes are assigned by union-find over
+        /// all of them, joined through double-sided entries.
+        /// Groups are indexed in the order of their 1st member, block by block.
         int coloring_frame();
 
         int coloring_vertex();
 
-        void numbering_cell();
-
-        void numbering_face();
-
-        void numbering_node();
+        /// Count the num of cells, faces and nodes of each group, and accumulate
+        /// into offsets of each block. Global indices are assigned in sequence as:
+        ///   Cells: block by block;
+        ///   Faces: internal and single-sided ones of each block, block by block,
+        ///          then those on double-sided surfaces in the order of entries;
+        ///   Nodes: internal ones of each block, vertexes, internal ones of double-sided
+        ///          surfaces in the order of entries, internal ones of single-sided
+        ///          surfaces, and internal ones of frames.
+        void numbering_layout(std::vector<Block3D::NUMBERING> &num) const;
+
+        /// Call "f(pri1, sec1, pri2, sec2)" on each pair of coincident faces or internal nodes
+        /// of a double-sided entry, in the order of numbering.
+        /// Faces are identified by their cell index along each direction, nodes by node index.
+        template<typename F>
+        void interface_traverse(const DoubleSideEntry *p, bool isNode, F &&f) const;
     };
 }
 
@@ -2,6 +2,7 @@
 #define TYDF_PLOT3D_H
 
 #include <vector>
+#include <fstream>
 #include "common.h"
 
 namespace GridTool::PLOT3D
@@ -53,11 +54,49 @@ namespace GridTool::PLOT3D
 
         void writeToFile(const std::string &dst) const;
 
+        /// VTK multi-block file, each block is written to a ".vts" file
+        /// named after "dst" in the same directory.
+        void writeToVTK(const std::string &dst) const;
+
         /// 0-based indexing
         BLK *block(size_t loc_idx);
 
+        const BLK *block(size_t loc_idx) const;
+
+        /// Append a 3D block, which is owned by the grid.
+        /// Coordinates are zero-initialized.
+        BLK *add_block(size_t nI, size_t nJ, size_t nK);
+
+        /// Split a 3D block along "dir" ('I', 'J' or 'K') at the 1-based node index "idx".
+        /// The block keeps nodes up to "idx", and those from "idx" onwards are moved
+        /// into a new block appended at the end, which is returned.
+        BLK *split_block(size_t loc_idx, char dir, size_t idx);
+
     private:
         void release_all();
     };
+
+    /// Blocks of a grid file are loaded one after another,
+    /// so that only 1 block needs to be kept in memory.
+    class READER : public DIM
+    {
+    private:
+        std::ifstream m_fin;
+        std::vector<std::array<int, 3>> m_blkDim;
+        size_t m_next;
+
+    public:
+        READER(const std::string &src);
+
+        READER(const READER &rhs) = delete;
+
+        ~READER() = default;
+
+        size_t numOfBlock() const;
+
+        /// Load the next block, "nullptr" is returned after the last one.
+        /// Ownership is transferred to the caller.
+        BLK *next();
+    };
 }
 #endif
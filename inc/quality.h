@@ -0,0 +1,94 @@
+#ifndef TYDF_QUALITY_H
+#define TYDF_QUALITY_H
+
+#include <array>
+#include <string>
+#include <vector>
+#include <ostream>
+#include "xf.h"
+#include "plot3d.h"
+
+namespace GridTool::QUALITY
+{
+    /// Cell-wise metrics, larger value means worse quality.
+    /// SKEWNESS: Equiangle skewness, max over all faces of the cell, within [0, 1].
+    /// ASPECT_RATIO: Max over min distance from cell centroid to face centroids.
+    /// NON_ORTHOGONALITY: Max angle(in degrees) between face outward normal and
+    ///                    the vector connecting current centroid to the neighbouring one.
+    ///                    On boundary, the face centroid is taken as the neighbour.
+    /// VOLUME_RATIO: Max ratio between volumes of current cell and its face neighbours.
+    enum METRIC { SKEWNESS = 0, ASPECT_RATIO, NON_ORTHOGONALITY, VOLUME_RATIO, NumOfMetric };
+
+    std::string metric_name(int m);
+
+    struct OPTION
+    {
+        /// Num of bins within each histogram.
+        size_t nBin = 10;
+
+        /// Num of worst cells recorded for each metric in each zone.
+        size_t nWorst = 10;
+
+        /// Stop the analysis as soon as a non-positive volume is found.
+        bool stopAtNegativeVolume = true;
+
+        /// Range of histograms.
+        /// Values out of range are counted in the first or last bin.
+        std::array<double, NumOfMetric> lower{ 0.0, 1.0, 0.0, 1.0 };
+        std::array<double, NumOfMetric> upper{ 1.0, 100.0, 90.0, 10.0 };
+    };
+
+    struct RECORD
+    {
+        /// 1-based cell index.
+        /// For structured blocks, it is "i + (nI-1)*(j + (nJ-1)*k) + 1" with 0-based (i, j, k).
+        size_t cell;
+        double value;
+    };
+
+    struct ZONE_REPORT
+    {
+        /// Real zone index for unstructured grids, 1-based block index for structured ones.
+        size_t ID;
+        std::string name;
+
+        /// Num of cells examined and those with non-positive volume.
+        size_t nCell;
+        size_t nNegative;
+
+        /// Statistics of cells with positive volume.
+        std::array<double, NumOfMetric> min, max, mean;
+        std::array<std::vector<size_t>, NumOfMetric> histogram;
+
+        /// Sorted from worst.
+        std::array<std::vector<RECORD>, NumOfMetric> worst;
+
+        /// At most "nWorst" cells with non-positive volume, in ascending order.
+        std::vector<size_t> negative;
+    };
+
+    class REPORT
+    {
+    public:
+        OPTION option;
+
+        /// "true" if stopped early due to non-positive volume.
+        bool aborted = false;
+
+        std::vector<ZONE_REPORT> zone;
+
+        void summary(std::ostream &out) const;
+    };
+
+    /// Derived quantities of "mesh" are used directly.
+    /// Each cell zone is reported separately,
+    /// zones after an early stop are not reported.
+    void analyze(const XF::MESH &mesh, const OPTION &opt, REPORT &dst);
+
+    /// Only 3D blocks are supported.
+    /// Hexahedral cells are evaluated on the fly from nodal coordinates,
+    /// "blkID" is used as the zone index in "dst".
+    void analyze(const PLOT3D::BLK &blk, size_t blkID, const OPTION &opt, REPORT &dst);
+}
+
+#endif
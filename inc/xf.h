@@ -2,20 +2,34 @@
 #define TYDF_XF_H
 
 #include <cstddef>
+#include <cstdint>
 #include <istream>
 #include <ostream>
 #include <iostream>
 #include <fstream>
+#include <filesystem>
 #include <iomanip>
 #include <string>
 #include <array>
 #include <vector>
 #include <set>
 #include <map>
+#include <mutex>
 #include <utility>
 #include <algorithm>
 #include <cmath>
 #include "common.h"
+#include "bvh.h"
+
+namespace GridTool::NMF
+{
+    class Mapping3D;
+}
+
+namespace GridTool::PLOT3D
+{
+    class GRID;
+}
 
 namespace GridTool::XF
 {
@@ -241,6 +255,17 @@ namespace GridTool::XF
         int ND() const;
 
         void repr(std::ostream &out);
+
+        /// Width of each coordinate in fixed-width format, leading blanks included.
+        static const int FIXED_WIDTH = 20;
+
+        /// In fixed-width format, each node takes "ND() * FIXED_WIDTH + 1" chars,
+        /// so that coordinates can be overwritten in place, see "MESH::patchNode".
+        void repr(std::ostream &out, bool fixedWidth);
+
+        /// Write 1 node in fixed-width format, the line break included.
+        /// Returns the position after the last char written.
+        static char *fixed_width_repr(const Vector &p, int nd, char *dst);
     };
 
     class CELL : public RANGE, public std::vector<int>
@@ -512,6 +537,275 @@ namespace GridTool::XF
         void repr(std::ostream &out);
     };
 
+    /// Local mesh of a single partition.
+    /// Cells owned by this partition come first, followed by ghost cells
+    /// grouped by layer, and within each layer sorted by owner and global index.
+    /// All local and global indices are 1-based, 0 stands for "not available".
+    class PARTITION
+    {
+    public:
+        struct EXCHANGE
+        {
+            /// 0-based index of the partition on the other side.
+            size_t rank;
+
+            /// Local cell indices, in the same order on both sides.
+            std::vector<size_t> cell;
+        };
+
+    public:
+        size_t rank; /// 0-based index of this partition.
+        size_t nPart; /// Total num of partitions.
+        size_t nLayer; /// Num of ghost layers.
+        size_t nOwnedCell;
+        std::vector<size_t> nGhostCell; /// Num of ghost cells within each layer.
+
+        /// Local to global mapping.
+        std::vector<size_t> cellL2G;
+        std::vector<size_t> faceL2G;
+        std::vector<size_t> nodeL2G;
+
+        /// 0-based owner partition of each local cell.
+        std::vector<size_t> cellOwner;
+
+        /// Coordinates of local nodes.
+        std::vector<Vector> coordinate;
+
+        /// Local face connectivity.
+        /// Nodes are stored 4 per face with trailing 0 for triangles,
+        /// right-hand convention is preserved.
+        std::vector<int> faceNodeNum;
+        std::vector<size_t> faceNode;
+        std::vector<size_t> faceLeftCell, faceRightCell;
+        std::vector<size_t> faceZone; /// Real zone index of each local face.
+
+        /// Local cell-to-face connectivity in CSR form.
+        std::vector<size_t> cellFaceStart; /// Size is num of local cells plus 1.
+        std::vector<size_t> cellFace;
+
+        /// Halo exchange lists.
+        /// "send" holds owned cells, "recv" holds ghost cells.
+        std::vector<EXCHANGE> send, recv;
+
+    public:
+        PARTITION();
+
+        PARTITION(const PARTITION &rhs) = default;
+
+        ~PARTITION() = default;
+
+        size_t numOfCell() const;
+
+        size_t numOfFace() const;
+
+        size_t numOfNode() const;
+
+        /// Binary sidecar IO
+        void readFromFile(const std::string &src);
+
+        void writeToFile(const std::string &dst) const;
+    };
+
+    /// Precomputed weights of cell-centered schemes.
+    /// Each array is contiguous, and is written to file as is after a fixed-size header:
+    ///   8-byte magic, then "version", "nCell" and "nFace" as 64-bit integers,
+    ///   followed by "lsqInv" and "faceWeight" in native byte order.
+    /// Every record is 8-byte aligned, so the file can be mapped into memory directly.
+    class WEIGHT
+    {
+    public:
+        /// Row-major inverse of the least-squares matrix of each cell, 9 entries per cell.
+        /// The matrix is $\sum_j w_j \vec{d}_j \vec{d}_j^T$, where $\vec{d}_j$ is
+        /// the vector from cell centroid to the j-th neighbouring centroid, or to the
+        /// face centroid on boundary, and $w_j = 1 / |\vec{d}_j|^2$.
+        /// In 2D, entries related to Z-DIM are 0.
+        std::vector<double> lsqInv;
+
+        /// Linear interpolation weight of "leftCell" on each face,
+        /// that of "rightCell" is "1 - faceWeight".
+        /// On boundary faces, the weight of the missing cell is 0.
+        std::vector<double> faceWeight;
+
+    public:
+        WEIGHT() = default;
+
+        WEIGHT(const WEIGHT &rhs) = default;
+
+        ~WEIGHT() = default;
+
+        size_t numOfCell() const;
+
+        size_t numOfFace() const;
+
+        /// Binary sidecar IO
+        void readFromFile(const std::string &src);
+
+        void writeToFile(const std::string &dst) const;
+    };
+
+    /// Outcome of "MESH::validate".
+    /// Violations are counted within the zone of the related element.
+    class VALIDITY
+    {
+    public:
+        /// OPEN_CELL: Sum of outward vector areas of faces of the cell is not close to 0.
+        /// WRONG_ORIENTATION: "n_LR" of the face does not point from "leftCell" to "rightCell".
+        /// SHARED_FACE: The face has the same nodes as another face, or is included by no cell.
+        /// ORPHAN_NODE: The node is not included by any face.
+        /// MISPLACED_BOUNDARY: The boundary face is within an "interior" zone.
+        enum { OPEN_CELL = 0, WRONG_ORIENTATION, SHARED_FACE, ORPHAN_NODE, MISPLACED_BOUNDARY, NumOfCheck };
+
+        struct ZONE_COUNT
+        {
+            size_t ID; /// Real zone index.
+            std::string name;
+            std::array<size_t, NumOfCheck> count;
+        };
+
+        std::vector<ZONE_COUNT> zone;
+
+    public:
+        VALIDITY() = default;
+
+        VALIDITY(const VALIDITY &rhs) = default;
+
+        ~VALIDITY() = default;
+
+        static const std::string &check_name(int x);
+
+        /// Num of violations over all zones.
+        size_t total(int check) const;
+
+        bool ok() const;
+
+        void summary(std::ostream &out) const;
+    };
+
+    /// Read-only view of a derived mesh stored in the native binary format,
+    /// which is written by "MESH::writeSnapshot".
+    /// The file is mapped into memory and arrays are accessed in place,
+    /// so opening takes no time regardless of the mesh size.
+    /// Layout, every array is padded to 8 bytes and stored in native byte order:
+    ///   8-byte magic, then a fixed-size header of 64-bit integers,
+    ///   node coordinates, face node lists (CSR), face types, left and right cells,
+    ///   face centroids, areas and unit normals, cell types, cell face lists (CSR),
+    ///   cell centroids and volumes, the zone table, and zone names.
+    /// The checksum covers everything after the header.
+    /// All indices are 1-based, 0 stands for "not available".
+    class SNAPSHOT : public DIM
+    {
+    public:
+        /// Contiguous list of indices within the mapped file.
+        class LIST
+        {
+        private:
+            const std::uint64_t *m_first, *m_last;
+
+        public:
+            LIST(const std::uint64_t *first, const std::uint64_t *last) : m_first(first), m_last(last) {}
+
+            size_t size() const { return m_last - m_first; }
+
+            const std::uint64_t *begin() const { return m_first; }
+
+            const std::uint64_t *end() const { return m_last; }
+
+            /// 1-based indexing
+            size_t operator()(size_t i) const { return m_first[i - 1]; }
+        };
+
+        struct ZONE_ENTRY
+        {
+            size_t ID; /// Real zone index.
+            int section; /// One of "SECTION::NODE", "SECTION::FACE" and "SECTION::CELL", or 0 if unknown.
+            size_t first, last; /// Range of elements, 0 if unknown.
+            std::string type, name;
+        };
+
+    private:
+        friend class MESH;
+
+        struct HEADER;
+
+        const char *m_data;
+        size_t m_size;
+        bool m_mapped;
+        std::vector<std::uint64_t> m_buffer; /// Used when mapping is not available.
+        const HEADER *m_header;
+
+        const double *m_coordinate;
+        const std::uint64_t *m_faceNodeStart, *m_faceNode;
+        const std::int32_t *m_faceType;
+        const std::uint64_t *m_faceLeftCell, *m_faceRightCell;
+        const double *m_faceCenter, *m_faceArea, *m_faceNormal;
+        const std::int32_t *m_cellType;
+        const std::uint64_t *m_cellFaceStart, *m_cellFace;
+        const double *m_cellCenter, *m_cellVolume;
+        std::vector<ZONE_ENTRY> m_zone;
+
+        /// Materialized on first use.
+        mutable std::once_flag m_adjacentCellFlag, m_dependentFaceFlag;
+        mutable std::vector<std::uint64_t> m_adjacentCell;
+        mutable std::vector<std::uint64_t> m_dependentFaceStart, m_dependentFace;
+
+    public:
+        /// Header and layout are always checked,
+        /// the checksum is checked only if "verify" is set.
+        explicit SNAPSHOT(const std::string &src, bool verify = false);
+
+        SNAPSHOT(const SNAPSHOT &rhs) = delete;
+
+        ~SNAPSHOT();
+
+        /// Recompute the checksum and compare with the stored one.
+        bool verify() const;
+
+        size_t numOfNode() const;
+
+        size_t numOfFace() const;
+
+        size_t numOfCell() const;
+
+        size_t numOfZone() const;
+
+        Vector coordinate(size_t node) const;
+
+        int faceType(size_t face) const;
+
+        LIST faceNode(size_t face) const;
+
+        size_t faceLeftCell(size_t face) const;
+
+        size_t faceRightCell(size_t face) const;
+
+        Vector faceCenter(size_t face) const;
+
+        double faceArea(size_t face) const;
+
+        /// Unit normal from "leftCell" to "rightCell".
+        Vector faceNormal(size_t face) const;
+
+        int cellType(size_t cell) const;
+
+        LIST cellFace(size_t cell) const;
+
+        Vector cellCenter(size_t cell) const;
+
+        double cellVolume(size_t cell) const;
+
+        const ZONE_ENTRY &zone(size_t id) const;
+
+        /// Adjacent cells in the same order as "cellFace", 0 on boundary.
+        /// Built on the first call, safe to be called concurrently.
+        LIST adjacentCell(size_t cell) const;
+
+        /// Faces including the node.
+        /// Built on the first call, safe to be called concurrently.
+        LIST dependentFace(size_t node) const;
+    };
+
+    struct GLUE_SOURCE;
+
     class MESH : public DIM
     {
     private:
@@ -621,8 +915,35 @@ namespace GridTool::XF
 
         MESH(const std::string &inp, std::ostream &fout = std::cout);
 
+        /// Glued from NMF and PLOT3D, derived quantities are the same
+        /// as those of the written mesh when read back.
+        /// Use "glueToFile" instead if the mesh is only to be written out.
         MESH(const std::string &f_nmf, const std::string &f_p3d, std::ostream &fout = std::cout);
 
+        /// Same as above, but glued from memory, nothing is copied beforehand.
+        /// "nmf" shall have been numbered, see "NMF::Mapping3D::numbering".
+        MESH(const NMF::Mapping3D &nmf, const PLOT3D::GRID &p3d, std::ostream &fout = std::cout);
+
+        /// Coordinates of a block, in the same order as PLOT3D:
+        /// X of all nodes with I varying fastest, followed by Y and Z.
+        /// "second" is the num of values, i.e. "3 * IDIM * JDIM * KDIM".
+        typedef std::pair<const double *, size_t> COORD_SPAN;
+
+        /// "coord[n]" is read in place for Block "n + 1" of "nmf".
+        MESH(const NMF::Mapping3D &nmf, const std::vector<COORD_SPAN> &coord, std::ostream &fout = std::cout);
+
+        /// Same output as "MESH(f_nmf, f_p3d).writeToFile(dst)", but written
+        /// directly while walking through blocks, without building the mesh.
+        /// PLOT3D blocks are loaded one at a time.
+        static void glueToFile(const std::string &f_nmf, const std::string &f_p3d, const std::string &dst);
+
+        /// Assembly of components, which are appended one after another, with indices
+        /// of nodes, faces, cells and zones offset by the totals of previous ones.
+        /// Duplicated zone names are suffixed with the 1-based index of the component.
+        /// If "tol" is positive, coincident nodes are merged and matching boundary faces
+        /// are stitched afterwards, see "merge_node".
+        MESH(const std::vector<const MESH*> &src, double tol, std::ostream &fout = std::cout);
+
         MESH(const MESH &rhs) = delete;
 
         ~MESH();
@@ -630,7 +951,20 @@ namespace GridTool::XF
         /// IO
         void readFromFile(const std::string &src, std::ostream &fout);
 
-        void writeToFile(const std::string &dst) const;
+        /// Nodes are written in fixed-width format if "fixedWidthNode" is set.
+        void writeToFile(const std::string &dst, bool fixedWidthNode = false) const;
+
+        /// Overwrite nodal coordinates of an existing file in place,
+        /// "coord[i-1]" is the new location of node "i".
+        /// All NODE sections must be in fixed-width format, see "NODE::repr".
+        /// The file is left untouched if declarations or ranges do not match.
+        static void patchNode(const std::string &dst, const std::vector<Vector> &coord);
+
+        /// Binary VTU file, cell zone IDs are included as cell data.
+        void writeToVTK(const std::string &dst) const;
+
+        /// Native binary file, see "SNAPSHOT".
+        void writeSnapshot(const std::string &dst) const;
 
         /// Num of elements
         size_t numOfNode() const;
@@ -661,11 +995,46 @@ namespace GridTool::XF
 
         ZONE_ELEM &zone(size_t id, bool isRealZoneID = false);
 
+        /// Domain decomposition.
+        /// "cell_part[i-1]" is the 0-based partition index of cell "i".
+        /// Ghost cells of the 1st layer share a face with owned cells,
+        /// those of the 2nd layer share a node with the 1st layer.
+        void partition(const std::vector<size_t> &cell_part, size_t nLayer, std::vector<PARTITION> &dst) const;
+
+        /// Optional derivation stage on top of "raw2derived".
+        /// Least-squares and interpolation weights are computed in parallel
+        /// from cell and face centroids.
+        void compute_weight(WEIGHT &dst) const;
+
+        /// Distance from each cell centroid to the nearest face within
+        /// zones whose B.C. is "wall".
+        /// "dst[i-1]" is the value of cell "i".
+        void wall_distance(std::vector<double> &dst) const;
+
+        /// Consistency of derived quantities, checked in parallel.
+        /// Vector areas of faces are computed from nodes for closure, so that warped faces
+        /// are still closed up to round-off. "tol" is relative to the sum of face areas of each cell.
+        void validate(VALIDITY &dst, double tol = 1e-8) const;
+
+        /// Merge nodes within "tol" of each other, found by spatial hashing in parallel.
+        /// Each cluster of nodes is represented by its 1st node, and the order is preserved.
+        /// Afterwards, pairs of boundary faces sharing the same nodes are stitched into
+        /// interior faces, which are moved into the 1st interior zone, or a new one named
+        /// "int_merged" if there is none. Zones left empty are removed.
+        /// Returns the num of stitched pairs.
+        /// The mesh is left untouched if any face collapses or cells overlap.
+        size_t merge_node(double tol);
+
     private:
+        void glue(const NMF::Mapping3D &nmf, const GLUE_SOURCE &p3d, std::ostream &fout);
+
         void add_entry(SECTION *e);
 
         void clear_entry();
 
+        /// Raw records only, see "merge_node".
+        size_t stitch(double tol);
+
         void raw2derived();
 
         void cell_standardization(CELL_ELEM &c);
@@ -682,5 +1051,146 @@ namespace GridTool::XF
 
         void quad_standardization(CELL_ELEM &quad);
     };
+
+    /// Repeated gluing of grids sharing the same NMF, e.g. within optimization loops.
+    /// Topology, numbering and the map from structured nodes to unstructured ones
+    /// are settled once on construction, then each grid only updates coordinates.
+    class GLUE_SESSION
+    {
+    private:
+        NMF::Mapping3D *m_nmf;
+
+        /// 1-based global index of each node in PLOT3D order, block by block.
+        /// Set to 0 if the node has been taken from a previous block.
+        std::vector<size_t> m_nodeMap;
+        std::vector<size_t> m_blkOffset;
+
+        std::vector<Vector> m_node;
+
+        /// Last output file, and where its node section starts.
+        /// Size and modification time are recorded right after it is written,
+        /// so that changes from elsewhere can be told.
+        std::string m_dst;
+        size_t m_nodePos;
+        bool m_fixedWidth;
+        uintmax_t m_dstSize;
+        std::filesystem::file_time_type m_dstTime;
+
+    public:
+        explicit GLUE_SESSION(const std::string &f_nmf);
+
+        GLUE_SESSION(const GLUE_SESSION &rhs) = delete;
+
+        ~GLUE_SESSION();
+
+        size_t numOfNode() const;
+
+        /// 1-based access
+        const Vector &node(size_t id) const;
+
+        /// Scatter coordinates of all blocks into nodes.
+        void update(const std::string &f_p3d);
+
+        /// Same contents as "MESH::glueToFile", except that the node section
+        /// is placed at the end. When "dst" is the last output and has not been
+        /// modified since, only the node section is rewritten, or patched in place
+        /// if both are in fixed-width format. Otherwise, "dst" is rewritten entirely.
+        void writeToFile(const std::string &dst, bool fixedWidth = false);
+
+        /// Glue "f_p3d[i]" to "dst[i]" for all designs concurrently, sharing the numbering
+        /// and connectivity of this session read-only. Each design in flight keeps its own
+        /// coordinates only, and at most "nInFlight" designs are processed at the same time,
+        /// 0 stands for "COMMON::num_of_thread()".
+        /// Each output is the same as "writeToFile" on a fresh session.
+        /// The first exception is re-thrown after designs in flight are finished.
+        void batch(const std::vector<std::string> &f_p3d, const std::vector<std::string> &dst, size_t nInFlight = 0, bool fixedWidth = false) const;
+
+    private:
+        void scatter(const std::string &f_p3d, std::vector<Vector> &node) const;
+
+        static void write_node(std::ostream &fout, const std::vector<Vector> &node, bool fixedWidth);
+
+        /// Record size and modification time of "m_dst" after writing.
+        void record_output();
+    };
+
+    /// Point location among cells of a mesh.
+    /// Cells are assumed to be convex, a point is inside if it
+    /// lies behind all faces in terms of "CELL_ELEM::n".
+    /// The mesh must outlive the locator.
+    class LOCATOR
+    {
+    private:
+        const MESH &m_mesh;
+        COMMON::BVH m_tree;
+
+        /// Relative tolerance of the inside test.
+        double m_tol;
+
+        /// Diagonal of the bounding box of each cell.
+        std::vector<double> m_size;
+
+        /// Max num of steps in walk-based search.
+        size_t m_maxStep;
+
+    public:
+        explicit LOCATOR(const MESH &mesh, double tol = 1e-10);
+
+        LOCATOR(const LOCATOR &rhs) = delete;
+
+        ~LOCATOR() = default;
+
+        bool inside(size_t cell, const Vector &p) const;
+
+        /// 1-based index of the cell containing "p", 0 if not found.
+        /// When "seed" is non-zero, walk from that cell towards "p" first,
+        /// and fall back to the tree if the walk fails.
+        size_t locate(const Vector &p, size_t seed = 0) const;
+
+        /// Batched version, processed in parallel.
+        /// Within each thread, the previous hit serves as the seed of next query,
+        /// so coherent streams of points are located mostly by walking.
+        void locate(const std::vector<Vector> &p, std::vector<size_t> &dst) const;
+
+        /// 1-based index of the cell whose centroid is closest to "p".
+        size_t nearest(const Vector &p) const;
+    };
+
+    /// Linear operator transferring cell data between two meshes.
+    /// Stored in CSR form, so that it can be applied repeatedly:
+    /// "dst[t-1]" is the sum of "weight[k] * src[cell[k]-1]" for "k" within [start[t-1], start[t]).
+    class TRANSFER
+    {
+    public:
+        /// LINEAR: Value at the source cell containing the target centroid, or the nearest
+        ///         one if outside, corrected by the least-squares gradient over interior neighbours.
+        /// CONSERVATIVE: Overlap volumes are estimated by sampling the finer side locally,
+        ///               then balanced against volumes of both meshes. The integral over the domain
+        ///               is preserved exactly, and constants approximately, without constructing
+        ///               a supermesh.
+        enum { LINEAR = 0, CONSERVATIVE = 1 };
+
+        int mode;
+
+        std::vector<size_t> start;
+        std::vector<size_t> cell; /// 1-based source cell index.
+        std::vector<double> weight;
+
+    public:
+        TRANSFER();
+
+        TRANSFER(const TRANSFER &rhs) = default;
+
+        ~TRANSFER() = default;
+
+        size_t numOfTarget() const;
+
+        /// Computed in parallel with a spatial index of "src" cells,
+        /// "CONSERVATIVE" mode also indexes "dst" cells.
+        void build(const MESH &src, const MESH &dst, int mode);
+
+        /// Cell data of "src" to that of "dst", in parallel.
+        void apply(const std::vector<double> &src, std::vector<double> &dst) const;
+    };
 }
 #endif
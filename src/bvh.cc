@@ -0,0 +1,156 @@
+#include <numeric>
+#include <algorithm>
+#include "../inc/bvh.h"
+
+namespace GridTool::COMMON
+{
+    BOX::BOX() :
+        lo(std::numeric_limits<Scalar>::max()),
+        hi(std::numeric_limits<Scalar>::lowest())
+    {
+        /// Empty body.
+    }
+
+    void BOX::expand(const Vector &p)
+    {
+        for (short i = 0; i < 3; ++i)
+        {
+            lo[i] = std::min(lo[i], p[i]);
+            hi[i] = std::max(hi[i], p[i]);
+        }
+    }
+
+    void BOX::expand(const BOX &b)
+    {
+        for (short i = 0; i < 3; ++i)
+        {
+            lo[i] = std::min(lo[i], b.lo[i]);
+            hi[i] = std::max(hi[i], b.hi[i]);
+        }
+    }
+
+    void BOX::inflate(Scalar tol)
+    {
+        for (short i = 0; i < 3; ++i)
+        {
+            lo[i] -= tol;
+            hi[i] += tol;
+        }
+    }
+
+    bool BOX::contains(const Vector &p) const
+    {
+        for (short i = 0; i < 3; ++i)
+            if (p[i] < lo[i] || p[i] > hi[i])
+                return false;
+        return true;
+    }
+
+    Scalar BOX::distance2(const Vector &p) const
+    {
+        Scalar ret = 0.0;
+        for (short i = 0; i < 3; ++i)
+        {
+            Scalar d = 0.0;
+            if (p[i] < lo[i])
+                d = lo[i] - p[i];
+            else if (p[i] > hi[i])
+                d = p[i] - hi[i];
+            ret += d * d;
+        }
+        return ret;
+    }
+
+    Scalar BOX::center(short dim) const
+    {
+        return 0.5 * (lo[dim] + hi[dim]);
+    }
+
+    short BOX::longest() const
+    {
+        short ret = 0;
+        for (short i = 1; i < 3; ++i)
+            if (hi[i] - lo[i] > hi[ret] - lo[ret])
+                ret = i;
+        return ret;
+    }
+
+    void BVH::build(const std::vector<BOX> &box, size_t leafSize)
+    {
+        if (leafSize == 0)
+            throw std::invalid_argument("Leaf size of BVH must be positive.");
+
+        m_node.clear();
+        m_item.resize(box.size());
+        std::iota(m_item.begin(), m_item.end(), size_t(0));
+        if (box.empty())
+            return;
+
+        m_node.reserve(2 * (box.size() / leafSize + 1));
+        m_node.push_back(NODE{ BOX(), 0, box.size() });
+
+        /// Nodes are split level by level, those on the same level
+        /// cover disjoint ranges of "m_item" and are handled concurrently.
+        /// Children of the same parent are adjacent.
+        std::vector<size_t> half;
+        size_t lvFirst = 0, lvLast = 1;
+        while (lvFirst < lvLast)
+        {
+            half.assign(lvLast - lvFirst, 0);
+            COMMON::parallel_for(lvLast - lvFirst, [&](size_t first, size_t last)
+            {
+                for (size_t n = first; n < last; ++n)
+                {
+                    auto &cur = m_node[lvFirst + n];
+
+                    BOX bound, cbound;
+                    for (size_t i = cur.first; i < cur.first + cur.num; ++i)
+                    {
+                        const auto &b = box[m_item[i]];
+                        bound.expand(b);
+                        cbound.expand(Vector(b.center(0), b.center(1), b.center(2)));
+                    }
+                    cur.box = bound;
+
+                    if (cur.num <= leafSize)
+                        continue;
+
+                    /// Median split along the longest extent of centers.
+                    const short dim = cbound.longest();
+                    half[n] = cur.num / 2;
+                    std::nth_element(m_item.begin() + cur.first, m_item.begin() + cur.first + half[n], m_item.begin() + cur.first + cur.num, [&](size_t a, size_t b)
+                    {
+                        return box[a].center(dim) < box[b].center(dim);
+                    });
+                }
+            });
+
+            for (size_t n = lvFirst; n < lvLast; ++n)
+            {
+                const size_t h = half[n - lvFirst];
+                if (h == 0)
+                    continue;
+
+                const size_t first = m_node[n].first;
+                const size_t num = m_node[n].num;
+                m_node[n].first = m_node.size();
+                m_node[n].num = 0;
+                m_node.push_back(NODE{ BOX(), first, h });
+                m_node.push_back(NODE{ BOX(), first + h, num - h });
+            }
+
+            lvFirst = lvLast;
+            lvLast = m_node.size();
+        }
+    }
+
+    size_t BVH::numOfItem() const
+    {
+        return m_item.size();
+    }
+
+    bool BVH::empty() const
+    {
+        return m_node.empty();
+    }
+}
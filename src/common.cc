@@ -1,5 +1,8 @@
+#include <atomic>
 #include "../inc/common.h"
 
+static std::atomic<size_t> user_thread_num(0);
+
 namespace GridTool::COMMON
 {
     Scalar relaxation(Scalar a, Scalar b, Scalar x)
@@ -7,6 +10,27 @@ namespace GridTool::COMMON
         return (1.0 - x) * a + x * b;
     }
 
+    size_t num_of_thread()
+    {
+        const size_t n = user_thread_num.load();
+        if (n > 0)
+            return n;
+
+        const size_t hw = std::thread::hardware_concurrency();
+        return hw > 0 ? hw : 1;
+    }
+
+    void set_num_of_thread(size_t n)
+    {
+        user_thread_num.store(n);
+    }
+
+    bool &in_parallel_for()
+    {
+        static thread_local bool flag = false;
+        return flag;
+    }
+
     struct DIM::wrong_dimension : public wrong_index
     {
         wrong_dimension(int dim) :
@@ -320,4 +344,149 @@ namespace GridTool::COMMON
         dst_LR = dst_RL;
         dst_LR *= -1.0;
     }
+
+    Scalar point_line_distance(const Vector &p, const Vector &na, const Vector &nb)
+    {
+        Vector ab, ap;
+        delta(na, nb, ab);
+        delta(na, p, ap);
+
+        const Scalar L2 = ab.dot(ab);
+        Scalar t = L2 > 0.0 ? ap.dot(ab) / L2 : 0.0;
+        t = std::max(0.0, std::min(1.0, t));
+
+        ab *= t;
+        ap -= ab;
+        return ap.norm();
+    }
+
+    Scalar point_triangle_distance(const Vector &p, const Vector &na, const Vector &nb, const Vector &nc)
+    {
+        /// Closest point by Voronoi regions of vertices, edges and interior.
+        Vector ab, ac, ap;
+        delta(na, nb, ab);
+        delta(na, nc, ac);
+        delta(na, p, ap);
+
+        const Scalar d1 = ab.dot(ap);
+        const Scalar d2 = ac.dot(ap);
+        if (d1 <= 0.0 && d2 <= 0.0)
+            return line_length(p, na);
+
+        Vector bp;
+        delta(nb, p, bp);
+        const Scalar d3 = ab.dot(bp);
+        const Scalar d4 = ac.dot(bp);
+        if (d3 >= 0.0 && d4 <= d3)
+            return line_length(p, nb);
+
+        const Scalar vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+            return point_line_distance(p, na, nb);
+
+        Vector cp;
+        delta(nc, p, cp);
+        const Scalar d5 = ab.dot(cp);
+        const Scalar d6 = ac.dot(cp);
+        if (d6 >= 0.0 && d5 <= d6)
+            return line_length(p, nc);
+
+        const Scalar vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+            return point_line_distance(p, na, nc);
+
+        const Scalar va = d3 * d6 - d5 * d4;
+        if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+            return point_line_distance(p, nb, nc);
+
+        const Scalar denom = va + vb + vc;
+        if (denom <= 0.0) /// Degenerated
+            return std::min(point_line_distance(p, na, nb), std::min(point_line_distance(p, nb, nc), point_line_distance(p, nc, na)));
+
+        const Scalar v = vb / denom;
+        const Scalar w = vc / denom;
+        ab *= v;
+        ac *= w;
+        Vector q = na;
+        q += ab;
+        q += ac;
+        return line_length(p, q);
+    }
+
+    Scalar point_quadrilateral_distance(const Vector &p, const Vector &n1, const Vector &n2, const Vector &n3, const Vector &n4)
+    {
+        const Scalar d123 = point_triangle_distance(p, n1, n2, n3);
+        const Scalar d134 = point_triangle_distance(p, n1, n3, n4);
+        return std::min(d123, d134);
+    }
+
+    bool matrix_inverse(const Scalar *A, Scalar *B, Scalar tol)
+    {
+        const Scalar det = A[0] * (A[4] * A[8] - A[5] * A[7]) - A[1] * (A[3] * A[8] - A[5] * A[6]) + A[2] * (A[3] * A[7] - A[4] * A[6]);
+        if (!(std::fabs(det) > tol * std::fabs(A[0] * A[4] * A[8])))
+            return false;
+
+        B[0] = (A[4] * A[8] - A[5] * A[7]) / det;
+        B[1] = (A[2] * A[7] - A[1] * A[8]) / det;
+        B[2] = (A[1] * A[5] - A[2] * A[4]) / det;
+        B[3] = (A[5] * A[6] - A[3] * A[8]) / det;
+        B[4] = (A[0] * A[8] - A[2] * A[6]) / det;
+        B[5] = (A[2] * A[3] - A[0] * A[5]) / det;
+        B[6] = (A[3] * A[7] - A[4] * A[6]) / det;
+        B[7] = (A[1] * A[6] - A[0] * A[7]) / det;
+        B[8] = (A[0] * A[4] - A[1] * A[3]) / det;
+        return true;
+    }
+
+    POINT_HASH::POINT_HASH(const std::vector<Vector> &coord, Scalar tol) :
+        m_coord(coord),
+        m_tol(tol),
+        m_h(2 * tol)
+    {
+        if (!(tol > 0))
+            throw std::invalid_argument("Tolerance must be positive.");
+
+        const size_t n = coord.size();
+        size_t nBucket = 1;
+        while (nBucket < n)
+            nBucket <<= 1;
+        m_mask = nBucket - 1;
+
+        std::vector<size_t> key(n);
+        std::vector<std::atomic<size_t>> cnt(nBucket + 1);
+        for (auto &e : cnt)
+            e.store(0, std::memory_order_relaxed);
+        parallel_for(n, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                const auto &x = coord[i];
+                for (short d = 0; d < 3; ++d)
+                    if (!std::isfinite(x[d]))
+                        throw std::runtime_error("Invalid coordinate detected.");
+                key[i] = bucket(quantize(x[0]), quantize(x[1]), quantize(x[2]));
+                ++cnt[key[i] + 1];
+            }
+        });
+
+        m_start.resize(nBucket + 1);
+        m_start[0] = 0;
+        for (size_t i = 1; i <= nBucket; ++i)
+            m_start[i] = m_start[i - 1] + cnt[i].load();
+
+        /// Items of each bucket are sorted afterwards to be deterministic.
+        m_item.resize(n);
+        for (size_t i = 0; i < nBucket; ++i)
+            cnt[i].store(m_start[i]);
+        parallel_for(n, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+                m_item[cnt[key[i]]++] = i;
+        });
+        parallel_for(nBucket, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+                std::sort(m_item.begin() + m_start[i], m_item.begin() + m_start[i + 1]);
+        });
+    }
 }
@@ -0,0 +1,369 @@
+#include <cmath>
+#include <tuple>
+#include "../inc/nmf.h"
+#include "../inc/plot3d.h"
+
+namespace GridTool::NMF
+{
+    using COMMON::Vector;
+
+    /// A surface of a block to be matched, nodes are stored from "offset"
+    /// in the flat arrays, with "pri" varying fastest.
+    struct DETECT_SURF
+    {
+        size_t blk = 0; /// 0-based
+        short surf = 0; /// 1-based
+        size_t nPri = 0, nSec = 0;
+        size_t offset = 0;
+    };
+
+    /// A node on another surface, which is coincident with the current one.
+    struct DETECT_MATCH
+    {
+        size_t surf; /// 0-based index of the surface
+        long long pri, sec; /// 1-based
+    };
+
+    /// Affine map of node index from the current surface to surface "surf",
+    /// "(pri, sec)" goes to "offset + pri * dPri + sec * dSec".
+    struct DETECT_MAP
+    {
+        size_t surf;
+        long long dPri[2], dSec[2], offset[2];
+
+        bool operator==(const DETECT_MAP &rhs) const
+        {
+            return surf == rhs.surf &&
+                dPri[0] == rhs.dPri[0] && dPri[1] == rhs.dPri[1] &&
+                dSec[0] == rhs.dSec[0] && dSec[1] == rhs.dSec[1] &&
+                offset[0] == rhs.offset[0] && offset[1] == rhs.offset[1];
+        }
+
+        void apply(long long pri, long long sec, long long &dstPri, long long &dstSec) const
+        {
+            dstPri = offset[0] + pri * dPri[0] + sec * dSec[0];
+            dstSec = offset[1] + pri * dPri[1] + sec * dSec[1];
+        }
+    };
+
+    /// A rectangular patch of cells on a surface, "map" is -1 if not matched.
+    struct DETECT_PATCH
+    {
+        size_t pri0, pri1, sec0, sec1; /// Range of cells, 1-based and inclusive.
+        int map;
+    };
+
+    /// Node (pri, sec) of surface "s" in (i, j, k), all 1-based.
+    static void detect_surface_node(short s, size_t pri, size_t sec, size_t nI, size_t nJ, size_t nK, size_t &i, size_t &j, size_t &k)
+    {
+        switch (s)
+        {
+        case 1:
+        case 2:
+            i = pri;
+            j = sec;
+            k = s == 1 ? 1 : nK;
+            break;
+        case 3:
+        case 4:
+            j = pri;
+            k = sec;
+            i = s == 3 ? 1 : nI;
+            break;
+        case 5:
+        case 6:
+            k = pri;
+            i = sec;
+            j = s == 5 ? 1 : nJ;
+            break;
+        default:
+            throw std::invalid_argument("Invalid surface index: " + std::to_string(s) + ".");
+        }
+    }
+
+    void Mapping3D::detectFromGrid(const PLOT3D::GRID &grid, double tol, const std::string &bc)
+    {
+        if (!(tol > 0))
+            throw std::invalid_argument("Tolerance must be positive.");
+        if (!BC::isValidBCStr(bc) || BC::str2idx(bc) == BC::ONE_TO_ONE)
+            throw std::invalid_argument("B.C. named \"" + bc + "\" can not be assigned to unmatched surfaces.");
+        if (!grid.is3D())
+            throw std::invalid_argument("Only 3D grid is supported.");
+
+        const size_t NumOfBlk = grid.numOfBlock();
+        if (NumOfBlk == 0)
+            throw std::invalid_argument("No block found in the grid.");
+
+        /// Nodes of all surfaces are gathered in sequence.
+        std::vector<DETECT_SURF> surf(NumOfBlk * Block3D::NumOfSurf);
+        size_t nNode = 0;
+        for (size_t n = 0; n < NumOfBlk; ++n)
+        {
+            const auto b = grid.block(n);
+            const size_t nI = b->nI(), nJ = b->nJ(), nK = b->nK();
+            if (nI < 2 || nJ < 2 || nK < 2)
+                throw std::invalid_argument("Invalid dimension of block " + std::to_string(n + 1) + ".");
+
+            const size_t nPri[Block3D::NumOfSurf] = { nI, nI, nJ, nJ, nK, nK };
+            const size_t nSec[Block3D::NumOfSurf] = { nJ, nJ, nK, nK, nI, nI };
+            for (short s = 1; s <= Block3D::NumOfSurf; ++s)
+            {
+                auto &e = surf[n * Block3D::NumOfSurf + s - 1];
+                e.blk = n;
+                e.surf = s;
+                e.nPri = nPri[s - 1];
+                e.nSec = nSec[s - 1];
+                e.offset = nNode;
+                nNode += e.nPri * e.nSec;
+            }
+        }
+
+        std::vector<Vector> coord(nNode);
+        COMMON::parallel_for(surf.size(), [&](size_t first, size_t last)
+        {
+            for (size_t m = first; m < last; ++m)
+            {
+                const auto &e = surf[m];
+                const auto b = grid.block(e.blk);
+                for (size_t sec = 1; sec <= e.nSec; ++sec)
+                    for (size_t pri = 1; pri <= e.nPri; ++pri)
+                    {
+                        size_t i, j, k;
+                        detect_surface_node(e.surf, pri, sec, b->nI(), b->nJ(), b->nK(), i, j, k);
+                        coord[e.offset + (pri - 1) + e.nPri * (sec - 1)] = b->at(i - 1, j - 1, k - 1);
+                    }
+            }
+        });
+
+        /// Coincident nodes on other surfaces, in CSR form.
+        /// Nodes shared by adjacent surfaces of the same block are excluded.
+        auto locate = [&](size_t node, size_t &m, size_t &pri, size_t &sec)
+        {
+            m = std::upper_bound(surf.begin(), surf.end(), node, [](size_t x, const DETECT_SURF &e) { return x < e.offset; }) - surf.begin() - 1;
+            const size_t loc = node - surf[m].offset;
+            pri = loc % surf[m].nPri + 1;
+            sec = loc / surf[m].nPri + 1;
+        };
+
+        const COMMON::POINT_HASH hash(coord, tol);
+        const size_t nChunk = std::max<size_t>(1, std::min(nNode, 64 * COMMON::num_of_thread()));
+        std::vector<std::vector<std::pair<size_t, DETECT_MATCH>>> chunkMatch(nChunk);
+        COMMON::parallel_for(nChunk, [&](size_t cFirst, size_t cLast)
+        {
+            for (size_t c = cFirst; c < cLast; ++c)
+            {
+                const size_t first = nNode * c / nChunk, last = nNode * (c + 1) / nChunk;
+                auto &dst = chunkMatch[c];
+                std::vector<DETECT_MATCH> cur;
+                for (size_t n = first; n < last; ++n)
+                {
+                    size_t m1, pri1, sec1;
+                    locate(n, m1, pri1, sec1);
+                    const auto &s1 = surf[m1];
+                    const auto b1 = grid.block(s1.blk);
+                    size_t i1, j1, k1;
+                    detect_surface_node(s1.surf, pri1, sec1, b1->nI(), b1->nJ(), b1->nK(), i1, j1, k1);
+
+                    cur.clear();
+                    hash.query(coord[n], [&](size_t x)
+                    {
+                        size_t m2, pri2, sec2;
+                        locate(x, m2, pri2, sec2);
+                        if (m2 == m1)
+                            return;
+
+                        const auto &s2 = surf[m2];
+                        if (s2.blk == s1.blk)
+                        {
+                            size_t i2, j2, k2;
+                            detect_surface_node(s2.surf, pri2, sec2, b1->nI(), b1->nJ(), b1->nK(), i2, j2, k2);
+                            if (i1 == i2 && j1 == j2 && k1 == k2)
+                                return;
+                        }
+                        cur.push_back({ m2, static_cast<long long>(pri2), static_cast<long long>(sec2) });
+                    });
+                    std::sort(cur.begin(), cur.end(), [](const DETECT_MATCH &a, const DETECT_MATCH &b)
+                    {
+                        return std::tie(a.surf, a.sec, a.pri) < std::tie(b.surf, b.sec, b.pri);
+                    });
+                    for (const auto &e : cur)
+                        dst.emplace_back(n, e);
+                }
+            }
+        });
+
+        std::vector<size_t> matchStart(nNode + 1, 0);
+        std::vector<DETECT_MATCH> match;
+        for (const auto &c : chunkMatch)
+            for (const auto &e : c)
+            {
+                ++matchStart[e.first + 1];
+                match.push_back(e.second);
+            }
+        std::vector<std::vector<std::pair<size_t, DETECT_MATCH>>>().swap(chunkMatch);
+        for (size_t n = 1; n <= nNode; ++n)
+            matchStart[n] += matchStart[n - 1];
+
+        /// Each cell on a surface is matched to a cell on another surface if all of
+        /// its 4 corners are coincident with those of the other one.
+        /// Cells sharing the same map are then gathered into rectangular patches.
+        std::vector<std::vector<DETECT_MAP>> surfMap(surf.size());
+        std::vector<std::vector<DETECT_PATCH>> surfPatch(surf.size());
+        COMMON::parallel_for(surf.size(), [&](size_t first, size_t last)
+        {
+            for (size_t m = first; m < last; ++m)
+            {
+                const auto &s1 = surf[m];
+                auto &mp = surfMap[m];
+                const size_t nPriCell = s1.nPri - 1, nSecCell = s1.nSec - 1;
+                std::vector<int> cellMap(nPriCell * nSecCell, -1);
+
+                auto node = [&](size_t pri, size_t sec) { return s1.offset + (pri - 1) + s1.nPri * (sec - 1); };
+                auto find = [&](size_t n, size_t m2, long long pri, long long sec)
+                {
+                    for (size_t l = matchStart[n]; l < matchStart[n + 1]; ++l)
+                        if (match[l].surf == m2 && match[l].pri == pri && match[l].sec == sec)
+                            return true;
+                    return false;
+                };
+
+                for (size_t sec = 1; sec <= nSecCell; ++sec)
+                    for (size_t pri = 1; pri <= nPriCell; ++pri)
+                    {
+                        const size_t n00 = node(pri, sec), n10 = node(pri + 1, sec);
+                        const size_t n01 = node(pri, sec + 1), n11 = node(pri + 1, sec + 1);
+
+                        bool found = false;
+                        DETECT_MAP cur;
+                        for (size_t l0 = matchStart[n00]; l0 < matchStart[n00 + 1] && !found; ++l0)
+                        {
+                            const auto &c0 = match[l0];
+                            for (size_t l1 = matchStart[n10]; l1 < matchStart[n10 + 1] && !found; ++l1)
+                            {
+                                const auto &c1 = match[l1];
+                                const long long dp[2] = { c1.pri - c0.pri, c1.sec - c0.sec };
+                                if (c1.surf != c0.surf || std::abs(dp[0]) + std::abs(dp[1]) != 1)
+                                    continue;
+
+                                for (size_t l3 = matchStart[n01]; l3 < matchStart[n01 + 1] && !found; ++l3)
+                                {
+                                    const auto &c3 = match[l3];
+                                    const long long ds[2] = { c3.pri - c0.pri, c3.sec - c0.sec };
+                                    if (c3.surf != c0.surf || std::abs(ds[0]) + std::abs(ds[1]) != 1 || dp[0] * ds[0] + dp[1] * ds[1] != 0)
+                                        continue;
+                                    if (!find(n11, c0.surf, c0.pri + dp[0] + ds[0], c0.sec + dp[1] + ds[1]))
+                                        continue;
+
+                                    found = true;
+                                    cur.surf = c0.surf;
+                                    for (short d = 0; d < 2; ++d)
+                                    {
+                                        cur.dPri[d] = dp[d];
+                                        cur.dSec[d] = ds[d];
+                                    }
+                                    cur.offset[0] = c0.pri - static_cast<long long>(pri) * dp[0] - static_cast<long long>(sec) * ds[0];
+                                    cur.offset[1] = c0.sec - static_cast<long long>(pri) * dp[1] - static_cast<long long>(sec) * ds[1];
+                                }
+                            }
+                        }
+                        if (!found)
+                            continue;
+
+                        auto it = std::find(mp.begin(), mp.end(), cur);
+                        cellMap[(pri - 1) + nPriCell * (sec - 1)] = static_cast<int>(it - mp.begin());
+                        if (it == mp.end())
+                            mp.push_back(cur);
+                    }
+
+                /// Greedy decomposition, each patch is extended along "pri" first, then "sec".
+                std::vector<bool> taken(cellMap.size(), false);
+                auto available = [&](size_t pri, size_t sec, int g)
+                {
+                    const size_t loc = (pri - 1) + nPriCell * (sec - 1);
+                    return !taken[loc] && cellMap[loc] == g;
+                };
+                for (size_t sec = 1; sec <= nSecCell; ++sec)
+                    for (size_t pri = 1; pri <= nPriCell; ++pri)
+                    {
+                        if (taken[(pri - 1) + nPriCell * (sec - 1)])
+                            continue;
+
+                        DETECT_PATCH p;
+                        p.map = cellMap[(pri - 1) + nPriCell * (sec - 1)];
+                        p.pri0 = p.pri1 = pri;
+                        p.sec0 = p.sec1 = sec;
+                        while (p.pri1 < nPriCell && available(p.pri1 + 1, sec, p.map))
+                            ++p.pri1;
+                        while (p.sec1 < nSecCell)
+                        {
+                            bool ok = true;
+                            for (size_t l = p.pri0; l <= p.pri1 && ok; ++l)
+                                ok = available(l, p.sec1 + 1, p.map);
+                            if (!ok)
+                                break;
+                            ++p.sec1;
+                        }
+                        for (size_t ss = p.sec0; ss <= p.sec1; ++ss)
+                            for (size_t pp = p.pri0; pp <= p.pri1; ++pp)
+                                taken[(pp - 1) + nPriCell * (ss - 1)] = true;
+                        surfPatch[m].push_back(p);
+                    }
+            }
+        });
+
+        /// Each interface is recorded on the surface that comes first.
+        std::vector<Block3D*> blk(NumOfBlk, nullptr);
+        std::vector<ENTRY*> entry;
+        try
+        {
+            for (size_t n = 0; n < NumOfBlk; ++n)
+            {
+                const auto b = grid.block(n);
+                blk[n] = new Block3D(b->nI(), b->nJ(), b->nK());
+                blk[n]->index() = n + 1;
+            }
+
+            for (size_t m = 0; m < surf.size(); ++m)
+            {
+                const auto &s1 = surf[m];
+                for (const auto &p : surfPatch[m])
+                {
+                    if (p.map < 0)
+                    {
+                        entry.push_back(new SingleSideEntry(bc, s1.blk + 1, s1.surf, p.pri0, p.pri1 + 1, p.sec0, p.sec1 + 1));
+                        continue;
+                    }
+
+                    const auto &mp = surfMap[m][p.map];
+                    if (mp.surf < m)
+                        continue;
+
+                    /// "Swap" when the primary direction goes along the secondary one of the counterpart.
+                    const bool swp = mp.dPri[0] == 0;
+                    long long a[2], bp[2], bs[2];
+                    mp.apply(p.pri0, p.sec0, a[0], a[1]);
+                    mp.apply(p.pri1 + 1, p.sec0, bp[0], bp[1]);
+                    mp.apply(p.pri0, p.sec1 + 1, bs[0], bs[1]);
+
+                    const auto &s2 = surf[mp.surf];
+                    if (swp)
+                        entry.push_back(new DoubleSideEntry(BC::idx2str(BC::ONE_TO_ONE), s1.blk + 1, s1.surf, p.pri0, p.pri1 + 1, p.sec0, p.sec1 + 1, s2.blk + 1, s2.surf, a[0], bs[0], a[1], bp[1], true));
+                    else
+                        entry.push_back(new DoubleSideEntry(BC::idx2str(BC::ONE_TO_ONE), s1.blk + 1, s1.surf, p.pri0, p.pri1 + 1, p.sec0, p.sec1 + 1, s2.blk + 1, s2.surf, a[0], bp[0], a[1], bs[1], false));
+                }
+            }
+        }
+        catch (...)
+        {
+            for (auto e : blk)
+                delete e;
+            for (auto e : entry)
+                delete e;
+            throw;
+        }
+
+        release_all();
+        m_blk.assign(blk.begin(), blk.end());
+        m_entry.assign(entry.begin(), entry.end());
+    }
+}
@@ -1,3 +1,8 @@
+#include <memory>
+#include <charconv>
+#include <filesystem>
+#include <atomic>
+#include <sstream>
 #include "../inc/nmf.h"
 #include "../inc/plot3d.h"
 #include "../inc/xf.h"
@@ -13,488 +18,439 @@ static std::string version_str()
 
 namespace GridTool::XF
 {
-    MESH::MESH(const std::string &f_nmf, const std::string &f_p3d, std::ostream &fout) :
-        DIM(3),
-        m_totalNodeNum(0),
-        m_totalCellNum(0),
-        m_totalFaceNum(0),
-        m_totalZoneNum(0)
+    /// Nodes of each face within a hex cell, in "NMF::Block3D" convention.
+    /// Following the right-hand convention, the normal points outward.
+    static const short HEX_FACE_NODE[NMF::Block3D::NumOfSurf][4] = {
+        { 1, 5, 8, 4 }, { 2, 3, 7, 6 }, /// K-MIN, K-MAX
+        { 1, 2, 6, 5 }, { 4, 8, 7, 3 }, /// I-MIN, I-MAX
+        { 1, 4, 3, 2 }, { 5, 6, 7, 8 }  /// J-MIN, J-MAX
+    };
+
+    /// A slab of cells with "kFirst <= k <= kLast" within a block.
+    struct GLUE_TASK
     {
-        /// Load mapping file.
-        auto nmf = new NMF::Mapping3D(f_nmf);
-        nmf->compute_topology();
-        nmf->numbering();
-
-        /// Load grid file.
-        auto p3d = new PLOT3D::GRID(f_p3d);
-
-        /// Check consistency.
-        const size_t NBLK = nmf->nBlock();
-        if (NBLK != p3d->numOfBlock())
-            throw std::invalid_argument("Inconsistent num of blocks between NMF and PLOT3D.");
-        for (size_t n = 1; n <= NBLK; ++n)
+        size_t blk;
+        size_t kFirst, kLast;
+    };
+
+    /// Faces are re-ordered such that internal faces come first,
+    /// followed by boundary faces of each single-sided surface in
+    /// the order of blocks.
+    /// Within each block, faces are numbered by NMF as internal ones
+    /// followed by those on single-sided surfaces, and faces on
+    /// double-sided surfaces are numbered after all blocks.
+    struct GLUE_FACE_ORDER
+    {
+        size_t nBlk;
+        size_t innerFaceNum;
+        std::vector<size_t> oldFaceBase, blkInnerFaceNum, newInnerFaceBase, newBdryFaceBase;
+
+        explicit GLUE_FACE_ORDER(const NMF::Mapping3D &nmf) :
+            nBlk(nmf.nBlock()),
+            innerFaceNum(0),
+            oldFaceBase(nBlk + 1, 0),
+            blkInnerFaceNum(nBlk, 0),
+            newInnerFaceBase(nBlk + 1, 0),
+            newBdryFaceBase(nBlk + 1, 0)
         {
-            const auto &b = nmf->block(n);
-            auto g = p3d->block(n - 1);
-            if (b.IDIM() != g->nI())
-                throw std::invalid_argument("Inconsistent num of nodes in I dimension of Block " + std::to_string(n) + ".");
-            if (b.JDIM() != g->nJ())
-                throw std::invalid_argument("Inconsistent num of nodes in J dimension of Block " + std::to_string(n) + ".");
-            if (b.KDIM() != g->nK())
-                throw std::invalid_argument("Inconsistent num of nodes in K dimension of Block " + std::to_string(n) + ".");
+            for (size_t n = 0; n < nBlk; ++n)
+            {
+                const auto &b = nmf.block(n + 1);
+                size_t cnt = 0;
+                for (short s = 1; s <= NMF::Block3D::NumOfSurf; ++s)
+                    if (!b.surf(s).neighbourSurf)
+                        cnt += b.surface_face_num(s);
+
+                blkInnerFaceNum[n] = b.face_num() - b.shell_face_num();
+                oldFaceBase[n + 1] = oldFaceBase[n] + blkInnerFaceNum[n] + cnt;
+                newInnerFaceBase[n + 1] = newInnerFaceBase[n] + blkInnerFaceNum[n];
+                newBdryFaceBase[n + 1] = newBdryFaceBase[n] + cnt;
+            }
+
+            size_t totalFaceNum = 0, bdryFaceNum = 0;
+            nmf.nFace(totalFaceNum, innerFaceNum, bdryFaceNum);
+            if (newInnerFaceBase[nBlk] + (totalFaceNum - oldFaceBase[nBlk]) != innerFaceNum || newBdryFaceBase[nBlk] != bdryFaceNum)
+                throw std::runtime_error("Inconsistent num of faces between blocks and the whole.");
         }
 
-        /// Allocate storage.
-        m_totalNodeNum = nmf->nNode();
-        m_totalCellNum = nmf->nCell();
-        size_t innerFaceNum = 0, bdryFaceNum = 0;
-        nmf->nFace(m_totalFaceNum, innerFaceNum, bdryFaceNum);
-        m_node.resize(numOfNode());
-        m_face.resize(numOfFace());
-        m_cell.resize(numOfCell());
+        /// 0-based offset of the 1st face on double-sided surfaces, in NMF and mesh respectively.
+        size_t oldDoubleSidedBase() const { return oldFaceBase[nBlk]; }
+        size_t newDoubleSidedBase() const { return newInnerFaceBase[nBlk]; }
 
-        /// Copy node info.
-        std::vector<bool> visited(m_node.size(), false);
-        for (size_t n = 1; n <= NBLK; ++n)
+        /// From 1-based NMF face index to 1-based mesh face index.
+        /// "n" is the 0-based index of the block where the face is found.
+        size_t operator()(size_t n, size_t idx) const
         {
-            auto &b = nmf->block(n);
-            auto &g = *p3d->block(n - 1);
-
-            const size_t nI = b.IDIM();
-            const size_t nJ = b.JDIM();
-            const size_t nK = b.KDIM();
-
-            for (size_t k = 1; k <= nK; ++k)
-                for (size_t j = 1; j <= nJ; ++j)
-                    for (size_t i = 1; i <= nI; ++i)
-                    {
-                        /// Global 1-based index, already assigned.
-                        const auto idx = b.node_index(i, j, k);
-
-                        if (!visited[idx - 1])
-                        {
-                            node(idx).coordinate = g(i, j, k);
-                            visited[idx - 1] = true;
-                        }
-                    }
+            const size_t loc = idx - 1;
+            if (loc >= oldDoubleSidedBase())
+                return newDoubleSidedBase() + (loc - oldDoubleSidedBase()) + 1;
+            if (loc < oldFaceBase[n] || loc >= oldFaceBase[n + 1])
+                throw std::runtime_error("Face " + std::to_string(idx) + " does not belong to Block " + std::to_string(n + 1) + ".");
+
+            const size_t l = loc - oldFaceBase[n];
+            if (l < blkInnerFaceNum[n])
+                return newInnerFaceBase[n] + l + 1;
+            else
+                return innerFaceNum + newBdryFaceBase[n] + (l - blkInnerFaceNum[n]) + 1;
         }
+    };
 
-        /// Copy cell info.
-        for (size_t n = 1; n <= NBLK; ++n)
+    /// Whether face "r" of cell (i, j, k) is on the surface of the block.
+    /// If not, the adjacent cell on the other side is given by (ii, jj, kk).
+    static bool hex_face_on_surf(const NMF::Block3D &b, size_t i, size_t j, size_t k, short r, size_t &ii, size_t &jj, size_t &kk)
+    {
+        ii = i;
+        jj = j;
+        kk = k;
+        switch (r)
         {
-            auto &b = nmf->block(n);
-
-            const size_t nI = b.IDIM();
-            const size_t nJ = b.JDIM();
-            const size_t nK = b.KDIM();
-
-            for (size_t k = 1; k < nK; ++k)
-                for (size_t j = 1; j < nJ; ++j)
-                    for (size_t i = 1; i < nI; ++i)
-                    {
-                        const auto &nc = b.cell(i, j, k);
-                        const auto idx = nc.CellSeq();
-                        auto &fc = cell(idx);
-
-                        fc.type = CELL::HEXAHEDRAL;
-
-                        fc.includedFace.resize(NMF::Block3D::NumOfSurf);
-                        for (short r = 1; r <= NMF::Block3D::NumOfSurf; ++r)
-                            fc.includedFace(r) = nc.FaceSeq(r);
-
-                        fc.includedNode.resize(NMF::Block3D::NumOfVertex);
-                        for (short r = 1; r <= NMF::Block3D::NumOfVertex; ++r)
-                            fc.includedNode(r) = nc.NodeSeq(r);
-                    }
+        case 1:
+            --kk;
+            return k == 1;
+        case 2:
+            ++kk;
+            return k == b.KDIM() - 1;
+        case 3:
+            --ii;
+            return i == 1;
+        case 4:
+            ++ii;
+            return i == b.IDIM() - 1;
+        case 5:
+            --jj;
+            return j == 1;
+        default:
+            ++jj;
+            return j == b.JDIM() - 1;
         }
+    }
 
-        /// Copy face info.
-        visited.resize(m_face.size(), false);
-        std::fill(visited.begin(), visited.end(), false);
-        for (size_t n = 1; n <= NBLK; ++n)
-        {
-            auto &b = nmf->block(n);
-
-            const size_t nI = b.IDIM();
-            const size_t nJ = b.JDIM();
-            const size_t nK = b.KDIM();
-
-            /// Internal I direction
-            for (size_t k = 1; k < nK; ++k)
-                for (size_t j = 1; j < nJ; ++j)
-                    for (size_t i = 2; i < nI; ++i)
-                    {
-                        const auto &curCell = b.cell(i, j, k);
-                        const auto &adjCell = b.cell(i - 1, j, k);
-
-                        const auto faceIndex = curCell.FaceSeq(1);
-                        auto &curFace = face(faceIndex);
-
-                        curFace.atBdry = false;
-
-                        curFace.type = FACE::QUADRILATERAL;
-
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(1);
-                        curFace.includedNode(2) = curCell.NodeSeq(5);
-                        curFace.includedNode(3) = curCell.NodeSeq(8);
-                        curFace.includedNode(4) = curCell.NodeSeq(4);
-
-                        curFace.leftCell = adjCell.CellSeq();
-                        curFace.rightCell = curCell.CellSeq();
-
-                        visited[faceIndex - 1] = true;
-                    }
-
-            /// Internal J direction
-            for (size_t k = 1; k < nK; ++k)
-                for (size_t i = 1; i < nI; ++i)
-                    for (size_t j = 2; j < nJ; ++j)
-                    {
-                        const auto &curCell = b.cell(i, j, k);
-                        const auto &adjCell = b.cell(i, j - 1, k);
-
-                        const auto faceIndex = curCell.FaceSeq(3);
-                        auto &curFace = face(faceIndex);
-
-                        curFace.atBdry = false;
-
-                        curFace.type = FACE::QUADRILATERAL;
-
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(6);
-                        curFace.includedNode(2) = curCell.NodeSeq(5);
-                        curFace.includedNode(3) = curCell.NodeSeq(1);
-                        curFace.includedNode(4) = curCell.NodeSeq(2);
-
-                        curFace.leftCell = adjCell.CellSeq();
-                        curFace.rightCell = curCell.CellSeq();
-
-                        visited[faceIndex - 1] = true;
-                    }
-
-            /// Internal k direction
-            for (size_t i = 1; i < nI; ++i)
-                for (size_t j = 1; j < nJ; ++j)
-                    for (size_t k = 2; k < nK; ++k)
-                    {
-                        const auto &curCell = b.cell(i, j, k);
-                        const auto &adjCell = b.cell(i, j, k - 1);
+    /// On a double-sided surface, the side with smaller (block, surface) index
+    /// takes the left, and determines the order of nodes.
+    static bool double_sided_left(const NMF::Block3D &b, short r)
+    {
+        const auto nb = b.surf(r).neighbourSurf;
+        const size_t nbBlk = nb->dependentBlock->index();
+        return b.index() < nbBlk || (b.index() == nbBlk && r < nb->local_index);
+    }
 
-                        const auto faceIndex = curCell.FaceSeq(5);
-                        auto &curFace = face(faceIndex);
+    /// Nodes of face "r" of a cell, the normal points outward,
+    /// or inward when "reversed" is set.
+    static void hex_face_node(const NMF::Block3D::CONST_CELL_REF &c, short r, bool reversed, size_t *dst)
+    {
+        const auto &fn = HEX_FACE_NODE[r - 1];
+        for (short q = 0; q < 4; ++q)
+            dst[q] = c.NodeSeq(fn[reversed ? 3 - q : q]);
+    }
 
-                        curFace.atBdry = false;
+    /// Zone of each single-sided surface is named after the block and the surface.
+    static std::string boundary_zone_name(size_t blk, short surf)
+    {
+        return "B" + std::to_string(blk) + "F" + std::to_string(surf);
+    }
 
-                        curFace.type = FACE::QUADRILATERAL;
+    /// Nodal coordinates of blocks to be glued.
+    /// "n" is 0-based, while (i, j, k) are 1-based as in "PLOT3D::BLK".
+    struct GLUE_SOURCE
+    {
+        virtual ~GLUE_SOURCE() = default;
 
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(4);
-                        curFace.includedNode(2) = curCell.NodeSeq(3);
-                        curFace.includedNode(3) = curCell.NodeSeq(2);
-                        curFace.includedNode(4) = curCell.NodeSeq(1);
+        virtual size_t numOfBlock() const = 0;
 
-                        curFace.leftCell = adjCell.CellSeq();
-                        curFace.rightCell = curCell.CellSeq();
+        /// Num of nodes in I, J and K dimension.
+        virtual std::array<size_t, 3> dimension(size_t n) const = 0;
 
-                        visited[faceIndex - 1] = true;
-                    }
+        virtual Vector operator()(size_t n, size_t i, size_t j, size_t k) const = 0;
+    };
 
-            /// I-MIN
-            for (size_t k = 1; k < nK; ++k)
-                for (size_t j = 1; j < nJ; ++j)
-                {
-                    const auto &curCell = b.cell(1, j, k);
-                    const auto faceIndex = curCell.FaceSeq(1);
-                    auto &curFace = face(faceIndex);
-                    const auto &curSurf = b.surf(1);
+    struct GLUE_GRID_SOURCE : public GLUE_SOURCE
+    {
+        const PLOT3D::GRID &grid;
 
-                    if (visited[faceIndex - 1])
-                    {
-                        if (!curFace.atBdry)
-                        {
-                            /// Second-Round of Double-Sided Case
-                            /// Update undetermined cell index.
-                            if (curFace.leftCell == 0)
-                                curFace.leftCell = curCell.CellSeq();
-                            else if (curFace.rightCell == 0)
-                                curFace.rightCell = curCell.CellSeq();
-                            else
-                                throw std::runtime_error("Double-Sided face should not appear more than twice!");
-                        }
-                        else
-                            throw std::runtime_error("Boundary face shouldn't appear twice!");
-                    }
-                    else
-                    {
-                        curFace.type = FACE::QUADRILATERAL;
+        explicit GLUE_GRID_SOURCE(const PLOT3D::GRID &g) : grid(g) {}
 
-                        curFace.atBdry = !curSurf.neighbourSurf;
+        size_t numOfBlock() const override { return grid.numOfBlock(); }
 
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(1);
-                        curFace.includedNode(2) = curCell.NodeSeq(5);
-                        curFace.includedNode(3) = curCell.NodeSeq(8);
-                        curFace.includedNode(4) = curCell.NodeSeq(4);
+        std::array<size_t, 3> dimension(size_t n) const override
+        {
+            const auto g = grid.block(n);
+            return { g->nI(), g->nJ(), g->nK() };
+        }
 
-                        /// On I-MIN Surface, if current face is Single-Sided,
-                        /// then index of left cell is set to 0 according to
-                        /// right-hand convention; If current face is Double-Sided,
-                        /// it is also set to 0 at this stage, and will be
-                        /// updated further by loops of other blocks.
-                        curFace.leftCell = 0;
-                        curFace.rightCell = curCell.CellSeq();
+        Vector operator()(size_t n, size_t i, size_t j, size_t k) const override
+        {
+            return grid.block(n)->at(i - 1, j - 1, k - 1);
+        }
+    };
 
-                        visited[faceIndex - 1] = true;
-                    }
-                }
+    /// Dimensions are given by NMF.
+    struct GLUE_SPAN_SOURCE : public GLUE_SOURCE
+    {
+        const NMF::Mapping3D &nmf;
+        const std::vector<MESH::COORD_SPAN> &coord;
 
-            /// I-MAX
-            for (size_t k = 1; k < nK; ++k)
-                for (size_t j = 1; j < nJ; ++j)
-                {
-                    const auto &curCell = b.cell(nI - 1, j, k);
-                    const auto faceIndex = curCell.FaceSeq(2);
-                    auto &curFace = face(faceIndex);
-                    const auto &curSurf = b.surf(2);
+        GLUE_SPAN_SOURCE(const NMF::Mapping3D &m, const std::vector<MESH::COORD_SPAN> &c) :
+            nmf(m),
+            coord(c)
+        {
+            for (size_t n = 0; n < std::min(coord.size(), nmf.nBlock()); ++n)
+            {
+                const auto &b = nmf.block(n + 1);
+                if (coord[n].first == nullptr || coord[n].second != 3 * b.IDIM() * b.JDIM() * b.KDIM())
+                    throw std::invalid_argument("Inconsistent num of coordinates of Block " + std::to_string(n + 1) + ".");
+            }
+        }
 
-                    if (visited[faceIndex - 1])
-                    {
-                        if (!curFace.atBdry)
-                        {
-                            /// Second-Round of Double-Sided Case
-                            /// Update undetermined cell index.
-                            if (curFace.leftCell == 0)
-                                curFace.leftCell = curCell.CellSeq();
-                            else if (curFace.rightCell == 0)
-                                curFace.rightCell = curCell.CellSeq();
-                            else
-                                throw std::runtime_error("Double-Sided face should not appear more than twice!");
-                        }
-                        else
-                            throw std::runtime_error("Boundary face shouldn't appear twice!");
-                    }
-                    else
-                    {
-                        curFace.type = FACE::QUADRILATERAL;
+        size_t numOfBlock() const override { return coord.size(); }
 
-                        curFace.atBdry = !curSurf.neighbourSurf;
+        std::array<size_t, 3> dimension(size_t n) const override
+        {
+            const auto &b = nmf.block(n + 1);
+            return { b.IDIM(), b.JDIM(), b.KDIM() };
+        }
 
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(2);
-                        curFace.includedNode(2) = curCell.NodeSeq(3);
-                        curFace.includedNode(3) = curCell.NodeSeq(7);
-                        curFace.includedNode(4) = curCell.NodeSeq(6);
+        Vector operator()(size_t n, size_t i, size_t j, size_t k) const override
+        {
+            const auto &b = nmf.block(n + 1);
+            const size_t N = coord[n].second / 3;
+            const size_t loc = (i - 1) + b.IDIM() * ((j - 1) + b.JDIM() * (k - 1));
+            const double *p = coord[n].first;
+            return { p[loc], p[N + loc], p[2 * N + loc] };
+        }
+    };
 
-                        /// On I-MAX Surface, if current face is Single-Sided,
-                        /// then index of left cell is set to 0 according to
-                        /// right-hand convention; If current face is Double-Sided,
-                        /// it is also set to 0 at this stage, and will be
-                        /// updated further by loops of other blocks.
-                        curFace.leftCell = 0;
-                        curFace.rightCell = curCell.CellSeq();
+    MESH::MESH(const std::string &f_nmf, const std::string &f_p3d, std::ostream &fout) :
+        DIM(3),
+        m_totalNodeNum(0),
+        m_totalCellNum(0),
+        m_totalFaceNum(0),
+        m_totalZoneNum(0)
+    {
+        /// Load mapping file.
+        /// Topology has been computed on construction.
+        NMF::Mapping3D nmf(f_nmf);
+        nmf.numbering();
 
-                        visited[faceIndex - 1] = true;
-                    }
-                }
+        /// Load grid file.
+        const PLOT3D::GRID p3d(f_p3d);
 
-            /// J-MIN
-            for (size_t k = 1; k < nK; ++k)
-                for (size_t i = 1; i < nI; ++i)
-                {
-                    const auto &curCell = b.cell(i, 1, k);
-                    const auto faceIndex = curCell.FaceSeq(3);
-                    auto &curFace = face(faceIndex);
-                    const auto &curSurf = b.surf(3);
+        glue(nmf, GLUE_GRID_SOURCE(p3d), fout);
+    }
 
-                    if (visited[faceIndex - 1])
-                    {
-                        if (!curFace.atBdry)
-                        {
-                            /// Second-Round of Double-Sided Case
-                            /// Update undetermined cell index.
-                            if (curFace.leftCell == 0)
-                                curFace.leftCell = curCell.CellSeq();
-                            else if (curFace.rightCell == 0)
-                                curFace.rightCell = curCell.CellSeq();
-                            else
-                                throw std::runtime_error("Double-Sided face should not appear more than twice!");
-                        }
-                        else
-                            throw std::runtime_error("Boundary face shouldn't appear twice!");
-                    }
-                    else
-                    {
-                        curFace.type = FACE::QUADRILATERAL;
+    MESH::MESH(const NMF::Mapping3D &nmf, const PLOT3D::GRID &p3d, std::ostream &fout) :
+        DIM(3),
+        m_totalNodeNum(0),
+        m_totalCellNum(0),
+        m_totalFaceNum(0),
+        m_totalZoneNum(0)
+    {
+        glue(nmf, GLUE_GRID_SOURCE(p3d), fout);
+    }
 
-                        curFace.atBdry = !curSurf.neighbourSurf;
+    MESH::MESH(const NMF::Mapping3D &nmf, const std::vector<COORD_SPAN> &coord, std::ostream &fout) :
+        DIM(3),
+        m_totalNodeNum(0),
+        m_totalCellNum(0),
+        m_totalFaceNum(0),
+        m_totalZoneNum(0)
+    {
+        glue(nmf, GLUE_SPAN_SOURCE(nmf, coord), fout);
+    }
 
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(6);
-                        curFace.includedNode(2) = curCell.NodeSeq(5);
-                        curFace.includedNode(3) = curCell.NodeSeq(1);
-                        curFace.includedNode(4) = curCell.NodeSeq(2);
+    void MESH::glue(const NMF::Mapping3D &nmf, const GLUE_SOURCE &p3d, std::ostream &fout)
+    {
+        /// Check consistency.
+        const size_t NBLK = nmf.nBlock();
+        if (NBLK != p3d.numOfBlock())
+            throw std::invalid_argument("Inconsistent num of blocks between NMF and PLOT3D.");
+        if (!nmf.numbered())
+            throw std::invalid_argument("NMF has not been numbered.");
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = nmf.block(n);
+            const auto d = p3d.dimension(n - 1);
+            if (b.IDIM() != d[0])
+                throw std::invalid_argument("Inconsistent num of nodes in I dimension of Block " + std::to_string(n) + ".");
+            if (b.JDIM() != d[1])
+                throw std::invalid_argument("Inconsistent num of nodes in J dimension of Block " + std::to_string(n) + ".");
+            if (b.KDIM() != d[2])
+                throw std::invalid_argument("Inconsistent num of nodes in K dimension of Block " + std::to_string(n) + ".");
+        }
 
-                        /// On J-MIN Surface, if current face is Single-Sided,
-                        /// then index of left cell is set to 0 according to
-                        /// right-hand convention; If current face is Double-Sided,
-                        /// it is also set to 0 at this stage, and will be
-                        /// updated further by loops of other blocks.
-                        curFace.leftCell = 0;
-                        curFace.rightCell = curCell.CellSeq();
+        /// Allocate storage.
+        m_totalNodeNum = nmf.nNode();
+        m_totalCellNum = nmf.nCell();
+        size_t innerFaceNum = 0, bdryFaceNum = 0;
+        nmf.nFace(m_totalFaceNum, innerFaceNum, bdryFaceNum);
+        m_node.resize(numOfNode());
+        m_face.resize(numOfFace());
+        m_cell.resize(numOfCell());
 
-                        visited[faceIndex - 1] = true;
-                    }
-                }
+        const GLUE_FACE_ORDER renumber_face(nmf);
+        if (renumber_face.innerFaceNum != innerFaceNum)
+            throw std::runtime_error("Inconsistent num of internal faces.");
 
-            /// J-MAX
-            for (size_t k = 1; k < nK; ++k)
-                for (size_t i = 1; i < nI; ++i)
-                {
-                    const auto &curCell = b.cell(i, nJ - 1, k);
-                    const auto faceIndex = curCell.FaceSeq(4);
-                    auto &curFace = face(faceIndex);
-                    const auto &curSurf = b.surf(4);
+        /// Split blocks into slabs along K, so that large blocks are
+        /// shared among threads, and small ones are processed as a whole.
+        std::vector<GLUE_TASK> task;
+        const size_t slabCellNum = std::max<size_t>(1, numOfCell() / (4 * COMMON::num_of_thread()));
+        for (size_t n = 0; n < NBLK; ++n)
+        {
+            const auto &b = nmf.block(n + 1);
+            const size_t nK = b.KDIM() - 1;
+            const size_t sliceCellNum = (b.IDIM() - 1) * (b.JDIM() - 1);
+            const size_t nSlab = std::min(nK, std::max<size_t>(1, b.cell_num() / slabCellNum));
+            for (size_t m = 0; m < nSlab; ++m)
+            {
+                const size_t kFirst = m * nK / nSlab + 1;
+                const size_t kLast = (m + 1) * nK / nSlab;
+                if (sliceCellNum > 0 && kFirst <= kLast)
+                    task.push_back({ n, kFirst, kLast });
+            }
+        }
 
-                    if (visited[faceIndex - 1])
-                    {
-                        if (!curFace.atBdry)
-                        {
-                            /// Second-Round of Double-Sided Case
-                            /// Update undetermined cell index.
-                            if (curFace.leftCell == 0)
-                                curFace.leftCell = curCell.CellSeq();
-                            else if (curFace.rightCell == 0)
-                                curFace.rightCell = curCell.CellSeq();
-                            else
-                                throw std::runtime_error("Double-Sided face should not appear more than twice!");
-                        }
-                        else
-                            throw std::runtime_error("Boundary face shouldn't appear twice!");
-                    }
-                    else
+        /// Within each slab, cells, nodes and faces owned exclusively
+        /// by the slab are assigned without synchronization:
+        ///   Internal nodes of the block;
+        ///   Faces on the MAX side of each cell inside the block;
+        ///   Boundary faces;
+        ///   Either side of faces on double-sided surfaces.
+        COMMON::parallel_for(task.size(), [&](size_t first, size_t last)
+        {
+            std::vector<size_t> nodeIndex;
+            for (size_t t = first; t < last; ++t)
+            {
+                const size_t n = task[t].blk;
+                const auto &b = nmf.block(n + 1);
+
+                const size_t nI = b.IDIM();
+                const size_t nJ = b.JDIM();
+                const size_t nK = b.KDIM();
+                const size_t kFirst = task[t].kFirst;
+                const size_t kLast = task[t].kLast;
+
+                /// Copy node info.
+                /// The last slab includes nodes at K-MAX.
+                /// Nodes on surfaces may be shared with other blocks, thus left to the end.
+                const size_t nodeKLast = kLast == nK - 1 ? nK : kLast;
+                b.node_index_map(kFirst, nodeKLast, nodeIndex);
+                for (size_t k = std::max<size_t>(kFirst, 2); k <= std::min(nodeKLast, nK - 1); ++k)
+                    for (size_t j = 2; j < nJ; ++j)
                     {
-                        curFace.type = FACE::QUADRILATERAL;
-
-                        curFace.atBdry = !curSurf.neighbourSurf;
-
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(3);
-                        curFace.includedNode(2) = curCell.NodeSeq(4);
-                        curFace.includedNode(3) = curCell.NodeSeq(8);
-                        curFace.includedNode(4) = curCell.NodeSeq(7);
-
-                        /// On J-MAX Surface, if current face is Single-Sided,
-                        /// then index of left cell is set to 0 according to
-                        /// right-hand convention; If current face is Double-Sided,
-                        /// it is also set to 0 at this stage, and will be
-                        /// updated further by loops of other blocks.
-                        curFace.leftCell = 0;
-                        curFace.rightCell = curCell.CellSeq();
-
-                        visited[faceIndex - 1] = true;
+                        const size_t *row = nodeIndex.data() + nI * ((j - 1) + nJ * (k - kFirst));
+                        for (size_t i = 2; i < nI; ++i)
+                            node(row[i - 1]).coordinate = p3d(n, i, j, k);
                     }
-                }
-
-            /// K-MIN
-            for (size_t i = 1; i < nI; ++i)
-                for (size_t j = 1; j < nJ; ++j)
-                {
-                    const auto &curCell = b.cell(i, j, 1);
-                    const auto faceIndex = curCell.FaceSeq(5);
-                    auto &curFace = face(faceIndex);
-                    const auto &curSurf = b.surf(5);
 
-                    if (visited[faceIndex - 1])
-                    {
-                        if (!curFace.atBdry)
+                /// Copy cell and face info.
+                for (size_t k = kFirst; k <= kLast; ++k)
+                    for (size_t j = 1; j < nJ; ++j)
+                        for (size_t i = 1; i < nI; ++i)
                         {
-                            /// Second-Round of Double-Sided Case
-                            /// Update undetermined cell index.
-                            if (curFace.leftCell == 0)
-                                curFace.leftCell = curCell.CellSeq();
-                            else if (curFace.rightCell == 0)
-                                curFace.rightCell = curCell.CellSeq();
-                            else
-                                throw std::runtime_error("Double-Sided face should not appear more than twice!");
+                            const auto nc = b.cell(i, j, k);
+                            const auto idx = nc.CellSeq();
+                            auto &fc = cell(idx);
+
+                            fc.type = CELL::HEXAHEDRAL;
+
+                            fc.includedNode.resize(NMF::Block3D::NumOfVertex);
+                            for (short r = 1; r <= NMF::Block3D::NumOfVertex; ++r)
+                                fc.includedNode(r) = nc.NodeSeq(r);
+
+                            fc.includedFace.resize(NMF::Block3D::NumOfSurf);
+                            for (short r = 1; r <= NMF::Block3D::NumOfSurf; ++r)
+                            {
+                                const auto faceIndex = renumber_face(n, nc.FaceSeq(r));
+                                fc.includedFace(r) = faceIndex;
+
+                                /// Neighbouring cell within the block, if any.
+                                size_t ii, jj, kk;
+                                const bool atSurf = hex_face_on_surf(b, i, j, k, r, ii, jj, kk);
+
+                                /// Internal faces are assigned from the MIN side.
+                                if (!atSurf && r % 2 == 1)
+                                    continue;
+
+                                auto &curFace = face(faceIndex);
+                                const auto nb = b.surf(r).neighbourSurf;
+
+                                if (!atSurf)
+                                {
+                                    curFace.type = FACE::QUADRILATERAL;
+                                    curFace.atBdry = false;
+                                    curFace.includedNode.resize(4);
+                                    hex_face_node(nc, r, false, curFace.includedNode.data());
+                                    curFace.leftCell = idx;
+                                    curFace.rightCell = b.cell(ii, jj, kk).CellSeq();
+                                }
+                                else if (!nb)
+                                {
+                                    /// Boundary face, right-hand convention
+                                    /// points into the only adjacent cell.
+                                    curFace.type = FACE::QUADRILATERAL;
+                                    curFace.atBdry = true;
+                                    curFace.includedNode.resize(4);
+                                    hex_face_node(nc, r, true, curFace.includedNode.data());
+                                    curFace.leftCell = 0;
+                                    curFace.rightCell = idx;
+                                }
+                                else if (double_sided_left(b, r))
+                                {
+                                    /// Double-Sided face.
+                                    /// Each side writes its own fields only.
+                                    curFace.type = FACE::QUADRILATERAL;
+                                    curFace.atBdry = false;
+                                    curFace.includedNode.resize(4);
+                                    hex_face_node(nc, r, false, curFace.includedNode.data());
+                                    curFace.leftCell = idx;
+                                }
+                                else
+                                    curFace.rightCell = idx;
+                            }
                         }
-                        else
-                            throw std::runtime_error("Boundary face shouldn't appear twice!");
-                    }
-                    else
-                    {
-                        curFace.type = FACE::QUADRILATERAL;
-
-                        curFace.atBdry = !curSurf.neighbourSurf;
-
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(4);
-                        curFace.includedNode(2) = curCell.NodeSeq(3);
-                        curFace.includedNode(3) = curCell.NodeSeq(2);
-                        curFace.includedNode(4) = curCell.NodeSeq(1);
+            }
+        });
 
-                        /// On K-MIN Surface, if current face is Single-Sided,
-                        /// then index of left cell is set to 0 according to
-                        /// right-hand convention; If current face is Double-Sided,
-                        /// it is also set to 0 at this stage, and will be
-                        /// updated further by loops of other blocks.
-                        curFace.leftCell = 0;
-                        curFace.rightCell = curCell.CellSeq();
+        /// Nodes on surfaces, coordinates are taken from the first block.
+        std::vector<bool> visited(m_node.size(), false);
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = nmf.block(n);
 
-                        visited[faceIndex - 1] = true;
-                    }
-                }
+            const size_t nI = b.IDIM();
+            const size_t nJ = b.JDIM();
+            const size_t nK = b.KDIM();
 
-            /// K-MAX
-            for (size_t i = 1; i < nI; ++i)
-                for (size_t j = 1; j < nJ; ++j)
+            for (size_t k = 1; k <= nK; ++k)
+                for (size_t j = 1; j <= nJ; ++j)
                 {
-                    const auto &curCell = b.cell(i, j, nK - 1);
-                    const auto faceIndex = curCell.FaceSeq(6);
-                    auto &curFace = face(faceIndex);
-                    const auto &curSurf = b.surf(6);
-
-                    if (visited[faceIndex - 1])
+                    const bool onShell = k == 1 || k == nK || j == 1 || j == nJ;
+                    const size_t step = onShell || nI < 2 ? 1 : nI - 1;
+                    for (size_t i = 1; i <= nI; i += step)
                     {
-                        if (!curFace.atBdry)
+                        const auto idx = b.node_index(i, j, k);
+                        if (!visited[idx - 1])
                         {
-                            /// Second-Round of Double-Sided Case
-                            /// Update undetermined cell index.
-                            if (curFace.leftCell == 0)
-                                curFace.leftCell = curCell.CellSeq();
-                            else if (curFace.rightCell == 0)
-                                curFace.rightCell = curCell.CellSeq();
-                            else
-                                throw std::runtime_error("Double-Sided face should not appear more than twice!");
+                            node(idx).coordinate = p3d(n - 1, i, j, k);
+                            visited[idx - 1] = true;
                         }
-                        else
-                            throw std::runtime_error("Boundary face shouldn't appear twice!");
-                    }
-                    else
-                    {
-                        curFace.type = FACE::QUADRILATERAL;
-
-                        curFace.atBdry = !curSurf.neighbourSurf;
-
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(8);
-                        curFace.includedNode(2) = curCell.NodeSeq(5);
-                        curFace.includedNode(3) = curCell.NodeSeq(6);
-                        curFace.includedNode(4) = curCell.NodeSeq(7);
-
-                        /// On K-MAX Surface, if current face is Single-Sided,
-                        /// then index of left cell is set to 0 according to
-                        /// right-hand convention; If current face is Double-Sided,
-                        /// it is also set to 0 at this stage, and will be
-                        /// updated further by loops of other blocks.
-                        curFace.leftCell = 0;
-                        curFace.rightCell = curCell.CellSeq();
-
-                        visited[faceIndex - 1] = true;
                     }
                 }
         }
 
+        /// Resolve faces on double-sided surfaces.
+        /// Both sides shall have been assigned.
+        COMMON::parallel_for(innerFaceNum - renumber_face.newDoubleSidedBase(), [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                const size_t idx = renumber_face.newDoubleSidedBase() + i + 1;
+                const auto &f = face(idx);
+                if (f.leftCell == 0 || f.rightCell == 0)
+                    throw std::runtime_error("Face " + std::to_string(idx) + " on double-sided surface is not shared by 2 cells.");
+            }
+        });
+
         /// Assign ZONE info.
         /// Here, only possible choice for cell is hex;
         /// only possible choice for face is quad.
@@ -508,7 +464,7 @@ namespace GridTool::XF
         m_totalZoneNum = 0;
         for (size_t i = 1; i <= NBLK; ++i)
         {
-            const auto &b = nmf->block(i);
+            const auto &b = nmf.block(i);
             for (short j = 1; j <= NMF::Block3D::NumOfSurf; ++j)
             {
                 const auto &s = b.surf(j);
@@ -548,7 +504,7 @@ namespace GridTool::XF
         size_t patch_idx = 4;
         for (size_t i = 1; i <= NBLK; ++i)
         {
-            const auto &b = nmf->block(i);
+            const auto &b = nmf.block(i);
             for (short j = 1; j <= NMF::Block3D::NumOfSurf; ++j)
             {
                 const auto &s = b.surf(j);
@@ -561,7 +517,7 @@ namespace GridTool::XF
                     /// Can be mapped according to NMF specification or assigned mannually in FLUENT.
                     z.type = "wall";
 
-                    z.name = "B" + std::to_string(i) + "F" + std::to_string(j);
+                    z.name = boundary_zone_name(i, j);
                 }
             }
         }
@@ -574,8 +530,11 @@ namespace GridTool::XF
 
         /// Nodal coordinates
         auto part1 = new NODE(1, 1, numOfNode(), NODE::ANY, 3);
-        for (size_t i = 0; i < numOfNode(); ++i)
-            part1->at(i) = node(i + 1).coordinate;
+        COMMON::parallel_for(numOfNode(), [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+                part1->at(i) = node(i + 1).coordinate;
+        });
         zone(1).obj = part1;
         add_entry(part1);
 
@@ -588,21 +547,24 @@ namespace GridTool::XF
         size_t face_pos_L = 1;
         size_t face_pos_R = face_pos_L + innerFaceNum - 1;
         auto part3 = new FACE(3, face_pos_L, face_pos_R, BC::INTERIOR, FACE::QUADRILATERAL);
-        for (size_t i = 0; i < innerFaceNum; ++i)
+        COMMON::parallel_for(innerFaceNum, [&](size_t first, size_t last)
         {
-            auto &raw_f = part3->at(i);
-            const auto &derived_f = face(i + 1);
+            for (size_t i = first; i < last; ++i)
+            {
+                auto &raw_f = part3->at(i);
+                const auto &derived_f = face(i + 1);
 
-            raw_f.x = 4;
+                raw_f.x = 4;
 
-            raw_f.n[0] = derived_f.includedNode.at(0);
-            raw_f.n[1] = derived_f.includedNode.at(1);
-            raw_f.n[2] = derived_f.includedNode.at(2);
-            raw_f.n[3] = derived_f.includedNode.at(3);
+                raw_f.n[0] = derived_f.includedNode.at(0);
+                raw_f.n[1] = derived_f.includedNode.at(1);
+                raw_f.n[2] = derived_f.includedNode.at(2);
+                raw_f.n[3] = derived_f.includedNode.at(3);
 
-            raw_f.c[0] = derived_f.rightCell;
-            raw_f.c[1] = derived_f.leftCell;
-        }
+                raw_f.c[0] = derived_f.rightCell;
+                raw_f.c[1] = derived_f.leftCell;
+            }
+        });
         zone(3).obj = part3;
         add_entry(part3);
 
@@ -610,7 +572,7 @@ namespace GridTool::XF
         patch_idx = 4;
         for (size_t i = 1; i <= NBLK; ++i)
         {
-            const auto &b = nmf->block(i);
+            const auto &b = nmf.block(i);
             for (short j = 1; j <= NMF::Block3D::NumOfSurf; ++j)
             {
                 const auto &s = b.surf(j);
@@ -622,21 +584,24 @@ namespace GridTool::XF
                     face_pos_R = face_pos_L + cfn - 1;
 
                     auto part_bfi = new FACE(patch_idx, face_pos_L, face_pos_R, BC::WALL, FACE::QUADRILATERAL);
-                    for (size_t k = 0; k < cfn; ++k)
+                    COMMON::parallel_for(cfn, [&](size_t first, size_t last)
                     {
-                        auto &raw_f = part_bfi->at(k);
-                        const auto &derived_f = face(k + face_pos_L);
+                        for (size_t k = first; k < last; ++k)
+                        {
+                            auto &raw_f = part_bfi->at(k);
+                            const auto &derived_f = face(k + face_pos_L);
 
-                        raw_f.x = 4;
+                            raw_f.x = 4;
 
-                        raw_f.n[0] = derived_f.includedNode.at(0);
-                        raw_f.n[1] = derived_f.includedNode.at(1);
-                        raw_f.n[2] = derived_f.includedNode.at(2);
-                        raw_f.n[3] = derived_f.includedNode.at(3);
+                            raw_f.n[0] = derived_f.includedNode.at(0);
+                            raw_f.n[1] = derived_f.includedNode.at(1);
+                            raw_f.n[2] = derived_f.includedNode.at(2);
+                            raw_f.n[3] = derived_f.includedNode.at(3);
 
-                        raw_f.c[0] = derived_f.rightCell;
-                        raw_f.c[1] = derived_f.leftCell;
-                    }
+                            raw_f.c[0] = derived_f.rightCell;
+                            raw_f.c[1] = derived_f.leftCell;
+                        }
+                    });
 
                     zone(patch_idx).obj = part_bfi;
                     ++patch_idx;
@@ -661,8 +626,576 @@ namespace GridTool::XF
             add_entry(raw_z);
         }
 
-        /// Finalize.
-        delete nmf;
-        delete p3d;
+        /// Same derivation as reading from file.
+        fout << "Converting into high-level representation ... ";
+        raw2derived();
+        fout << "Done!" << std::endl;
+    }
+
+    /// Header and declarations of the glued mesh.
+    static void glue_write_declaration(const NMF::Mapping3D &nmf, std::ostream &fout)
+    {
+        size_t totalFaceNum = 0, innerFaceNum = 0, bdryFaceNum = 0;
+        nmf.nFace(totalFaceNum, innerFaceNum, bdryFaceNum);
+        const size_t totalNodeNum = nmf.nNode();
+        const size_t totalCellNum = nmf.nCell();
+
+        HEADER("Block-Glue " + version_str()).repr(fout);
+        DIMENSION(3).repr(fout);
+
+        fout << "(" << std::dec << SECTION::NODE << " (";
+        fout << std::hex << 0 << " " << 1 << " " << totalNodeNum << " ";
+        fout << std::dec << 0 << " " << 3 << "))" << std::endl;
+        fout << "(" << std::dec << SECTION::CELL << " (";
+        fout << std::hex << 0 << " " << 1 << " " << totalCellNum << " ";
+        fout << std::dec << 0 << " " << 0 << "))" << std::endl;
+        fout << "(" << std::dec << SECTION::FACE << " (";
+        fout << std::hex << 0 << " " << 1 << " " << totalFaceNum << " ";
+        fout << std::dec << 0 << " " << 0 << "))" << std::endl;
+    }
+
+    /// Cells, faces and zones of the glued mesh, everything but nodes.
+    /// Connectivity is generated in NMF order, without building the mesh.
+    static void glue_write_connectivity(const NMF::Mapping3D &nmf, std::ostream &fout)
+    {
+        const size_t NBLK = nmf.nBlock();
+        const size_t totalCellNum = nmf.nCell();
+        size_t totalFaceNum = 0, innerFaceNum = 0, bdryFaceNum = 0;
+        nmf.nFace(totalFaceNum, innerFaceNum, bdryFaceNum);
+        const GLUE_FACE_ORDER renumber_face(nmf);
+        size_t cnt = 0;
+
+        /// Cell specifications
+        fout << "(" << std::dec << SECTION::CELL << " (" << std::hex;
+        fout << 2 << " " << 1 << " " << totalCellNum << " ";
+        fout << CELL::FLUID << " " << CELL::HEXAHEDRAL << "))" << std::endl;
+
+        /// Faces are given by the right-hand convention.
+        auto write_face_header = [&fout](size_t zone, size_t first, size_t last, int bc)
+        {
+            fout << "(" << std::dec << SECTION::FACE << " (" << std::hex;
+            fout << zone << " " << first << " " << last << " ";
+            fout << bc << " " << FACE::QUADRILATERAL << ")(" << std::endl;
+        };
+        auto write_face = [&fout](const size_t *nd, size_t c0, size_t c1)
+        {
+            fout << " " << nd[0] << " " << nd[1] << " " << nd[2] << " " << nd[3] << " " << c0 << " " << c1 << "\n";
+        };
+
+        /// Internal faces, block by block, followed by those on double-sided surfaces.
+        /// Faces on double-sided surfaces are collected while traversing blocks.
+        std::vector<CONNECTIVITY> sharedFace(innerFaceNum - renumber_face.newDoubleSidedBase());
+        write_face_header(3, 1, innerFaceNum, BC::INTERIOR);
+        cnt = 0;
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = nmf.block(n);
+            const size_t nI = b.IDIM();
+            const size_t nJ = b.JDIM();
+            const size_t nK = b.KDIM();
+
+            /// Face "r" of cell (i, j, k) on the MIN side.
+            size_t nd[4];
+            auto internal_face = [&](size_t i, size_t j, size_t k, short r)
+            {
+                const auto c = b.cell(i, j, k);
+                if (renumber_face(n - 1, c.FaceSeq(r)) != ++cnt)
+                    throw std::runtime_error("Internal faces of Block " + std::to_string(n) + " are not numbered in sequence.");
+
+                size_t ii, jj, kk;
+                hex_face_on_surf(b, i, j, k, r, ii, jj, kk);
+                hex_face_node(c, r, false, nd);
+                write_face(nd, b.cell(ii, jj, kk).CellSeq(), c.CellSeq());
+            };
+
+            /// Same order as NMF numbering.
+            for (size_t k = 1; k + 1 < nK; ++k)
+                for (size_t j = 1; j < nJ; ++j)
+                    for (size_t i = 1; i < nI; ++i)
+                        internal_face(i, j, k, 2);
+            for (size_t i = 1; i + 1 < nI; ++i)
+                for (size_t k = 1; k < nK; ++k)
+                    for (size_t j = 1; j < nJ; ++j)
+                        internal_face(i, j, k, 4);
+            for (size_t j = 1; j + 1 < nJ; ++j)
+                for (size_t i = 1; i < nI; ++i)
+                    for (size_t k = 1; k < nK; ++k)
+                        internal_face(i, j, k, 6);
+
+            for (short r = 1; r <= NMF::Block3D::NumOfSurf; ++r)
+            {
+                if (!b.surf(r).neighbourSurf)
+                    continue;
+
+                const bool isLeft = double_sided_left(b, r);
+                for (size_t k = 1; k < nK; ++k)
+                    for (size_t j = 1; j < nJ; ++j)
+                        for (size_t i = 1; i < nI; ++i)
+                        {
+                            size_t ii, jj, kk;
+                            if (!hex_face_on_surf(b, i, j, k, r, ii, jj, kk))
+                                continue;
+
+                            const auto c = b.cell(i, j, k);
+                            auto &f = sharedFace.at(renumber_face(n - 1, c.FaceSeq(r)) - renumber_face.newDoubleSidedBase() - 1);
+                            f.x = 4;
+                            if (isLeft)
+                            {
+                                hex_face_node(c, r, false, f.n);
+                                f.c[1] = c.CellSeq();
+                            }
+                            else
+                                f.c[0] = c.CellSeq();
+                        }
+            }
+        }
+        for (size_t i = 0; i < sharedFace.size(); ++i)
+        {
+            const auto &f = sharedFace[i];
+            if (f.c[0] == 0 || f.c[1] == 0)
+                throw std::runtime_error("Face " + std::to_string(renumber_face.newDoubleSidedBase() + i + 1) + " on double-sided surface is not shared by 2 cells.");
+            write_face(f.n, f.c[0], f.c[1]);
+        }
+        fout << "))" << std::endl;
+        std::vector<CONNECTIVITY>().swap(sharedFace);
+
+        /// Boundary faces, one zone for each single-sided surface.
+        /// Faces on a surface are in the same order as NMF numbering.
+        size_t zone_idx = 4;
+        size_t face_pos_L = innerFaceNum + 1;
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = nmf.block(n);
+            const size_t nI = b.IDIM();
+            const size_t nJ = b.JDIM();
+            const size_t nK = b.KDIM();
+
+            for (short r = 1; r <= NMF::Block3D::NumOfSurf; ++r)
+            {
+                if (b.surf(r).neighbourSurf)
+                    continue;
+
+                const size_t cfn = b.surface_face_num(r);
+                write_face_header(zone_idx, face_pos_L, face_pos_L + cfn - 1, BC::WALL);
+
+                size_t nd[4];
+                cnt = face_pos_L - 1;
+                auto bdry_face = [&](size_t i, size_t j, size_t k)
+                {
+                    const auto c = b.cell(i, j, k);
+                    if (renumber_face(n - 1, c.FaceSeq(r)) != ++cnt)
+                        throw std::runtime_error("Faces on surface " + std::to_string(r) + " of Block " + std::to_string(n) + " are not numbered in sequence.");
+
+                    hex_face_node(c, r, true, nd);
+                    write_face(nd, c.CellSeq(), 0);
+                };
+
+                switch (r)
+                {
+                case 1:
+                case 2:
+                    for (size_t j = 1; j < nJ; ++j)
+                        for (size_t i = 1; i < nI; ++i)
+                            bdry_face(i, j, r == 1 ? 1 : nK - 1);
+                    break;
+                case 3:
+                case 4:
+                    for (size_t k = 1; k < nK; ++k)
+                        for (size_t j = 1; j < nJ; ++j)
+                            bdry_face(r == 3 ? 1 : nI - 1, j, k);
+                    break;
+                default:
+                    for (size_t i = 1; i < nI; ++i)
+                        for (size_t k = 1; k < nK; ++k)
+                            bdry_face(i, r == 5 ? 1 : nJ - 1, k);
+                    break;
+                }
+                fout << "))" << std::endl;
+
+                face_pos_L += cfn;
+                ++zone_idx;
+            }
+        }
+
+        /// Zone specifications.
+        /// No need to show NODE zone.
+        COMMENT("Zone Sections").repr(fout);
+        ZONE(2, "fluid", "FLUID").repr(fout);
+        ZONE(3, "interior", "int_FLUID").repr(fout);
+        zone_idx = 4;
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = nmf.block(n);
+            for (short r = 1; r <= NMF::Block3D::NumOfSurf; ++r)
+                if (!b.surf(r).neighbourSurf)
+                    ZONE(zone_idx++, "wall", boundary_zone_name(n, r)).repr(fout);
+        }
+    }
+
+    void MESH::glueToFile(const std::string &f_nmf, const std::string &f_p3d, const std::string &dst)
+    {
+        /// Load mapping file.
+        /// Under implicit numbering, only indices on double-sided surfaces are stored.
+        NMF::Mapping3D nmf(f_nmf);
+        nmf.numbering(true);
+
+        /// Open grid file, blocks are loaded one by one.
+        PLOT3D::READER p3d(f_p3d);
+        const size_t NBLK = nmf.nBlock();
+        if (NBLK != p3d.numOfBlock())
+            throw std::invalid_argument("Inconsistent num of blocks between NMF and PLOT3D.");
+
+        const size_t totalNodeNum = nmf.nNode();
+
+        /// Open target file.
+        std::ofstream fout(dst);
+        if (fout.fail())
+            throw std::runtime_error("Failed to open output grid file: " + dst);
+
+        /// Same layout as "MESH::writeToFile" on the glued mesh.
+        glue_write_declaration(nmf, fout);
+
+        /// Nodal coordinates.
+        /// Internal nodes of each block are numbered in sequence, and are
+        /// written once the block is loaded. The rest may be shared by
+        /// multiple blocks, and are kept until all blocks are loaded.
+        size_t innerNodeNum = 0;
+        for (size_t n = 1; n <= NBLK; ++n)
+            innerNodeNum += nmf.block(n).block_internal_node_num();
+
+        std::vector<Vector> shellNode(totalNodeNum - innerNodeNum);
+        std::vector<bool> visited(shellNode.size(), false);
+
+        fout << "(" << std::dec << SECTION::NODE;
+        fout << " (" << std::hex << 1 << " " << 1 << " " << totalNodeNum << " ";
+        fout << std::dec << NODE::ANY << " " << 3 << ")(" << std::endl;
+        fout.precision(12);
+
+        auto write_node = [&fout](const Vector &p)
+        {
+            fout << " " << p.x() << " " << p.y() << " " << p.z() << "\n";
+        };
+
+        size_t cnt = 0;
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = nmf.block(n);
+            std::unique_ptr<PLOT3D::BLK> g(p3d.next());
+
+            const size_t nI = b.IDIM();
+            const size_t nJ = b.JDIM();
+            const size_t nK = b.KDIM();
+            if (nI != g->nI())
+                throw std::invalid_argument("Inconsistent num of nodes in I dimension of Block " + std::to_string(n) + ".");
+            if (nJ != g->nJ())
+                throw std::invalid_argument("Inconsistent num of nodes in J dimension of Block " + std::to_string(n) + ".");
+            if (nK != g->nK())
+                throw std::invalid_argument("Inconsistent num of nodes in K dimension of Block " + std::to_string(n) + ".");
+
+            if (b.block_internal_node_num() > 0 && b.node_index(2, 2, 2) != cnt + 1)
+                throw std::runtime_error("Internal nodes of Block " + std::to_string(n) + " are not numbered in sequence.");
+            for (size_t k = 2; k < nK; ++k)
+                for (size_t j = 2; j < nJ; ++j)
+                    for (size_t i = 2; i < nI; ++i)
+                        write_node(g->at(i - 1, j - 1, k - 1));
+            cnt += b.block_internal_node_num();
+
+            /// Nodes on surfaces, coordinates are taken from the first block.
+            for (size_t k = 1; k <= nK; ++k)
+                for (size_t j = 1; j <= nJ; ++j)
+                {
+                    const bool onShell = k == 1 || k == nK || j == 1 || j == nJ;
+                    const size_t step = onShell || nI < 2 ? 1 : nI - 1;
+                    for (size_t i = 1; i <= nI; i += step)
+                    {
+                        const size_t loc = b.node_index(i, j, k) - innerNodeNum - 1;
+                        if (!visited[loc])
+                        {
+                            shellNode[loc] = g->at(i - 1, j - 1, k - 1);
+                            visited[loc] = true;
+                        }
+                    }
+                }
+        }
+        for (size_t i = 0; i < shellNode.size(); ++i)
+        {
+            if (!visited[i])
+                throw std::runtime_error("Node " + std::to_string(innerNodeNum + i + 1) + " is not found in any block.");
+            write_node(shellNode[i]);
+        }
+        fout << "))" << std::endl;
+        std::vector<Vector>().swap(shellNode);
+
+        glue_write_connectivity(nmf, fout);
+
+        /// Close target file.
+        fout.close();
+    }
+
+    GLUE_SESSION::GLUE_SESSION(const std::string &f_nmf) :
+        m_nmf(new NMF::Mapping3D(f_nmf)),
+        m_nodePos(0),
+        m_fixedWidth(false),
+        m_dstSize(0),
+        m_dstTime()
+    {
+        m_nmf->numbering(true);
+
+        /// Each node takes coordinates from the first block where it is found.
+        const size_t NBLK = m_nmf->nBlock();
+        m_blkOffset.assign(NBLK + 1, 0);
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = m_nmf->block(n);
+            m_blkOffset[n] = m_blkOffset[n - 1] + b.IDIM() * b.JDIM() * b.KDIM();
+        }
+        m_nodeMap.resize(m_blkOffset[NBLK]);
+        m_node.resize(m_nmf->nNode());
+
+        std::vector<bool> visited(m_node.size(), false);
+        std::vector<size_t> idx;
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            m_nmf->block(n).node_index_map(idx);
+            auto dst = m_nodeMap.begin() + m_blkOffset[n - 1];
+            for (size_t p = 0; p < idx.size(); ++p)
+            {
+                const size_t loc = idx[p] - 1;
+                if (visited[loc])
+                    dst[p] = 0;
+                else
+                {
+                    dst[p] = idx[p];
+                    visited[loc] = true;
+                }
+            }
+        }
+        for (size_t i = 0; i < visited.size(); ++i)
+            if (!visited[i])
+                throw std::runtime_error("Node " + std::to_string(i + 1) + " is not found in any block.");
+    }
+
+    GLUE_SESSION::~GLUE_SESSION()
+    {
+        delete m_nmf;
+    }
+
+    size_t GLUE_SESSION::numOfNode() const
+    {
+        return m_node.size();
+    }
+
+    const Vector &GLUE_SESSION::node(size_t id) const
+    {
+        return m_node.at(id - 1);
+    }
+
+    void GLUE_SESSION::update(const std::string &f_p3d)
+    {
+        scatter(f_p3d, m_node);
+    }
+
+    void GLUE_SESSION::scatter(const std::string &f_p3d, std::vector<Vector> &node) const
+    {
+        PLOT3D::READER p3d(f_p3d);
+        const size_t NBLK = m_nmf->nBlock();
+        if (NBLK != p3d.numOfBlock())
+            throw std::invalid_argument("Inconsistent num of blocks between NMF and PLOT3D.");
+
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = m_nmf->block(n);
+            std::unique_ptr<PLOT3D::BLK> g(p3d.next());
+
+            const size_t nI = b.IDIM();
+            const size_t nJ = b.JDIM();
+            const size_t nK = b.KDIM();
+            if (nI != g->nI())
+                throw std::invalid_argument("Inconsistent num of nodes in I dimension of Block " + std::to_string(n) + ".");
+            if (nJ != g->nJ())
+                throw std::invalid_argument("Inconsistent num of nodes in J dimension of Block " + std::to_string(n) + ".");
+            if (nK != g->nK())
+                throw std::invalid_argument("Inconsistent num of nodes in K dimension of Block " + std::to_string(n) + ".");
+
+            /// Each node has only one source, so no conflict among K-slabs.
+            const size_t *idx = m_nodeMap.data() + m_blkOffset[n - 1];
+            COMMON::parallel_for(nK, [&](size_t first, size_t last)
+            {
+                for (size_t k = first; k < last; ++k)
+                    for (size_t j = 0; j < nJ; ++j)
+                        for (size_t i = 0; i < nI; ++i)
+                        {
+                            const size_t loc = idx[i + nI * (j + nJ * k)];
+                            if (loc)
+                                node[loc - 1] = g->at(i, j, k);
+                        }
+            });
+        }
+    }
+
+    void GLUE_SESSION::writeToFile(const std::string &dst, bool fixedWidth)
+    {
+        /// Everything before the node section stays the same, it is kept
+        /// as long as the file is untouched since the last output.
+        bool reuse = false;
+        if (dst == m_dst)
+        {
+            std::error_code ec1, ec2;
+            const auto len = std::filesystem::file_size(dst, ec1);
+            const auto t = std::filesystem::last_write_time(dst, ec2);
+            reuse = !ec1 && !ec2 && len == m_dstSize && t == m_dstTime;
+        }
+
+        if (reuse)
+        {
+            if (fixedWidth && m_fixedWidth)
+            {
+                MESH::patchNode(dst, m_node);
+                record_output();
+                return;
+            }
+
+            std::error_code ec;
+            std::filesystem::resize_file(dst, m_nodePos, ec);
+            if (ec)
+                throw std::runtime_error("Failed to truncate output grid file: " + dst);
+
+            std::ofstream fout(dst, std::ios::app);
+            if (fout.fail())
+                throw std::runtime_error("Failed to open output grid file: " + dst);
+            write_node(fout, m_node, fixedWidth);
+            fout.close();
+            m_fixedWidth = fixedWidth;
+            record_output();
+            return;
+        }
+
+        m_dst.clear();
+        std::ofstream fout(dst);
+        if (fout.fail())
+            throw std::runtime_error("Failed to open output grid file: " + dst);
+        glue_write_declaration(*m_nmf, fout);
+        glue_write_connectivity(*m_nmf, fout);
+        m_nodePos = static_cast<size_t>(fout.tellp());
+        m_fixedWidth = fixedWidth;
+        write_node(fout, m_node, fixedWidth);
+        fout.close();
+        if (fout.fail())
+            throw std::runtime_error("Failed to write output grid file: " + dst);
+        m_dst = dst;
+        record_output();
+    }
+
+    void GLUE_SESSION::record_output()
+    {
+        /// Rewrite entirely next time if the state is unknown.
+        std::error_code ec1, ec2;
+        m_dstSize = std::filesystem::file_size(m_dst, ec1);
+        m_dstTime = std::filesystem::last_write_time(m_dst, ec2);
+        if (ec1 || ec2)
+            m_dst.clear();
+    }
+
+    void GLUE_SESSION::batch(const std::vector<std::string> &f_p3d, const std::vector<std::string> &dst, size_t nInFlight, bool fixedWidth) const
+    {
+        if (f_p3d.size() != dst.size())
+            throw std::invalid_argument("Inconsistent num of input and output files.");
+
+        /// Everything but nodes is the same for all designs.
+        std::ostringstream ss;
+        glue_write_declaration(*m_nmf, ss);
+        glue_write_connectivity(*m_nmf, ss);
+        const std::string common = ss.str();
+        ss.str(std::string());
+
+        /// Each worker takes the next design once the previous one is written.
+        const size_t nDesign = f_p3d.size();
+        const size_t nWorker = std::min(nDesign, nInFlight > 0 ? nInFlight : COMMON::num_of_thread());
+        std::atomic<size_t> next(0);
+        std::atomic<bool> failed(false);
+        std::exception_ptr err = nullptr;
+        std::mutex errLock;
+
+        COMMON::run_workers(nWorker, [&](size_t)
+        {
+            std::vector<Vector> node(m_node.size());
+            while (!failed)
+            {
+                const size_t n = next++;
+                if (n >= nDesign)
+                    break;
+
+                try
+                {
+                    scatter(f_p3d[n], node);
+
+                    std::ofstream fout(dst[n]);
+                    if (fout.fail())
+                        throw std::runtime_error("Failed to open output grid file: " + dst[n]);
+                    fout.write(common.data(), common.size());
+                    write_node(fout, node, fixedWidth);
+                    fout.close();
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> guard(errLock);
+                    if (!err)
+                        err = std::current_exception();
+                    failed = true;
+                }
+            }
+        });
+        if (err)
+            std::rethrow_exception(err);
+    }
+
+    void GLUE_SESSION::write_node(std::ostream &fout, const std::vector<Vector> &node, bool fixedWidth)
+    {
+        const size_t N = node.size();
+        fout << "(" << std::dec << SECTION::NODE;
+        fout << " (" << std::hex << 1 << " " << 1 << " " << N << " ";
+        fout << std::dec << NODE::ANY << " " << 3 << ")(" << std::endl;
+
+        /// Same format as "std::ostream" with precision of 12, or "NODE::repr" in fixed width.
+        /// Text is generated in parallel, a batch at a time.
+        static const size_t BATCH = 1 << 20;
+        const size_t nt = std::max<size_t>(COMMON::num_of_thread(), 1);
+        std::vector<std::string> buf(nt);
+        for (size_t first = 0; first < N; first += BATCH)
+        {
+            const size_t cnt = std::min(BATCH, N - first);
+            const size_t chunk = (cnt + nt - 1) / nt;
+            COMMON::parallel_for(nt, [&](size_t tFirst, size_t tLast)
+            {
+                char line[128];
+                for (size_t t = tFirst; t < tLast; ++t)
+                {
+                    auto &s = buf[t];
+                    s.clear();
+                    const size_t l = std::min(cnt, t * chunk);
+                    const size_t r = std::min(cnt, l + chunk);
+                    for (size_t i = first + l; i < first + r; ++i)
+                    {
+                        if (fixedWidth)
+                        {
+                            s.append(line, NODE::fixed_width_repr(node[i], 3, line));
+                            continue;
+                        }
+
+                        char *pos = line;
+                        for (short d = 0; d < 3; ++d)
+                        {
+                            *pos++ = ' ';
+                            pos = std::to_chars(pos, line + sizeof(line), node[i][d], std::chars_format::general, 12).ptr;
+                        }
+                        *pos++ = '\n';
+                        s.append(line, pos);
+                    }
+                }
+            });
+            for (const auto &s : buf)
+                fout.write(s.data(), s.size());
+        }
+        fout << "))" << std::endl;
     }
 }
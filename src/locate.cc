@@ -0,0 +1,110 @@
+#include "../inc/xf.h"
+
+namespace GridTool::XF
+{
+    LOCATOR::LOCATOR(const MESH &mesh, double tol) :
+        m_mesh(mesh),
+        m_tol(tol),
+        m_maxStep(16)
+    {
+        const size_t nCell = mesh.numOfCell();
+
+        std::vector<COMMON::BOX> box(nCell);
+        m_size.resize(nCell);
+        COMMON::parallel_for(nCell, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                for (auto e : mesh.cell(i + 1).includedNode)
+                    box[i].expand(mesh.node(e).coordinate);
+
+                Vector diag;
+                COMMON::delta(box[i].lo, box[i].hi, diag);
+                m_size[i] = diag.norm();
+                box[i].inflate(tol * m_size[i]);
+            }
+        });
+        m_tree.build(box);
+    }
+
+    bool LOCATOR::inside(size_t cell, const Vector &p) const
+    {
+        const auto &c = m_mesh.cell(cell);
+        for (size_t j = 0; j < c.includedFace.size(); ++j)
+        {
+            Vector r;
+            COMMON::delta(m_mesh.face(c.includedFace.at(j)).center, p, r);
+            if (r.dot(c.n.at(j)) > m_tol * m_size[cell - 1])
+                return false;
+        }
+        return true;
+    }
+
+    size_t LOCATOR::locate(const Vector &p, size_t seed) const
+    {
+        /// Walk across the face that "p" lies furthest in front of.
+        /// Seeds too far away are ignored, as random access of cells
+        /// along a long walk costs more than searching the tree.
+        size_t cur = seed;
+        if (cur != 0 && COMMON::line_length(p, m_mesh.cell(cur).center) > 4 * m_size[cur - 1])
+            cur = 0;
+        for (size_t step = 0; cur != 0 && step < m_maxStep; ++step)
+        {
+            const auto &c = m_mesh.cell(cur);
+            double sMax = m_tol * m_size[cur - 1];
+            size_t jMax = c.includedFace.size();
+            for (size_t j = 0; j < c.includedFace.size(); ++j)
+            {
+                Vector r;
+                COMMON::delta(m_mesh.face(c.includedFace.at(j)).center, p, r);
+                const double s = r.dot(c.n.at(j));
+                if (s > sMax)
+                {
+                    sMax = s;
+                    jMax = j;
+                }
+            }
+            if (jMax == c.includedFace.size())
+                return cur;
+
+            cur = c.adjacentCell.at(jMax);
+        }
+
+        size_t ret = 0;
+        m_tree.locate(p, [&](size_t k)
+        {
+            if (inside(k + 1, p))
+            {
+                ret = k + 1;
+                return true;
+            }
+            return false;
+        });
+        return ret;
+    }
+
+    void LOCATOR::locate(const std::vector<Vector> &p, std::vector<size_t> &dst) const
+    {
+        dst.resize(p.size());
+        COMMON::parallel_for(p.size(), [&](size_t first, size_t last)
+        {
+            size_t seed = 0;
+            for (size_t i = first; i < last; ++i)
+            {
+                dst[i] = locate(p[i], seed);
+                if (dst[i] != 0)
+                    seed = dst[i];
+            }
+        });
+    }
+
+    size_t LOCATOR::nearest(const Vector &p) const
+    {
+        double d = 0.0;
+        const size_t ret = m_tree.nearest(p, [&](size_t k)
+        {
+            return COMMON::line_length(p, m_mesh.cell(k + 1).center);
+        }, d);
+        return m_tree.empty() ? 0 : ret + 1;
+    }
+}
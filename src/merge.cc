@@ -0,0 +1,525 @@
+#include <algorithm>
+#include <unordered_map>
+#include "../inc/xf.h"
+
+namespace GridTool::XF
+{
+    /// Nodes of a face in ascending order, padded with 0.
+    /// Faces sharing the same nodes share the same key.
+    struct MERGE_KEY
+    {
+        size_t n[4];
+
+        explicit MERGE_KEY(const CONNECTIVITY &f) : n{ 0, 0, 0, 0 }
+        {
+            if (f.x < 0 || f.x > 4)
+                throw FACE::polygon_not_supported();
+
+            const size_t m = static_cast<size_t>(f.x);
+            std::copy(f.n, f.n + m, n);
+            std::sort(n, n + m);
+        }
+
+        bool operator==(const MERGE_KEY &rhs) const
+        {
+            return std::equal(n, n + 4, rhs.n);
+        }
+    };
+
+    struct MERGE_KEY_HASH
+    {
+        size_t operator()(const MERGE_KEY &k) const
+        {
+            size_t h = 0;
+            for (auto e : k.n)
+                h ^= std::hash<size_t>()(e) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+
+    /// Root of "x" with path halving, roots are always the minimum within each set.
+    static size_t merge_find(std::vector<size_t> &parent, size_t x)
+    {
+        while (parent[x] != x)
+        {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+    static void merge_unite(std::vector<size_t> &parent, size_t a, size_t b)
+    {
+        a = merge_find(parent, a);
+        b = merge_find(parent, b);
+        if (a < b)
+            parent[b] = a;
+        else if (b < a)
+            parent[a] = b;
+    }
+
+    /// Whether "b" has the same cyclic order of nodes as "a".
+    /// Both are assumed to share the same nodes.
+    static bool merge_same_orientation(const CONNECTIVITY &a, const CONNECTIVITY &b)
+    {
+        const int x = a.x;
+        int p = 0;
+        while (b.n[p] != a.n[0])
+            ++p;
+
+        bool same = true, reversed = true;
+        for (int k = 1; k < x; ++k)
+        {
+            same = same && b.n[(p + k) % x] == a.n[k];
+            reversed = reversed && b.n[(p - k + x) % x] == a.n[k];
+        }
+        if (x == FACE::LINEAR)
+            return same;
+        if (same == reversed)
+            throw std::runtime_error("Faces sharing the same nodes are not in the same shape.");
+        return same;
+    }
+
+    size_t MESH::merge_node(double tol)
+    {
+        const size_t ret = stitch(tol);
+        raw2derived();
+        return ret;
+    }
+
+    size_t MESH::stitch(double tol)
+    {
+        if (!(tol > 0))
+            throw std::invalid_argument("Tolerance must be positive.");
+
+        const size_t N = numOfNode();
+        if (N == 0 || m_content.empty())
+            throw std::runtime_error("Empty mesh.");
+
+        /************************ Clusters of nodes ***************************/
+        /// Taken from raw records, derived ones may not be ready.
+        std::vector<Vector> coord(N);
+        for (auto e : m_content)
+        {
+            if (e->identity() == SECTION::NODE)
+            {
+                auto curObj = dynamic_cast<NODE*>(e);
+                if (curObj == nullptr)
+                    throw internal_error(-1);
+                if (curObj->last_index() > N)
+                    throw internal_error("node index out of range");
+                std::copy(curObj->begin(), curObj->end(), coord.begin() + (curObj->first_index() - 1));
+            }
+        }
+        const COMMON::POINT_HASH hash(coord, tol);
+
+        /// Num of nodes with smaller index within the tolerance, and the smallest one.
+        /// Most nodes have none, and the rest have only 1 counterpart usually.
+        std::vector<size_t> nLower(N, 0), lower(N);
+        COMMON::parallel_for(N, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                lower[i] = i;
+                hash.query(coord[i], [&](size_t j)
+                {
+                    if (j < i)
+                    {
+                        ++nLower[i];
+                        lower[i] = std::min(lower[i], j);
+                    }
+                });
+            }
+        });
+
+        std::vector<size_t> parent(N);
+        for (size_t i = 0; i < N; ++i)
+            parent[i] = i;
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (nLower[i] == 1)
+                merge_unite(parent, i, lower[i]);
+            else if (nLower[i] > 1)
+            {
+                hash.query(coord[i], [&](size_t j)
+                {
+                    if (j < i)
+                        merge_unite(parent, i, j);
+                });
+            }
+        }
+
+        /// Clusters are represented by their 1st node, and the order is preserved.
+        /// "nodeMap[i]" is the new 1-based index of node "i + 1".
+        std::vector<size_t> nodeMap(N);
+        size_t nNode = 0;
+        for (size_t i = 0; i < N; ++i)
+        {
+            const size_t r = merge_find(parent, i);
+            nodeMap[i] = r == i ? ++nNode : nodeMap[r];
+        }
+
+        /************************** Remap faces ******************************/
+        /// Checked on copies, the mesh is untouched if anything goes wrong.
+        std::vector<FACE*> faceSection;
+        for (auto e : m_content)
+        {
+            if (e->identity() == SECTION::FACE)
+            {
+                auto curObj = dynamic_cast<FACE*>(e);
+                if (curObj == nullptr)
+                    throw internal_error(-2);
+                faceSection.push_back(curObj);
+            }
+        }
+
+        /// Faces are numbered in the order of sections.
+        std::sort(faceSection.begin(), faceSection.end(), [](const FACE *a, const FACE *b)
+        {
+            return a->first_index() < b->first_index();
+        });
+
+        /// "cnct[i]" is the connectivity of face "i + 1".
+        std::vector<CONNECTIVITY> cnct(numOfFace());
+        std::vector<bool> covered(numOfFace(), false);
+        for (auto e : faceSection)
+        {
+            if (e->last_index() > numOfFace())
+                throw internal_error("face index out of range");
+            for (size_t i = e->first_index(); i <= e->last_index(); ++i)
+            {
+                cnct[i - 1] = e->at(i - e->first_index());
+                covered[i - 1] = true;
+            }
+        }
+        if (std::find(covered.begin(), covered.end(), false) != covered.end())
+            throw internal_error("faces not covered by any section");
+
+        COMMON::parallel_for(numOfFace(), [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                auto &f = cnct[i];
+                for (int j = 0; j < f.x; ++j)
+                    f.n[j] = nodeMap[f.n[j] - 1];
+                for (int j = 0; j < f.x; ++j)
+                    for (int k = j + 1; k < f.x; ++k)
+                        if (f.n[j] == f.n[k])
+                            throw std::runtime_error("Face " + std::to_string(i + 1) + " collapses, the tolerance is too large.");
+            }
+        });
+
+        /************************* Stitch faces *******************************/
+        /// Pairs of boundary faces sharing the same nodes.
+        /// The one with smaller index is kept and becomes interior.
+        std::vector<size_t> partner(numOfFace(), 0);
+        std::unordered_map<MERGE_KEY, size_t, MERGE_KEY_HASH> bdry;
+        bdry.reserve(std::count_if(cnct.begin(), cnct.end(), [](const CONNECTIVITY &f) { return f.c[0] == 0 || f.c[1] == 0; }));
+        size_t nPair = 0;
+        for (size_t i = 0; i < numOfFace(); ++i)
+        {
+            const auto &f = cnct[i];
+            if ((f.c[0] == 0) == (f.c[1] == 0))
+                continue;
+
+            auto ret = bdry.emplace(MERGE_KEY(f), i + 1);
+            if (ret.second)
+                continue;
+
+            const size_t a = ret.first->second;
+            if (partner[a - 1] != 0)
+                throw std::runtime_error("More than 2 boundary faces share the same nodes as face " + std::to_string(a) + ".");
+            partner[a - 1] = i + 1;
+            partner[i] = a;
+            ++nPair;
+        }
+
+        /// Cell of the removed face is moved to the empty side of the kept one.
+        for (size_t i = 0; i < numOfFace(); ++i)
+        {
+            if (partner[i] < i + 1)
+                continue;
+
+            auto &a = cnct[i];
+            const auto &b = cnct[partner[i] - 1];
+            const int sa = a.c[0] != 0 ? 0 : 1;
+            const int sb = b.c[0] != 0 ? 0 : 1;
+            const int s = merge_same_orientation(a, b) ? sb : 1 - sb;
+            if (s == sa)
+                throw std::runtime_error("Cells adjacent to face " + std::to_string(i + 1) + " and face " + std::to_string(partner[i]) + " overlap.");
+            a.c[s] = b.c[sb];
+        }
+
+        /************************** Update nodes *****************************/
+        /// Sections left empty are removed together with their zones.
+        std::vector<size_t> removedZone;
+        for (auto it = m_content.begin(); it != m_content.end();)
+        {
+            if ((*it)->identity() != SECTION::NODE)
+            {
+                ++it;
+                continue;
+            }
+
+            auto curObj = dynamic_cast<NODE*>(*it);
+            if (curObj == nullptr)
+                throw internal_error(-1);
+
+            std::vector<size_t> kept;
+            for (size_t i = curObj->first_index(); i <= curObj->last_index(); ++i)
+                if (merge_find(parent, i - 1) == i - 1)
+                    kept.push_back(i);
+
+            if (kept.empty())
+            {
+                removedZone.push_back(curObj->zone());
+                it = m_content.erase(it);
+            }
+            else
+            {
+                auto newObj = new NODE(curObj->zone(), nodeMap[kept.front() - 1], nodeMap[kept.back() - 1], curObj->type(), curObj->ND());
+                for (size_t i = 0; i < kept.size(); ++i)
+                    newObj->at(i) = curObj->at(kept[i] - curObj->first_index());
+                *it = newObj;
+                ++it;
+            }
+            delete curObj;
+        }
+        m_totalNodeNum = nNode;
+
+        /************************** Update faces *****************************/
+        /// Stitched faces are gathered into the 1st interior section,
+        /// or a new one if there is none.
+        const FACE *dst = nullptr;
+        for (auto e : faceSection)
+            if (e->bc_type() == BC::INTERIOR)
+            {
+                dst = e;
+                break;
+            }
+
+        std::vector<size_t> moved;
+        for (auto e : faceSection)
+            if (e != dst)
+                for (size_t i = e->first_index(); i <= e->last_index(); ++i)
+                    if (partner[i - 1] > i)
+                        moved.push_back(i);
+
+        auto append = [&](std::vector<CONNECTIVITY> &cur, int &ft)
+        {
+            for (auto i : moved)
+            {
+                cur.push_back(cnct[i - 1]);
+                if (cnct[i - 1].x != ft)
+                    ft = FACE::MIXED;
+            }
+        };
+
+        size_t nFace = 0;
+        for (auto e : faceSection)
+        {
+            std::vector<CONNECTIVITY> cur;
+            for (size_t i = e->first_index(); i <= e->last_index(); ++i)
+                if (partner[i - 1] == 0 || (partner[i - 1] > i && e == dst))
+                    cur.push_back(cnct[i - 1]);
+            int ft = e->face_type();
+            if (e == dst)
+                append(cur, ft);
+
+            auto pos = std::find(m_content.begin(), m_content.end(), e);
+            if (cur.empty())
+            {
+                removedZone.push_back(e->zone());
+                m_content.erase(pos);
+            }
+            else
+            {
+                auto newObj = new FACE(e->zone(), nFace + 1, nFace + cur.size(), e->bc_type(), ft);
+                std::copy(cur.begin(), cur.end(), newObj->begin());
+                nFace += cur.size();
+                *pos = newObj;
+            }
+        }
+
+        if (dst == nullptr && !moved.empty())
+        {
+            size_t zone = 0;
+            for (auto e : m_content)
+            {
+                if (auto r = dynamic_cast<RANGE*>(e))
+                    zone = std::max(zone, r->zone());
+                else if (auto z = dynamic_cast<ZONE*>(e))
+                    zone = std::max(zone, z->zone());
+            }
+            for (auto z : removedZone)
+                zone = std::max(zone, z);
+            ++zone;
+
+            std::vector<CONNECTIVITY> cur;
+            int ft = cnct[moved.front() - 1].x;
+            append(cur, ft);
+            auto newObj = new FACE(zone, nFace + 1, nFace + cur.size(), BC::INTERIOR, ft);
+            std::copy(cur.begin(), cur.end(), newObj->begin());
+            nFace += cur.size();
+
+            /// Right after the last FACE section.
+            auto pos = m_content.end();
+            for (auto it = m_content.begin(); it != m_content.end(); ++it)
+                if ((*it)->identity() == SECTION::FACE)
+                    pos = it + 1;
+            m_content.insert(pos, newObj);
+            m_content.push_back(new ZONE(zone, "interior", "int_merged"));
+        }
+
+        for (auto e : faceSection)
+            delete e;
+        m_totalFaceNum = nFace;
+
+        /// Zones of removed sections.
+        for (auto it = m_content.begin(); it != m_content.end();)
+        {
+            auto z = dynamic_cast<ZONE*>(*it);
+            if (z != nullptr && std::find(removedZone.begin(), removedZone.end(), z->zone()) != removedZone.end())
+            {
+                delete z;
+                it = m_content.erase(it);
+            }
+            else
+                ++it;
+        }
+
+        return nPair;
+    }
+
+    MESH::MESH(const std::vector<const MESH*> &src, double tol, std::ostream &fout) :
+        DIM(3),
+        m_totalNodeNum(0),
+        m_totalCellNum(0),
+        m_totalFaceNum(0),
+        m_totalZoneNum(0)
+    {
+        if (src.empty())
+            throw std::invalid_argument("No mesh to be assembled.");
+        if (!(tol >= 0))
+            throw std::invalid_argument("Tolerance must be non-negative.");
+
+        /// Offsets of each component.
+        const size_t NCOMP = src.size();
+        std::vector<size_t> nodeOffset(NCOMP), faceOffset(NCOMP), cellOffset(NCOMP), zoneOffset(NCOMP);
+        size_t nSection = 0, nZone = 0;
+        for (size_t k = 0; k < NCOMP; ++k)
+        {
+            const auto m = src[k];
+            if (m == nullptr || m->m_content.empty())
+                throw std::invalid_argument("Mesh " + std::to_string(k + 1) + " is empty.");
+            if (m->dimension() != src[0]->dimension())
+                throw std::invalid_argument("Inconsistent dimension of mesh " + std::to_string(k + 1) + ".");
+
+            nodeOffset[k] = m_totalNodeNum;
+            faceOffset[k] = m_totalFaceNum;
+            cellOffset[k] = m_totalCellNum;
+            zoneOffset[k] = nZone;
+            m_totalNodeNum += m->numOfNode();
+            m_totalFaceNum += m->numOfFace();
+            m_totalCellNum += m->numOfCell();
+
+            size_t z = 0;
+            for (auto e : m->m_content)
+            {
+                if (auto r = dynamic_cast<const RANGE*>(e))
+                    z = std::max(z, r->zone());
+                else if (auto r = dynamic_cast<const ZONE*>(e))
+                    z = std::max(z, r->zone());
+                else
+                    continue;
+                ++nSection;
+            }
+            nZone += z;
+        }
+        m_dim = src[0]->dimension();
+        m_is3D = src[0]->is3D();
+
+        try
+        {
+            /// Sections are allocated with their final sizes.
+            m_content.reserve(nSection + 3);
+            add_entry(new HEADER("Assembly of " + std::to_string(NCOMP) + " meshes"));
+            add_entry(new DIMENSION(dimension()));
+
+            std::set<std::string> zoneName;
+            for (size_t k = 0; k < NCOMP; ++k)
+            {
+                const size_t nOff = nodeOffset[k], fOff = faceOffset[k], cOff = cellOffset[k], zOff = zoneOffset[k];
+                for (auto e : src[k]->m_content)
+                {
+                    if (e->identity() == SECTION::NODE)
+                    {
+                        auto curObj = dynamic_cast<const NODE*>(e);
+                        if (curObj == nullptr)
+                            throw internal_error(-1);
+
+                        auto newObj = new NODE(curObj->zone() + zOff, curObj->first_index() + nOff, curObj->last_index() + nOff, curObj->type(), curObj->ND());
+                        add_entry(newObj);
+                        std::copy(curObj->begin(), curObj->end(), newObj->begin());
+                    }
+                    else if (e->identity() == SECTION::CELL)
+                    {
+                        auto curObj = dynamic_cast<const CELL*>(e);
+                        if (curObj == nullptr)
+                            throw internal_error(-4);
+
+                        auto newObj = new CELL(curObj->zone() + zOff, curObj->first_index() + cOff, curObj->last_index() + cOff, curObj->type(), curObj->element_type());
+                        add_entry(newObj);
+                        std::copy(curObj->begin(), curObj->end(), newObj->begin());
+                    }
+                    else if (e->identity() == SECTION::FACE)
+                    {
+                        auto curObj = dynamic_cast<const FACE*>(e);
+                        if (curObj == nullptr)
+                            throw internal_error(-2);
+
+                        auto newObj = new FACE(curObj->zone() + zOff, curObj->first_index() + fOff, curObj->last_index() + fOff, curObj->bc_type(), curObj->face_type());
+                        add_entry(newObj);
+                        COMMON::parallel_for(curObj->num(), [&](size_t first, size_t last)
+                        {
+                            for (size_t i = first; i < last; ++i)
+                            {
+                                const auto &f = curObj->at(i);
+                                auto &g = newObj->at(i);
+                                g.x = f.x;
+                                for (int j = 0; j < f.x; ++j)
+                                    g.n[j] = f.n[j] + nOff;
+                                for (int j = 0; j < 2; ++j)
+                                    g.c[j] = f.c[j] == 0 ? 0 : f.c[j] + cOff;
+                            }
+                        });
+                    }
+                    else if (e->identity() == SECTION::ZONE)
+                    {
+                        auto curObj = dynamic_cast<const ZONE*>(e);
+                        if (curObj == nullptr)
+                            throw internal_error("zone record not recognized");
+
+                        /// Names are kept unique.
+                        std::string name = curObj->name();
+                        while (!zoneName.insert(name).second)
+                            name += "_" + std::to_string(k + 1);
+                        add_entry(new ZONE(static_cast<int>(curObj->zone() + zOff), curObj->type(), name, curObj->domain()));
+                    }
+                }
+            }
+
+            if (tol > 0)
+            {
+                const size_t nPair = stitch(tol);
+                fout << "Num of stitched face pairs: " << nPair << std::endl;
+            }
+            raw2derived();
+        }
+        catch (...)
+        {
+            clear_entry();
+            throw;
+        }
+    }
+}
@@ -1,34 +1,248 @@
 #include <iostream>
 #include <set>
-#include <map>
-#include <queue>
-#include <stack>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <string_view>
 #include "../inc/nmf.h"
 
-static bool isWhite(char c)
+#ifdef _WIN32
+#define NMF_NO_MMAP
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/// Read-only view of the whole content of a text file.
+/// The file is mapped into memory where supported, and read into a buffer otherwise.
+class TEXT_FILE
 {
-    return c == '\n' || c == ' ' || c == '\t';
-}
+private:
+    const char *m_data;
+    size_t m_size;
+    bool m_mapped;
+    std::string m_buffer;
+
+public:
+    explicit TEXT_FILE(const std::string &src) :
+        m_data(nullptr),
+        m_size(0),
+        m_mapped(false)
+    {
+#ifdef NMF_NO_MMAP
+        std::ifstream fin(src, std::ios::binary);
+        if (fin.fail())
+            throw std::runtime_error("Can not open target input file: \"" + src + "\".");
+        std::stringstream ss;
+        ss << fin.rdbuf();
+        m_buffer = ss.str();
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+#else
+        const int fd = ::open(src.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Can not open target input file: \"" + src + "\".");
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Failed to query size of input file: \"" + src + "\".");
+        }
+        m_size = st.st_size;
+        if (m_size > 0)
+        {
+            void *p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("Failed to map input file: \"" + src + "\".");
+            }
+            m_data = static_cast<const char*>(p);
+            m_mapped = true;
+        }
+        ::close(fd);
+#endif
+    }
+
+    TEXT_FILE(const TEXT_FILE &rhs) = delete;
 
-static bool isBlankLine(const std::string &s)
+    ~TEXT_FILE()
+    {
+#ifndef NMF_NO_MMAP
+        if (m_mapped)
+            ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    const char *begin() const { return m_data; }
+
+    const char *end() const { return m_data + m_size; }
+};
+
+/// Single-pass tokenizer over the lines of a NMF file.
+/// Blank lines and those starting with '#' are skipped transparently,
+/// and line numbers are tracked for error reporting.
+class NMF_TOKENIZER
 {
-    for (const auto &e : s)
-        if (!isWhite(e))
-            return false;
-    return true;
-}
+private:
+    const char *m_next; /// Starting of the next line.
+    const char *m_end;
+    const char *m_pos; /// Current position within the current line.
+    const char *m_eol; /// Ending of the current line.
+    size_t m_line; /// 1-based index of the current line.
+    const std::string &m_path;
+
+    static bool isWhite(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    void skip_white()
+    {
+        while (m_pos < m_eol && isWhite(*m_pos))
+            ++m_pos;
+    }
+
+public:
+    NMF_TOKENIZER(const char *first, const char *last, const std::string &path) :
+        m_next(first),
+        m_end(last),
+        m_pos(first),
+        m_eol(first),
+        m_line(0),
+        m_path(path)
+    {}
+
+    /// Move to the next line with contents.
+    /// Return false if the end of file is reached.
+    bool next_line()
+    {
+        while (m_next < m_end)
+        {
+            auto eol = static_cast<const char*>(std::memchr(m_next, '\n', m_end - m_next));
+            if (!eol)
+                eol = m_end;
+            m_pos = m_next;
+            m_eol = eol;
+            m_next = eol == m_end ? m_end : eol + 1;
+            ++m_line;
 
-static bool checkStarting(const std::string &s, char c)
+            skip_white();
+            if (m_pos < m_eol && *m_pos != '#')
+                return true;
+        }
+        return false;
+    }
+
+    /// Next token on the current line, empty if exhausted.
+    std::string_view token()
+    {
+        skip_white();
+        const char *first = m_pos;
+        while (m_pos < m_eol && !isWhite(*m_pos))
+            ++m_pos;
+        return std::string_view(first, m_pos - first);
+    }
+
+    /// Next token on the current line, interpreted as a non-negative integer.
+    size_t integer(const char *what)
+    {
+        const auto t = token();
+        if (t.empty())
+            throw error(std::string("Missing ") + what + ".");
+        size_t val = 0;
+        const auto ret = std::from_chars(t.data(), t.data() + t.size(), val);
+        if (ret.ec != std::errc() || ret.ptr != t.data() + t.size())
+            throw error(std::string("Invalid ") + what + ": \"" + std::string(t) + "\".");
+        return val;
+    }
+
+    /// Ensure nothing is left on the current line.
+    void finish()
+    {
+        const auto t = token();
+        if (!t.empty())
+            throw error("Unexpected trailing contents: \"" + std::string(t) + "\".");
+    }
+
+    std::runtime_error error(const std::string &msg) const
+    {
+        return std::runtime_error("Line " + std::to_string(m_line) + " of \"" + m_path + "\": " + msg);
+    }
+};
+
+/// Union-find over [0, n), safe for concurrent "unite" and "find".
+/// Each set is rooted at its smallest element, thus roots show up first in
+/// a sequential scan. Roots are linked by CAS, and paths are halved on "find".
+class DISJOINT_SET
 {
-    for (const auto &e : s)
+private:
+    std::vector<std::atomic<size_t>> m_parent;
+
+public:
+    explicit DISJOINT_SET(size_t n) :
+        m_parent(n)
     {
-        if (isWhite(e))
-            continue;
-        else
-            return e == c;
+        GridTool::COMMON::parallel_for(n, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+                m_parent[i].store(i, std::memory_order_relaxed);
+        });
     }
-    return false;
-}
+
+    DISJOINT_SET(const DISJOINT_SET &rhs) = delete;
+
+    ~DISJOINT_SET() = default;
+
+    size_t find(size_t x)
+    {
+        while (true)
+        {
+            size_t p = m_parent[x].load();
+            if (p == x)
+                return x;
+            const size_t gp = m_parent[p].load();
+            if (gp != p)
+                m_parent[x].compare_exchange_weak(p, gp);
+            x = gp;
+        }
+    }
+
+    void unite(size_t a, size_t b)
+    {
+        while (true)
+        {
+            a = find(a);
+            b = find(b);
+            if (a == b)
+                return;
+            if (a < b)
+                std::swap(a, b);
+            size_t expected = a;
+            if (m_parent[a].compare_exchange_strong(expected, b))
+                return;
+        }
+    }
+
+    /// Point each element to its root directly, once all the unions are done.
+    /// As parents never come after their children, a single ascending sweep is enough.
+    /// Then "root(x)" is valid until the next "unite".
+    void flatten()
+    {
+        for (size_t i = 0; i < m_parent.size(); ++i)
+        {
+            const size_t p = m_parent[i].load(std::memory_order_relaxed);
+            m_parent[i].store(m_parent[p].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    size_t root(size_t x) const
+    {
+        return m_parent[x].load(std::memory_order_relaxed);
+    }
+};
 
 static void distribute_index(size_t s, size_t e, std::vector<size_t> &dst)
 {
@@ -103,19 +317,11 @@ namespace GridTool::NMF
         std::string x_(x);
         formalize(x_);
 
-        if (!isValidBCStr(x_))
-            throw std::runtime_error("Not found!");
-        else
-        {
-            auto it1 = candidate_idx_set.begin();
-            auto it2 = candidate_str_set.begin();
-            while (x_ != *it2)
-            {
-                ++it1;
-                ++it2;
-            }
-            return *it1;
-        }
+        for (size_t i = 0; i < candidate_str_set.size(); ++i)
+            if (x_ == candidate_str_set[i])
+                return candidate_idx_set[i];
+
+        throw std::runtime_error("Not found!");
     }
 
     CELL::CELL(size_t idx) :
@@ -432,7 +638,9 @@ namespace GridTool::NMF
 
     Block3D::Block3D(int nI, int nJ, int nK) :
         BLOCK(nI, nJ, nK),
-        m_cell(cell_num(), nullptr),
+        m_cell(),
+        m_implicit(false),
+        m_numbering(),
         m_vertex(NumOfVertex),
         m_frame(NumOfFrame),
         m_surf(NumOfSurf)
@@ -443,7 +651,9 @@ namespace GridTool::NMF
 
     Block3D::Block3D(const Block3D &rhs) :
         BLOCK(rhs.IDIM(), rhs.JDIM(), rhs.KDIM()), // Only copy dimensions
-        m_cell(cell_num(), nullptr),
+        m_cell(),
+        m_implicit(false),
+        m_numbering(),
         m_vertex(NumOfVertex),
         m_frame(NumOfFrame),
         m_surf(NumOfSurf)
@@ -459,36 +669,197 @@ namespace GridTool::NMF
 
     void Block3D::release_cell_storage()
     {
-        for (auto &c : m_cell)
-            if (c != nullptr)
-            {
-                delete c;
-                c = nullptr;
-            }
+        std::vector<size_t>().swap(m_cell);
     }
 
+    /// Offsets of nodes within a hex cell in (i, j, k).
+    static const short HEX_NODE_OFFSET[8][3] = {
+        { 0, 0, 0 }, { 0, 0, 1 }, { 1, 0, 1 }, { 1, 0, 0 },
+        { 0, 1, 0 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 0 }
+    };
+
     void Block3D::allocate_cell_storage()
     {
-        for (auto &c : m_cell)
+        m_implicit = false;
+        m_numbering = NUMBERING();
+        m_cell.assign(NumOfCellField * cell_num(), 0);
+    }
+
+    void Block3D::implicit_numbering(NUMBERING &&x)
+    {
+        release_cell_storage();
+        m_numbering = std::move(x);
+        m_implicit = true;
+    }
+
+    void Block3D::explicit_numbering(NUMBERING &&x)
+    {
+        /// Take the layout temporarily, so that indices can be evaluated.
+        implicit_numbering(std::move(x));
+
+        const size_t nI = IDIM(), nJ = JDIM(), nC = cell_num();
+        std::vector<size_t> rec(NumOfCellField * nC);
+
+        /// Cell
+        for (size_t pos = 0; pos < nC; ++pos)
+            rec[pos] = m_numbering.cell + pos + 1;
+
+        /// Node, gathered from the dense map.
+        std::vector<size_t> nodeIndex;
+        node_index_map(nodeIndex);
+        for (short n = 0; n < NumOfVertex; ++n)
         {
-            c = new HEX_CELL();
-            if (!c)
-                throw std::bad_alloc();
+            const auto &d = HEX_NODE_OFFSET[n];
+            size_t *dst = rec.data() + (1 + n) * nC;
+            for (size_t k = 0; k < KDIM() - 1; ++k)
+                for (size_t j = 0; j < nJ - 1; ++j)
+                {
+                    const size_t *src = nodeIndex.data() + d[0] + nI * ((j + d[1]) + nJ * (k + d[2]));
+                    for (size_t i = 0; i < nI - 1; ++i)
+                        *dst++ = src[i];
+                }
+        }
+
+        /// Face
+        for (short r = 1; r <= NumOfSurf; ++r)
+        {
+            size_t *dst = rec.data() + (NumOfVertex + r) * nC;
+            for (size_t k = 1; k < KDIM(); ++k)
+                for (size_t j = 1; j < nJ; ++j)
+                    for (size_t i = 1; i < nI; ++i)
+                        *dst++ = implicit_face_index(i, j, k, r);
         }
+
+        m_cell.swap(rec);
+        m_numbering = NUMBERING();
+        m_implicit = false;
     }
 
-    HEX_CELL &Block3D::cell(size_t i, size_t j, size_t k)
+    bool Block3D::implicit_numbering() const
     {
-        const size_t i0 = i - 1, j0 = j - 1, k0 = k - 1; /// Convert 1-based index to 0-based
-        const size_t idx = i0 + (IDIM() - 1) * (j0 + (JDIM() - 1) * k0);
-        return *m_cell.at(idx);
+        return m_implicit;
     }
 
-    const HEX_CELL &Block3D::cell(size_t i, size_t j, size_t k) const
+    bool Block3D::numbered() const
     {
+        /// Cell indices are 1-based, 0 stands for storage not filled yet.
+        return m_implicit || (!m_cell.empty() && m_cell[0] != 0);
+    }
+
+    size_t Block3D::cell_pos(size_t i, size_t j, size_t k) const
+    {
+        if (i == 0 || j == 0 || k == 0 || i >= IDIM() || j >= JDIM() || k >= KDIM())
+            throw std::out_of_range("Cell (" + std::to_string(i) + ", " + std::to_string(j) + ", " + std::to_string(k) + ") is out of range.");
+        if (m_cell.empty() && !m_implicit)
+            throw std::runtime_error("Cell storage is not allocated.");
+
         const size_t i0 = i - 1, j0 = j - 1, k0 = k - 1; /// Convert 1-based index to 0-based
-        const size_t idx = i0 + (IDIM() - 1) * (j0 + (JDIM() - 1) * k0);
-        return *m_cell.at(idx);
+        return i0 + (IDIM() - 1) * (j0 + (JDIM() - 1) * k0);
+    }
+
+    static std::runtime_error read_only_cell()
+    {
+        return std::runtime_error("Cell records are read-only under implicit numbering.");
+    }
+
+    size_t &Block3D::cell_entry(short n, size_t pos)
+    {
+        if (m_implicit)
+            throw read_only_cell();
+
+        return m_cell[n * cell_num() + pos];
+    }
+
+    Block3D::CELL_REF Block3D::cell(size_t i, size_t j, size_t k)
+    {
+        return CELL_REF(this, cell_pos(i, j, k));
+    }
+
+    Block3D::CONST_CELL_REF Block3D::cell(size_t i, size_t j, size_t k) const
+    {
+        return CONST_CELL_REF(this, cell_pos(i, j, k));
+    }
+
+    size_t *Block3D::cell_field(short n)
+    {
+        if (n < 0 || n >= NumOfCellField)
+            throw std::out_of_range("Cell field " + std::to_string(n) + " does not exist.");
+
+        return m_cell.data() + n * cell_num();
+    }
+
+    const size_t *Block3D::cell_field(short n) const
+    {
+        return const_cast<Block3D*>(this)->cell_field(n);
+    }
+
+    size_t Block3D::CONST_CELL_REF::CellSeq() const
+    {
+        if (m_blk->m_implicit)
+            return m_blk->m_numbering.cell + m_pos + 1;
+        else
+            return m_blk->m_cell[m_pos];
+    }
+
+    size_t Block3D::CONST_CELL_REF::NodeSeq(size_t n) const
+    {
+        if (n < 1 || n > NumOfVertex)
+            throw std::out_of_range("Node " + std::to_string(n) + " does not exist in a hex cell.");
+        if (!m_blk->m_implicit)
+            return m_blk->m_cell[n * m_blk->cell_num() + m_pos];
+
+        const size_t nI = m_blk->IDIM() - 1, nJ = m_blk->JDIM() - 1;
+        const size_t i = m_pos % nI + 1, j = m_pos / nI % nJ + 1, k = m_pos / nI / nJ + 1;
+        const auto &d = HEX_NODE_OFFSET[n - 1];
+        return m_blk->implicit_node_index(i + d[0], j + d[1], k + d[2]);
+    }
+
+    size_t Block3D::CONST_CELL_REF::FaceSeq(size_t n) const
+    {
+        if (n < 1 || n > NumOfSurf)
+            throw std::out_of_range("Face " + std::to_string(n) + " does not exist in a hex cell.");
+        if (!m_blk->m_implicit)
+            return m_blk->m_cell[(NumOfVertex + n) * m_blk->cell_num() + m_pos];
+
+        const size_t nI = m_blk->IDIM() - 1, nJ = m_blk->JDIM() - 1;
+        const size_t i = m_pos % nI + 1, j = m_pos / nI % nJ + 1, k = m_pos / nI / nJ + 1;
+        return m_blk->implicit_face_index(i, j, k, static_cast<short>(n));
+    }
+
+    size_t Block3D::CELL_REF::CellSeq() const
+    {
+        return CONST_CELL_REF(*this).CellSeq();
+    }
+
+    size_t Block3D::CELL_REF::NodeSeq(size_t n) const
+    {
+        return CONST_CELL_REF(*this).NodeSeq(n);
+    }
+
+    size_t Block3D::CELL_REF::FaceSeq(size_t n) const
+    {
+        return CONST_CELL_REF(*this).FaceSeq(n);
+    }
+
+    void Block3D::CELL_REF::setCellSeq(size_t x)
+    {
+        m_blk->cell_entry(0, m_pos) = x;
+    }
+
+    void Block3D::CELL_REF::setNodeSeq(size_t n, size_t x)
+    {
+        if (n < 1 || n > NumOfVertex)
+            throw std::out_of_range("Node " + std::to_string(n) + " does not exist in a hex cell.");
+
+        m_blk->cell_entry(static_cast<short>(n), m_pos) = x;
+    }
+
+    void Block3D::CELL_REF::setFaceSeq(size_t n, size_t x)
+    {
+        if (n < 1 || n > NumOfSurf)
+            throw std::out_of_range("Face " + std::to_string(n) + " does not exist in a hex cell.");
+
+        m_blk->cell_entry(static_cast<short>(NumOfVertex + n), m_pos) = x;
     }
 
     Block3D::VERTEX &Block3D::vertex(short n)
@@ -760,80 +1131,60 @@ namespace GridTool::NMF
 
     size_t &Block3D::surface_face_index(short f, size_t pri, size_t sec)
     {
-        HEX_CELL *p = nullptr;
-
         switch (f)
         {
         case 1:
-            p = &cell(pri, sec, 1);
-            break;
+            return cell_entry(NumOfVertex + f, cell_pos(pri, sec, 1));
         case 2:
-            p = &cell(pri, sec, KDIM() - 1);
-            break;
+            return cell_entry(NumOfVertex + f, cell_pos(pri, sec, KDIM() - 1));
         case 3:
-            p = &cell(1, pri, sec);
-            break;
+            return cell_entry(NumOfVertex + f, cell_pos(1, pri, sec));
         case 4:
-            p = &cell(IDIM() - 1, pri, sec);
-            break;
+            return cell_entry(NumOfVertex + f, cell_pos(IDIM() - 1, pri, sec));
         case 5:
-            p = &cell(sec, 1, pri);
-            break;
+            return cell_entry(NumOfVertex + f, cell_pos(sec, 1, pri));
         case 6:
-            p = &cell(sec, JDIM() - 1, pri);
-            break;
+            return cell_entry(NumOfVertex + f, cell_pos(sec, JDIM() - 1, pri));
         default:
             throw not_a_surface(f);
         }
-        return p->FaceSeq(f);
     }
 
     size_t &Block3D::vertex_node_index(short v)
     {
-        HEX_CELL *p = nullptr;
         switch (v)
-
         {
         case 1:
-            p = &cell(1, 1, 1);
-            break;
+            return cell_entry(v, cell_pos(1, 1, 1));
         case 2:
-            p = &cell(1, 1, KDIM() - 1);
-            break;
+            return cell_entry(v, cell_pos(1, 1, KDIM() - 1));
         case 3:
-            p = &cell(IDIM() - 1, 1, KDIM() - 1);
-            break;
+            return cell_entry(v, cell_pos(IDIM() - 1, 1, KDIM() - 1));
         case 4:
-            p = &cell(IDIM() - 1, 1, 1);
-            break;
+            return cell_entry(v, cell_pos(IDIM() - 1, 1, 1));
         case 5:
-            p = &cell(1, JDIM() - 1, 1);
-            break;
+            return cell_entry(v, cell_pos(1, JDIM() - 1, 1));
         case 6:
-            p = &cell(1, JDIM() - 1, KDIM() - 1);
-            break;
+            return cell_entry(v, cell_pos(1, JDIM() - 1, KDIM() - 1));
         case 7:
-            p = &cell(IDIM() - 1, JDIM() - 1, KDIM() - 1);
-            break;
+            return cell_entry(v, cell_pos(IDIM() - 1, JDIM() - 1, KDIM() - 1));
         case 8:
-            p = &cell(IDIM() - 1, JDIM() - 1, 1);
-            break;
+            return cell_entry(v, cell_pos(IDIM() - 1, JDIM() - 1, 1));
         default:
             throw not_a_vertex(v);
         }
-        return p->NodeSeq(v);
     }
 
     void Block3D::interior_node_occurance(size_t i, size_t j, size_t k, std::vector<size_t*> &oc)
     {
-        oc[0] = &cell(i - 1, j - 1, k - 1).NodeSeq(7);
-        oc[1] = &cell(i, j - 1, k - 1).NodeSeq(6);
-        oc[2] = &cell(i - 1, j, k - 1).NodeSeq(3);
-        oc[3] = &cell(i, j, k - 1).NodeSeq(2);
-        oc[4] = &cell(i - 1, j - 1, k).NodeSeq(8);
-        oc[5] = &cell(i, j - 1, k).NodeSeq(5);
-        oc[6] = &cell(i - 1, j, k).NodeSeq(4);
-        oc[7] = &cell(i, j, k).NodeSeq(1);
+        oc[0] = &cell_entry(7, cell_pos(i - 1, j - 1, k - 1));
+        oc[1] = &cell_entry(6, cell_pos(i, j - 1, k - 1));
+        oc[2] = &cell_entry(3, cell_pos(i - 1, j, k - 1));
+        oc[3] = &cell_entry(2, cell_pos(i, j, k - 1));
+        oc[4] = &cell_entry(8, cell_pos(i - 1, j - 1, k));
+        oc[5] = &cell_entry(5, cell_pos(i, j - 1, k));
+        oc[6] = &cell_entry(4, cell_pos(i - 1, j, k));
+        oc[7] = &cell_entry(1, cell_pos(i, j, k));
     }
 
     void Block3D::surface_node_coordinate(short f, size_t pri_seq, size_t sec_seq, size_t &i, size_t &j, size_t &k)
@@ -883,40 +1234,40 @@ namespace GridTool::NMF
         switch (f)
         {
         case 1:
-            oc[0] = &cell(i, j, k).NodeSeq(1);
-            oc[1] = &cell(i - 1, j, k).NodeSeq(4);
-            oc[2] = &cell(i, j - 1, k).NodeSeq(5);
-            oc[3] = &cell(i - 1, j - 1, k).NodeSeq(8);
+            oc[0] = &cell_entry(1, cell_pos(i, j, k));
+            oc[1] = &cell_entry(4, cell_pos(i - 1, j, k));
+            oc[2] = &cell_entry(5, cell_pos(i, j - 1, k));
+            oc[3] = &cell_entry(8, cell_pos(i - 1, j - 1, k));
             break;
         case 2:
-            oc[0] = &cell(i, j, k - 1).NodeSeq(2);
-            oc[1] = &cell(i - 1, j, k - 1).NodeSeq(3);
-            oc[2] = &cell(i, j - 1, k - 1).NodeSeq(6);
-            oc[3] = &cell(i - 1, j - 1, k - 1).NodeSeq(7);
+            oc[0] = &cell_entry(2, cell_pos(i, j, k - 1));
+            oc[1] = &cell_entry(3, cell_pos(i - 1, j, k - 1));
+            oc[2] = &cell_entry(6, cell_pos(i, j - 1, k - 1));
+            oc[3] = &cell_entry(7, cell_pos(i - 1, j - 1, k - 1));
             break;
         case 3:
-            oc[0] = &cell(i, j, k).NodeSeq(1);
-            oc[1] = &cell(i, j - 1, k).NodeSeq(5);
-            oc[2] = &cell(i, j, k - 1).NodeSeq(2);
-            oc[3] = &cell(i, j - 1, k - 1).NodeSeq(6);
+            oc[0] = &cell_entry(1, cell_pos(i, j, k));
+            oc[1] = &cell_entry(5, cell_pos(i, j - 1, k));
+            oc[2] = &cell_entry(2, cell_pos(i, j, k - 1));
+            oc[3] = &cell_entry(6, cell_pos(i, j - 1, k - 1));
             break;
         case 4:
-            oc[0] = &cell(i - 1, j, k).NodeSeq(4);
-            oc[1] = &cell(i - 1, j - 1, k).NodeSeq(8);
-            oc[2] = &cell(i - 1, j, k - 1).NodeSeq(3);
-            oc[3] = &cell(i - 1, j - 1, k - 1).NodeSeq(7);
+            oc[0] = &cell_entry(4, cell_pos(i - 1, j, k));
+            oc[1] = &cell_entry(8, cell_pos(i - 1, j - 1, k));
+            oc[2] = &cell_entry(3, cell_pos(i - 1, j, k - 1));
+            oc[3] = &cell_entry(7, cell_pos(i - 1, j - 1, k - 1));
             break;
         case 5:
-            oc[0] = &cell(i, j, k).NodeSeq(1);
-            oc[1] = &cell(i - 1, j, k).NodeSeq(4);
-            oc[2] = &cell(i, j, k - 1).NodeSeq(2);
-            oc[3] = &cell(i - 1, j, k - 1).NodeSeq(3);
+            oc[0] = &cell_entry(1, cell_pos(i, j, k));
+            oc[1] = &cell_entry(4, cell_pos(i - 1, j, k));
+            oc[2] = &cell_entry(2, cell_pos(i, j, k - 1));
+            oc[3] = &cell_entry(3, cell_pos(i - 1, j, k - 1));
             break;
         case 6:
-            oc[0] = &cell(i, j - 1, k).NodeSeq(5);
-            oc[1] = &cell(i - 1, j - 1, k).NodeSeq(8);
-            oc[2] = &cell(i, j - 1, k - 1).NodeSeq(6);
-            oc[3] = &cell(i - 1, j - 1, k - 1).NodeSeq(7);
+            oc[0] = &cell_entry(5, cell_pos(i, j - 1, k));
+            oc[1] = &cell_entry(8, cell_pos(i - 1, j - 1, k));
+            oc[2] = &cell_entry(6, cell_pos(i, j - 1, k - 1));
+            oc[3] = &cell_entry(7, cell_pos(i - 1, j - 1, k - 1));
             break;
         default:
             throw not_a_surface(f);
@@ -928,91 +1279,219 @@ namespace GridTool::NMF
         switch (f - 1)
         {
         case 0:
-            oc[0] = &cell(1, 1, idx).NodeSeq(1);
-            oc[1] = &cell(1, 1, idx - 1).NodeSeq(2);
+            oc[0] = &cell_entry(1, cell_pos(1, 1, idx));
+            oc[1] = &cell_entry(2, cell_pos(1, 1, idx - 1));
             break;
         case 1:
-            oc[0] = &cell(IDIM() - 1, 1, idx).NodeSeq(4);
-            oc[1] = &cell(IDIM() - 1, 1, idx - 1).NodeSeq(3);
+            oc[0] = &cell_entry(4, cell_pos(IDIM() - 1, 1, idx));
+            oc[1] = &cell_entry(3, cell_pos(IDIM() - 1, 1, idx - 1));
             break;
         case 2:
-            oc[0] = &cell(IDIM() - 1, JDIM() - 1, idx).NodeSeq(8);
-            oc[1] = &cell(IDIM() - 1, JDIM() - 1, idx - 1).NodeSeq(7);
+            oc[0] = &cell_entry(8, cell_pos(IDIM() - 1, JDIM() - 1, idx));
+            oc[1] = &cell_entry(7, cell_pos(IDIM() - 1, JDIM() - 1, idx - 1));
             break;
         case 3:
-            oc[0] = &cell(1, JDIM() - 1, idx).NodeSeq(5);
-            oc[1] = &cell(1, JDIM() - 1, idx - 1).NodeSeq(6);
+            oc[0] = &cell_entry(5, cell_pos(1, JDIM() - 1, idx));
+            oc[1] = &cell_entry(6, cell_pos(1, JDIM() - 1, idx - 1));
             break;
         case 4:
-            oc[0] = &cell(idx, 1, 1).NodeSeq(1);
-            oc[1] = &cell(idx - 1, 1, 1).NodeSeq(4);
+            oc[0] = &cell_entry(1, cell_pos(idx, 1, 1));
+            oc[1] = &cell_entry(4, cell_pos(idx - 1, 1, 1));
             break;
         case 5:
-            oc[0] = &cell(idx, 1, KDIM() - 1).NodeSeq(2);
-            oc[1] = &cell(idx - 1, 1, KDIM() - 1).NodeSeq(3);
+            oc[0] = &cell_entry(2, cell_pos(idx, 1, KDIM() - 1));
+            oc[1] = &cell_entry(3, cell_pos(idx - 1, 1, KDIM() - 1));
             break;
         case 6:
-            oc[0] = &cell(idx, JDIM() - 1, KDIM() - 1).NodeSeq(6);
-            oc[1] = &cell(idx - 1, JDIM() - 1, KDIM() - 1).NodeSeq(7);
+            oc[0] = &cell_entry(6, cell_pos(idx, JDIM() - 1, KDIM() - 1));
+            oc[1] = &cell_entry(7, cell_pos(idx - 1, JDIM() - 1, KDIM() - 1));
             break;
         case 7:
-            oc[0] = &cell(idx, JDIM() - 1, 1).NodeSeq(5);
-            oc[1] = &cell(idx - 1, JDIM() - 1, 1).NodeSeq(8);
+            oc[0] = &cell_entry(5, cell_pos(idx, JDIM() - 1, 1));
+            oc[1] = &cell_entry(8, cell_pos(idx - 1, JDIM() - 1, 1));
             break;
         case 8:
-            oc[0] = &cell(1, idx, 1).NodeSeq(1);
-            oc[1] = &cell(1, idx - 1, 1).NodeSeq(5);
+            oc[0] = &cell_entry(1, cell_pos(1, idx, 1));
+            oc[1] = &cell_entry(5, cell_pos(1, idx - 1, 1));
             break;
         case 9:
-            oc[0] = &cell(1, idx, KDIM() - 1).NodeSeq(2);
-            oc[1] = &cell(1, idx - 1, KDIM() - 1).NodeSeq(6);
+            oc[0] = &cell_entry(2, cell_pos(1, idx, KDIM() - 1));
+            oc[1] = &cell_entry(6, cell_pos(1, idx - 1, KDIM() - 1));
             break;
         case 10:
-            oc[0] = &cell(IDIM() - 1, idx, KDIM() - 1).NodeSeq(3);
-            oc[1] = &cell(IDIM() - 1, idx - 1, KDIM() - 1).NodeSeq(7);
+            oc[0] = &cell_entry(3, cell_pos(IDIM() - 1, idx, KDIM() - 1));
+            oc[1] = &cell_entry(7, cell_pos(IDIM() - 1, idx - 1, KDIM() - 1));
             break;
         case 11:
-            oc[0] = &cell(IDIM() - 1, idx, 1).NodeSeq(4);
-            oc[1] = &cell(IDIM() - 1, idx - 1, 1).NodeSeq(8);
+            oc[0] = &cell_entry(4, cell_pos(IDIM() - 1, idx, 1));
+            oc[1] = &cell_entry(8, cell_pos(IDIM() - 1, idx - 1, 1));
             break;
         default:
             throw not_a_frame(f);
         }
     }
 
-    size_t Block3D::node_index(size_t i, size_t j, size_t k)
+    size_t Block3D::node_index(size_t i, size_t j, size_t k) const
     {
         if (i == 0 || j == 0 || k == 0)
             throw std::invalid_argument("Should be 1-based index.");
         if (i > IDIM() || j > JDIM() || k > KDIM())
             throw std::invalid_argument("Out of range.");
 
-        const auto v = isVertexNode(i, j, k);
-        if (v != -1)
-            return vertex_node_index(v);
+        if (m_implicit)
+            return implicit_node_index(i, j, k);
+
+        /// Any cell including the node will do.
+        const size_t ci = std::min(i, IDIM() - 1), cj = std::min(j, JDIM() - 1), ck = std::min(k, KDIM() - 1);
+        const short di = static_cast<short>(i - ci), dj = static_cast<short>(j - cj), dk = static_cast<short>(k - ck);
+        for (short n = 0; n < NumOfVertex; ++n)
+        {
+            const auto &d = HEX_NODE_OFFSET[n];
+            if (d[0] == di && d[1] == dj && d[2] == dk)
+                return cell(ci, cj, ck).NodeSeq(n + 1);
+        }
+        throw std::runtime_error("Internal error: node not found in hex cell.");
+    }
+
+    void Block3D::node_index_map(std::vector<size_t> &dst) const
+    {
+        node_index_map(1, KDIM(), dst);
+    }
+
+    void Block3D::node_index_map(size_t kFirst, size_t kLast, std::vector<size_t> &dst) const
+    {
+        const size_t nI = IDIM(), nJ = JDIM(), nK = KDIM();
+        if (kFirst == 0 || kFirst > kLast || kLast > nK)
+            throw std::out_of_range("Invalid node range in K dimension: [" + std::to_string(kFirst) + ", " + std::to_string(kLast) + "].");
+
+        dst.resize(nI * nJ * (kLast - kFirst + 1));
 
-        std::vector<size_t*> c;
+        for (size_t k = kFirst; k <= kLast; ++k)
+            for (size_t j = 1; j <= nJ; ++j)
+            {
+                size_t *row = dst.data() + nI * ((j - 1) + nJ * (k - kFirst));
+
+                if (m_implicit)
+                {
+                    /// Only the 2 ends of a row may be on surfaces if the row itself is inside.
+                    row[0] = implicit_node_index(1, j, k);
+                    if (j > 1 && j < nJ && k > 1 && k < nK)
+                    {
+                        const size_t base = m_numbering.interiorNode + (nI - 2) * ((j - 2) + (nJ - 2) * (k - 2));
+                        for (size_t i = 2; i < nI; ++i)
+                            row[i - 1] = base + i - 1;
+                    }
+                    else
+                    {
+                        for (size_t i = 2; i < nI; ++i)
+                            row[i - 1] = implicit_node_index(i, j, k);
+                    }
+                    row[nI - 1] = implicit_node_index(nI, j, k);
+                }
+                else
+                {
+                    /// Nodes of a row are taken from the same corner of consecutive cells,
+                    /// except the last one.
+                    const size_t cj = std::min(j, nJ - 1), ck = std::min(k, nK - 1);
+                    const short dj = static_cast<short>(j - cj), dk = static_cast<short>(k - ck);
+                    short n0 = -1, n1 = -1;
+                    for (short n = 0; n < NumOfVertex; ++n)
+                    {
+                        const auto &d = HEX_NODE_OFFSET[n];
+                        if (d[1] == dj && d[2] == dk)
+                            (d[0] == 0 ? n0 : n1) = n;
+                    }
+
+                    const size_t pos = (nI - 1) * ((cj - 1) + (nJ - 1) * (ck - 1));
+                    const size_t *src0 = cell_field(1 + n0) + pos;
+                    const size_t *src1 = cell_field(1 + n1) + pos;
+                    std::copy(src0, src0 + nI - 1, row);
+                    row[nI - 1] = src1[nI - 2];
+                }
+            }
+    }
+
+    size_t Block3D::surface_pri_node_num(short s) const
+    {
+        switch (s)
+        {
+        case 1:
+        case 2:
+            return IDIM();
+        case 3:
+        case 4:
+            return JDIM();
+        case 5:
+        case 6:
+            return KDIM();
+        default:
+            throw not_a_surface(s);
+        }
+    }
+
+    size_t Block3D::implicit_surface_face_index(short s, size_t pri, size_t sec) const
+    {
+        const size_t loc = (pri - 1) + (surface_pri_node_num(s) - 1) * (sec - 1);
+        const auto &tab = m_numbering.sharedFace[s - 1];
+        return surf(s).neighbourSurf ? tab.at(loc) : m_numbering.surfFace[s - 1] + loc + 1;
+    }
+
+    size_t Block3D::implicit_face_index(size_t i, size_t j, size_t k, short n) const
+    {
+        /// Interior faces are ordered as in "Mapping3D::numbering_face".
+        const size_t nI = IDIM(), nJ = JDIM(), nK = KDIM();
+        const size_t nKF = (nI - 1) * (nJ - 1) * (nK - 2);
+        const size_t nIF = (nI - 2) * (nJ - 1) * (nK - 1);
+        auto kFace = [&](size_t kk) { return m_numbering.interiorFace + (i - 1) + (nI - 1) * ((j - 1) + (nJ - 1) * (kk - 1)) + 1; };
+        auto iFace = [&](size_t ii) { return m_numbering.interiorFace + nKF + (j - 1) + (nJ - 1) * ((k - 1) + (nK - 1) * (ii - 1)) + 1; };
+        auto jFace = [&](size_t jj) { return m_numbering.interiorFace + nKF + nIF + (k - 1) + (nK - 1) * ((i - 1) + (nI - 1) * (jj - 1)) + 1; };
+
+        switch (n)
+        {
+        case 1:
+            return k > 1 ? kFace(k - 1) : implicit_surface_face_index(1, i, j);
+        case 2:
+            return k < nK - 1 ? kFace(k) : implicit_surface_face_index(2, i, j);
+        case 3:
+            return i > 1 ? iFace(i - 1) : implicit_surface_face_index(3, j, k);
+        case 4:
+            return i < nI - 1 ? iFace(i) : implicit_surface_face_index(4, j, k);
+        case 5:
+            return j > 1 ? jFace(j - 1) : implicit_surface_face_index(5, k, i);
+        case 6:
+            return j < nJ - 1 ? jFace(j) : implicit_surface_face_index(6, k, i);
+        default:
+            throw not_a_surface(n);
+        }
+    }
+
+    size_t Block3D::implicit_node_index(size_t i, size_t j, size_t k) const
+    {
+        const short v = isVertexNode(i, j, k);
+        if (v != -1)
+            return m_numbering.vertexNode[v - 1];
 
         short f;
-        size_t f_idx;
-        isFrameInternalNode(i, j, k, f, f_idx);
+        size_t idx;
+        isFrameInternalNode(i, j, k, f, idx);
         if (f != -1)
         {
-            frame_internal_node_occurace(f, f_idx, c);
-            return *c[0];
+            const size_t itn = frame_internal_node_num(f);
+            const size_t loc = m_numbering.frameReversed[f - 1] ? itn + 1 - idx : idx - 2;
+            return m_numbering.frameNode[f - 1] + loc + 1;
         }
 
         short s;
-        size_t s_pri, s_sec;
-        isSurfaceInternalNode(i, j, k, s, s_pri, s_sec);
+        size_t pri, sec;
+        isSurfaceInternalNode(i, j, k, s, pri, sec);
         if (s != -1)
         {
-            surface_internal_node_occurance(s, s_pri, s_sec, c);
-            return *c[0];
+            const size_t loc = (pri - 2) + (surface_pri_node_num(s) - 2) * (sec - 2);
+            const auto &tab = m_numbering.sharedNode[s - 1];
+            return surf(s).neighbourSurf ? tab.at(loc) : m_numbering.surfNode[s - 1] + loc + 1;
         }
 
-        interior_node_occurance(i, j, k, c);
-        return *c[0];
+        return m_numbering.interiorNode + (i - 2) + (IDIM() - 2) * ((j - 2) + (JDIM() - 2) * (k - 2)) + 1;
     }
 
     short Block3D::isVertexNode(size_t i, size_t j, size_t k) const
@@ -1201,109 +1680,110 @@ namespace GridTool::NMF
 
     void Mapping3D::readFromFile(const std::string &path)
     {
-        std::string s;
-        std::stringstream ss;
-
-        // Open file
-        std::ifstream mfp(path);
-        if (mfp.fail())
-            throw std::runtime_error("Can not open target input file: \"" + path + "\".");
-
-        // Skip header
-        do {
-            std::getline(mfp, s);
-        } while (isBlankLine(s) || checkStarting(s, '#'));
+        const TEXT_FILE src(path);
+        NMF_TOKENIZER tk(src.begin(), src.end(), path);
 
         // Read block nums
-        static const std::regex pattern1(R"(\s*(\d+)\s*)");
-        std::smatch res1;
-        if (std::regex_match(s, res1, pattern1))
-        {
-            int NumOfBlk = std::stoi(res1[1].str());
-            if (NumOfBlk > 0)
+        if (!tk.next_line())
+            throw std::runtime_error("No contents found in \"" + path + "\".");
+        const size_t NumOfBlk = tk.integer("num of blocks");
+        if (NumOfBlk == 0)
+            throw tk.error("Invalid num of blocks: 0.");
+        tk.finish();
+
+        // NOT release any existing resources until it is ensured that this input file is valid.
+        std::vector<Block3D*> blk(NumOfBlk, nullptr);
+        std::vector<ENTRY*> entry;
+        try
+        {
+            // Read dimension info of each block
+            for (size_t i = 0; i < NumOfBlk; ++i)
             {
-                release_all(); // NOT release all existing resources until it is ensured that this input file is valid.
-                m_blk.resize(NumOfBlk, nullptr); // Re-Allocate storage for new recordings.
-            }
-            else
-                throw std::runtime_error("Invalid num of blocks: \"" + res1[1].str() + "\".");
-        }
-        else
-            throw std::runtime_error("Failed to match the single line, where only the num of blocks is specified.");
+                if (!tk.next_line())
+                    throw tk.error("Dimensions of " + std::to_string(NumOfBlk - i) + " block(s) are missing.");
 
-        // Read dimension info of each block
-        static const std::regex pattern2(R"(\s*(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s*)");
-        const auto NumOfBlk = nBlock();
-        for (size_t i = 0; i < NumOfBlk; i++)
-        {
-            std::getline(mfp, s);
-            std::smatch res2;
-            if (std::regex_match(s, res2, pattern2))
-            {
-                const size_t idx = std::stoi(res2[1].str());
+                const size_t idx = tk.integer("order of block");
                 if (idx < 1 || idx > NumOfBlk)
-                    throw std::runtime_error("Invalid order of block: " + std::to_string(idx));
+                    throw tk.error("Invalid order of block: " + std::to_string(idx) + ".");
+                if (blk[idx - 1])
+                    throw tk.error("Block " + std::to_string(idx) + " is specified more than once.");
 
-                const int i_max = std::stoi(res2[2].str());
-                if (i_max < 1)
-                    throw std::runtime_error("Invalid I dimension: " + std::to_string(i_max));
-
-                const int j_max = std::stoi(res2[3].str());
-                if (j_max < 1)
-                    throw std::runtime_error("Invalid J dimension: " + std::to_string(j_max));
-
-                const int k_max = std::stoi(res2[4].str());
-                if (k_max < 1)
-                    throw std::runtime_error("Invalid K dimension: " + std::to_string(k_max));
+                size_t dim[3];
+                for (int j = 0; j < 3; ++j)
+                {
+                    static const char *name[3] = { "I dimension", "J dimension", "K dimension" };
+                    dim[j] = tk.integer(name[j]);
+                    if (dim[j] < 1)
+                        throw tk.error("Invalid " + std::string(name[j]) + ": 0.");
+                }
+                tk.finish();
 
-                auto &e = m_blk(idx);
-                e = new Block3D(i_max, j_max, k_max);
+                auto e = new Block3D(dim[0], dim[1], dim[2]);
+                blk[idx - 1] = e;
                 e->index() = idx;
             }
-            else
-                throw std::runtime_error("Failed to match 4 integers.");
-        }
 
-        // Skip separators
-        while (std::getline(mfp, s))
-        {
-            if (!isBlankLine(s) && !checkStarting(s, '#'))
-                break;
-        }
+            // Read connections
+            while (tk.next_line())
+            {
+                std::string bc_str(tk.token());
+                formalize(bc_str);
+                if (!BC::isValidBCStr(bc_str))
+                    throw tk.error("B.C. named \"" + bc_str + "\" is not supported.");
+
+                const int nSide = BC::str2idx(bc_str) == BC::ONE_TO_ONE ? 2 : 1;
+                size_t cB[2], cS1[2], cE1[2], cS2[2], cE2[2];
+                short cF[2];
+                for (int i = 0; i < nSide; ++i)
+                {
+                    cB[i] = tk.integer("block index");
+                    const size_t f = tk.integer("face index");
+                    if (f < 1 || f > Block3D::NumOfSurf)
+                        throw tk.error("Invalid face index: " + std::to_string(f) + ".");
+                    cF[i] = static_cast<short>(f);
+                    cS1[i] = tk.integer("primary starting index");
+                    cE1[i] = tk.integer("primary ending index");
+                    cS2[i] = tk.integer("secondary starting index");
+                    cE2[i] = tk.integer("secondary ending index");
+                }
 
-        // Read connections
-        if (!mfp.eof())
-        {
-            do {
-                formalize(s);
-                ss.clear();
-                ss << s;
-                std::string bc_str;
-                ss >> bc_str;
-                if (BC::str2idx(bc_str) == BC::ONE_TO_ONE)
+                bool swp = false;
+                if (nSide == 2)
                 {
-                    size_t cB[2];
-                    short cF[2];
-                    size_t cS1[2], cE1[2], cS2[2], cE2[2];
-                    std::string swp;
-                    for (int i = 0; i < 2; i++)
-                        ss >> cB[i] >> cF[i] >> cS1[i] >> cE1[i] >> cS2[i] >> cE2[i];
-                    ss >> swp;
-                    add_entry(bc_str, cB[0], cF[0], cS1[0], cE1[0], cS2[0], cE2[0], cB[1], cF[1], cS1[1], cE1[1], cS2[1], cE2[1], swp == "TRUE");
+                    std::string swp_str(tk.token());
+                    formalize(swp_str);
+                    if (swp_str == "TRUE")
+                        swp = true;
+                    else if (!swp_str.empty() && swp_str != "FALSE")
+                        throw tk.error("Invalid swap flag: \"" + swp_str + "\".");
                 }
-                else
+                tk.finish();
+
+                try
                 {
-                    size_t cB;
-                    short cF;
-                    size_t cS1, cE1, cS2, cE2;
-                    ss >> cB >> cF >> cS1 >> cE1 >> cS2 >> cE2;
-                    add_entry(bc_str, cB, cF, cS1, cE1, cS2, cE2);
+                    if (nSide == 2)
+                        entry.push_back(new DoubleSideEntry(bc_str, cB[0], cF[0], cS1[0], cE1[0], cS2[0], cE2[0], cB[1], cF[1], cS1[1], cE1[1], cS2[1], cE2[1], swp));
+                    else
+                        entry.push_back(new SingleSideEntry(bc_str, cB[0], cF[0], cS1[0], cE1[0], cS2[0], cE2[0]));
                 }
-            } while (std::getline(mfp, s));
+                catch (const std::exception &e)
+                {
+                    throw tk.error(e.what());
+                }
+            }
+        }
+        catch (...)
+        {
+            for (auto e : blk)
+                delete e;
+            for (auto e : entry)
+                delete e;
+            throw;
         }
 
-        // Close input file
-        mfp.close();
+        release_all();
+        m_blk.assign(blk.begin(), blk.end());
+        m_entry.assign(entry.begin(), entry.end());
     }
 
     void Mapping3D::compute_topology()
@@ -1311,7 +1791,9 @@ namespace GridTool::NMF
         connecting();
 
         const int nsf = coloring_surface();
-        if (nsf < Block3D::NumOfSurf)
+        size_t nSa = 0, nSi = 0, nSb = 0;
+        nSurface(nSa, nSi, nSb);
+        if (static_cast<size_t>(nsf) != nSa)
             throw std::runtime_error("Internal error occured when counting surfaces.");
         m_surf.resize(nsf);
         for (auto &e : m_surf)
@@ -1324,11 +1806,20 @@ namespace GridTool::NMF
             }
 
         const int nfm = coloring_frame();
-        if (nfm < Block3D::NumOfFrame)
+        if (nfm <= 0)
             throw std::runtime_error("Internal error occured when counting frames.");
         m_frame.resize(nfm);
-        for (auto &e : m_frame)
-            e.clear();
+        {
+            std::vector<size_t> occurrence(nfm, 0);
+            for (auto b : m_blk)
+                for (short i = 1; i <= Block3D::NumOfFrame; ++i)
+                    ++occurrence[b->frame(i).global_index - 1];
+            for (int i = 0; i < nfm; ++i)
+            {
+                m_frame[i].clear();
+                m_frame[i].reserve(occurrence[i]);
+            }
+        }
         for (auto b : m_blk)
             for (short i = 1; i <= Block3D::NumOfFrame; ++i)
             {
@@ -1337,11 +1828,20 @@ namespace GridTool::NMF
             }
 
         const int nvt = coloring_vertex();
-        if (nvt < Block3D::NumOfVertex)
+        if (nvt <= 0)
             throw std::runtime_error("Internal error occured when counting vertexes.");
         m_vertex.resize(nvt);
-        for (auto &e : m_vertex)
-            e.clear();
+        {
+            std::vector<size_t> occurrence(nvt, 0);
+            for (auto b : m_blk)
+                for (short i = 1; i <= Block3D::NumOfVertex; ++i)
+                    ++occurrence[b->vertex(i).global_index - 1];
+            for (int i = 0; i < nvt; ++i)
+            {
+                m_vertex[i].clear();
+                m_vertex[i].reserve(occurrence[i]);
+            }
+        }
         for (auto b : m_blk)
             for (short i = 1; i <= Block3D::NumOfVertex; ++i)
             {
@@ -1438,14 +1938,31 @@ namespace GridTool::NMF
         out << "========================================== END =========================================" << std::endl;
     }
 
-    void Mapping3D::numbering()
+    void Mapping3D::numbering(bool implicit)
     {
-        for (auto b : m_blk)
-            b->allocate_cell_storage();
+        /// Ranges of each block are counted and scanned first,
+        /// then blocks are filled independently.
+        std::vector<Block3D::NUMBERING> num;
+        numbering_layout(num);
+
+        COMMON::parallel_for(nBlock(), [&](size_t first, size_t last)
+        {
+            for (size_t n = first; n < last; ++n)
+            {
+                if (implicit)
+                    m_blk[n]->implicit_numbering(std::move(num[n]));
+                else
+                    m_blk[n]->explicit_numbering(std::move(num[n]));
+            }
+        });
+    }
 
-        numbering_cell();
-        numbering_face();
-        numbering_node();
+    bool Mapping3D::numbered() const
+    {
+        for (auto b : m_blk)
+            if (!b->numbered())
+                return false;
+        return true;
     }
 
     void Mapping3D::writeToFile(const std::string &path)
@@ -1589,179 +2106,79 @@ namespace GridTool::NMF
         m_entry.clear();
     }
 
+    /// Corners of a surface in its local (pri, sec) frame, in the order of "includedVertex".
+    static const short SURF_CORNER[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+    /// Frames of a surface in the order of "includedFrame", each goes
+    /// from the 1st corner to the 2nd one along its own increasing direction.
+    static const short SURF_FRAME_CORNER[4][2] = { { 0, 1 }, { 1, 2 }, { 3, 2 }, { 0, 3 } };
+
     void Mapping3D::connecting()
     {
         for (auto e : m_entry)
         {
-            if (e->Type() == BC::ONE_TO_ONE)
+            if (e->Type() != BC::ONE_TO_ONE)
+                continue;
+
+            auto p = static_cast<DoubleSideEntry*>(e);
+            const auto &rg1 = p->Range1();
+            const auto &rg2 = p->Range2();
+            auto B1 = m_blk(rg1.B());
+            auto B2 = m_blk(rg2.B());
+            auto F1 = &B1->surf(rg1.F());
+            auto F2 = &B2->surf(rg2.F());
+
+            // Only interfaces covering whole surfaces are supported in topology.
+            for (auto rg : { &rg1, &rg2 })
             {
-                auto p = dynamic_cast<DoubleSideEntry*>(e);
-                auto B1 = m_blk(p->Range1().B());
-                auto B2 = m_blk(p->Range2().B());
-                auto F1 = &B1->surf(p->Range1().F());
-                auto F2 = &B2->surf(p->Range2().F());
-
-                // Surface connectivity
-                F1->neighbourSurf = F2;
-                F2->neighbourSurf = F1;
-
-                // Counterpart concerning frames on each surface.
-                // There're 4 possible mapping cases.
+                const auto b = m_blk(rg->B());
+                if (rg->pri_node_num() != b->surface_pri_node_num(rg->F()) || rg->node_num() != b->surface_node_num(rg->F()))
+                    throw std::runtime_error("Partial interface on surface " + std::to_string(rg->F()) + " of block " + std::to_string(rg->B()) + " is not supported.");
+            }
+
+            // Surface connectivity
+            F1->neighbourSurf = F2;
+            F2->neighbourSurf = F1;
+
+            // Each direction of F1 runs along the same direction of F2, or the other one
+            // when swapped, and the 2 directions may be flipped independently, as is
+            // determined by comparing the trends of corresponding ranges.
+            const bool flipPri = rg1.pri_trend() != (p->Swap() ? rg2.sec_trend() : rg2.pri_trend());
+            const bool flipSec = rg1.sec_trend() != (p->Swap() ? rg2.pri_trend() : rg2.sec_trend());
+            short corner[4]; // Counterpart on F2 of each corner on F1.
+            for (short q = 0; q < 4; ++q)
+            {
+                short pri = SURF_CORNER[q][0] ^ flipPri;
+                short sec = SURF_CORNER[q][1] ^ flipSec;
                 if (p->Swap())
-                {
-                    // When the primary directions of F1 and F2 are not aligned,
-                    // the primary direction of F1 goes parallel with the secondary
-                    // direction of F2, and the secondary direction of F1 goes
-                    // parallel with the primary direction of F2. However, under
-                    // the right-hand convention, there're 2 further possibilities:
-                    // one is the primary direction of F1 and the secondary direction
-                    // of F2 not only go parallel, but also run in the same direction,
-                    // in this case, the remaining pair MUST runs in different direction;
-                    // the other is the primary direction of F1 and the secondary
-                    // direction of F2 go parallel, but run in different direction,
-                    // in this case, the remaining pair MUST run in same direction.
-                    // The exact case is determined by checking the trend of
-                    // corresponding ranges.
-
-                    if (p->Range1().pri_trend() == p->Range2().sec_trend()) // case 1
-                    {
-                        F1->counterpartFrame[0] = F2->includedFrame[1];
-                        F1->counterpartFrame[1] = F2->includedFrame[2];
-                        F1->counterpartFrame[2] = F2->includedFrame[3];
-                        F1->counterpartFrame[3] = F2->includedFrame[0];
-
-                        F1->counterpartFrameIsOpposite[0] = false;
-                        F1->counterpartFrameIsOpposite[1] = true;
-                        F1->counterpartFrameIsOpposite[2] = false;
-                        F1->counterpartFrameIsOpposite[3] = true;
-
-                        F2->counterpartFrame[0] = F1->includedFrame[3];
-                        F2->counterpartFrame[1] = F1->includedFrame[0];
-                        F2->counterpartFrame[2] = F1->includedFrame[1];
-                        F2->counterpartFrame[3] = F1->includedFrame[2];
-
-                        F2->counterpartFrameIsOpposite[0] = true;
-                        F2->counterpartFrameIsOpposite[1] = false;
-                        F2->counterpartFrameIsOpposite[2] = true;
-                        F2->counterpartFrameIsOpposite[3] = false;
-
-                        F1->counterpartVertex[0] = F2->includedVertex[1];
-                        F1->counterpartVertex[1] = F2->includedVertex[2];
-                        F1->counterpartVertex[2] = F2->includedVertex[3];
-                        F1->counterpartVertex[3] = F2->includedVertex[0];
-
-                        F2->counterpartVertex[0] = F1->includedVertex[3];
-                        F2->counterpartVertex[1] = F1->includedVertex[0];
-                        F2->counterpartVertex[2] = F1->includedVertex[1];
-                        F2->counterpartVertex[3] = F1->includedVertex[2];
-                    }
-                    else // case 2
-                    {
-                        F1->counterpartFrame[0] = F2->includedFrame[3];
-                        F1->counterpartFrame[1] = F2->includedFrame[0];
-                        F1->counterpartFrame[2] = F2->includedFrame[1];
-                        F1->counterpartFrame[3] = F2->includedFrame[2];
-
-                        F1->counterpartFrameIsOpposite[0] = true;
-                        F1->counterpartFrameIsOpposite[1] = false;
-                        F1->counterpartFrameIsOpposite[2] = true;
-                        F1->counterpartFrameIsOpposite[3] = false;
-
-                        F2->counterpartFrame[0] = F1->includedFrame[1];
-                        F2->counterpartFrame[1] = F1->includedFrame[2];
-                        F2->counterpartFrame[2] = F1->includedFrame[3];
-                        F2->counterpartFrame[3] = F1->includedFrame[0];
-
-                        F2->counterpartFrameIsOpposite[0] = false;
-                        F2->counterpartFrameIsOpposite[1] = true;
-                        F2->counterpartFrameIsOpposite[2] = false;
-                        F2->counterpartFrameIsOpposite[3] = true;
-
-                        F1->counterpartVertex[0] = F2->includedVertex[3];
-                        F1->counterpartVertex[1] = F2->includedVertex[0];
-                        F1->counterpartVertex[2] = F2->includedVertex[1];
-                        F1->counterpartVertex[3] = F2->includedVertex[2];
-
-                        F2->counterpartVertex[0] = F1->includedVertex[1];
-                        F2->counterpartVertex[1] = F1->includedVertex[2];
-                        F2->counterpartVertex[2] = F1->includedVertex[3];
-                        F2->counterpartVertex[3] = F1->includedVertex[0];
-                    }
-                }
-                else
-                {
-                    // Even the primary directions of F1 and F2 are aligned, 
-                    // they may be in opposite directions. This is further deteced 
-                    // by the compare the trend from S1 to E1 in F1 with that in F2. 
-                    // If these 2 trends are the same, the 2 primary directions are 
-                    // not only parallel but also in the same directions, otherwise, 
-                    // they are only parallel, but runs in different directions.
-
-                    if (p->Range1().pri_trend() != p->Range2().pri_trend()) // Parallel, but goes in opposite direction.
-                    {
-                        F1->counterpartFrame[0] = F2->includedFrame[2];
-                        F1->counterpartFrame[1] = F2->includedFrame[3];
-                        F1->counterpartFrame[2] = F2->includedFrame[0];
-                        F1->counterpartFrame[3] = F2->includedFrame[1];
-
-                        F1->counterpartFrameIsOpposite[0] = true;
-                        F1->counterpartFrameIsOpposite[1] = true;
-                        F1->counterpartFrameIsOpposite[2] = true;
-                        F1->counterpartFrameIsOpposite[3] = true;
-
-                        F2->counterpartFrame[0] = F1->includedFrame[2];
-                        F2->counterpartFrame[1] = F1->includedFrame[3];
-                        F2->counterpartFrame[2] = F1->includedFrame[0];
-                        F2->counterpartFrame[3] = F1->includedFrame[1];
-
-                        F2->counterpartFrameIsOpposite[0] = true;
-                        F2->counterpartFrameIsOpposite[1] = true;
-                        F2->counterpartFrameIsOpposite[2] = true;
-                        F2->counterpartFrameIsOpposite[3] = true;
-
-                        F1->counterpartVertex[0] = F2->includedVertex[2];
-                        F1->counterpartVertex[1] = F2->includedVertex[3];
-                        F1->counterpartVertex[2] = F2->includedVertex[0];
-                        F1->counterpartVertex[3] = F2->includedVertex[1];
-
-                        F2->counterpartVertex[0] = F1->includedVertex[2];
-                        F2->counterpartVertex[1] = F1->includedVertex[3];
-                        F2->counterpartVertex[2] = F1->includedVertex[0];
-                        F2->counterpartVertex[3] = F1->includedVertex[1];
-                    }
-                    else // Parallel, and goes in the same direction.
-                    {
-                        F1->counterpartFrame[0] = F2->includedFrame[0];
-                        F1->counterpartFrame[1] = F2->includedFrame[1];
-                        F1->counterpartFrame[2] = F2->includedFrame[2];
-                        F1->counterpartFrame[3] = F2->includedFrame[3];
-
-                        F1->counterpartFrameIsOpposite[0] = false;
-                        F1->counterpartFrameIsOpposite[1] = false;
-                        F1->counterpartFrameIsOpposite[2] = false;
-                        F1->counterpartFrameIsOpposite[3] = false;
-
-                        F2->counterpartFrame[0] = F1->includedFrame[0];
-                        F2->counterpartFrame[1] = F1->includedFrame[1];
-                        F2->counterpartFrame[2] = F1->includedFrame[2];
-                        F2->counterpartFrame[3] = F1->includedFrame[3];
-
-                        F2->counterpartFrameIsOpposite[0] = false;
-                        F2->counterpartFrameIsOpposite[1] = false;
-                        F2->counterpartFrameIsOpposite[2] = false;
-                        F2->counterpartFrameIsOpposite[3] = false;
-
-                        F1->counterpartVertex[0] = F2->includedVertex[0];
-                        F1->counterpartVertex[1] = F2->includedVertex[1];
-                        F1->counterpartVertex[2] = F2->includedVertex[2];
-                        F1->counterpartVertex[3] = F2->includedVertex[3];
-
-                        F2->counterpartVertex[0] = F1->includedVertex[0];
-                        F2->counterpartVertex[1] = F1->includedVertex[1];
-                        F2->counterpartVertex[2] = F1->includedVertex[2];
-                        F2->counterpartVertex[3] = F1->includedVertex[3];
-                    }
-                }
+                    std::swap(pri, sec);
+                corner[q] = 0;
+                while (SURF_CORNER[corner[q]][0] != pri || SURF_CORNER[corner[q]][1] != sec)
+                    ++corner[q];
+            }
+
+            // Counterpart concerning vertexes on each surface.
+            for (short q = 0; q < 4; ++q)
+            {
+                F1->counterpartVertex[q] = F2->includedVertex[corner[q]];
+                F2->counterpartVertex[corner[q]] = F1->includedVertex[q];
+            }
+
+            // Counterpart concerning frames on each surface, which are opposite
+            // if the starting corner is not mapped to the starting one.
+            for (short i = 0; i < 4; ++i)
+            {
+                const short c0 = corner[SURF_FRAME_CORNER[i][0]];
+                const short c1 = corner[SURF_FRAME_CORNER[i][1]];
+                short j = 0;
+                while (std::minmax(SURF_FRAME_CORNER[j][0], SURF_FRAME_CORNER[j][1]) != std::minmax(c0, c1))
+                    ++j;
+                const bool opposite = SURF_FRAME_CORNER[j][0] != c0;
+
+                F1->counterpartFrame[i] = F2->includedFrame[j];
+                F1->counterpartFrameIsOpposite[i] = opposite;
+                F2->counterpartFrame[j] = F1->includedFrame[i];
+                F2->counterpartFrameIsOpposite[j] = opposite;
             }
         }
     }
@@ -1787,457 +2204,270 @@ namespace GridTool::NMF
 
     int Mapping3D::coloring_frame()
     {
-        int global_cnt = 0;
-        for (auto b : m_blk)
+        /// Each frame takes 2 elements, "2n" for itself and "2n+1" for its reversed copy,
+        /// so that counterparts running in opposite directions are joined crosswise.
+        const size_t nFrm = nBlock() * Block3D::NumOfFrame;
+        DISJOINT_SET ds(2 * nFrm);
+        COMMON::parallel_for(m_entry.size(), [&](size_t first, size_t last)
         {
-            for (short j = 1; j <= Block3D::NumOfFrame; ++j)
+            for (size_t n = first; n < last; ++n)
             {
-                auto e = &b->frame(j);
-                if (e->global_index != 0)
+                if (m_entry[n]->Type() != BC::ONE_TO_ONE)
                     continue;
 
-                ++global_cnt;
-                std::queue<Block3D::FRAME*> q;
-                q.push(e);
-
-                // BFS
-                while (!q.empty())
+                /// Counterparts are symmetric, see "connecting".
+                auto p = static_cast<const DoubleSideEntry*>(m_entry[n]);
+                const size_t b1 = p->Range1().B() - 1, b2 = p->Range2().B() - 1;
+                const auto &sf = m_blk[b1]->surf(p->Range1().F());
+                for (int i = 0; i < 4; ++i)
                 {
-                    auto ce = q.front();
-                    q.pop();
-                    ce->global_index = global_cnt;
-
-                    for (auto sf : ce->dependentSurf)
-                    {
-                        if (!sf)
-                            throw std::runtime_error("Dependent surface of a frame should NOT be empty.");
-
-                        if (sf->neighbourSurf)
-                        {
-                            Block3D::FRAME *t = nullptr;
-                            for (int ii = 0; ii < 4; ++ii)
-                                if (sf->includedFrame[ii] == ce)
-                                {
-                                    t = sf->counterpartFrame[ii];
-                                    break;
-                                }
-                            if (!t)
-                                throw std::runtime_error("Internal error.");
-
-                            if (t->global_index == 0)
-                                q.push(t);
-                        }
-                    }
+                    const size_t e1 = b1 * Block3D::NumOfFrame + sf.includedFrame[i]->local_index - 1;
+                    const size_t e2 = b2 * Block3D::NumOfFrame + sf.counterpartFrame[i]->local_index - 1;
+                    const size_t flip = sf.counterpartFrameIsOpposite[i] ? 1 : 0;
+                    ds.unite(2 * e1, 2 * e2 + flip);
+                    ds.unite(2 * e1 + 1, 2 * e2 + 1 - flip);
                 }
             }
-        }
+        });
+
+        ds.flatten();
+
+        /// The 1st frame of each group is the root, either by itself or by its reversed copy.
+        std::vector<int> label(nFrm, 0);
+        COMMON::parallel_for(nFrm, [&](size_t first, size_t last)
+        {
+            for (size_t n = first; n < last; ++n)
+            {
+                const size_t r = ds.root(2 * n);
+                if (ds.root(2 * n + 1) == r)
+                    throw std::runtime_error("Inconsistent orientation of frames in block " + std::to_string(n / Block3D::NumOfFrame + 1) + ".");
+                if (r == 2 * n)
+                    label[n] = 1;
+            }
+        });
+        int global_cnt = 0;
+        for (auto &e : label)
+            if (e)
+                e = ++global_cnt;
+
+        COMMON::parallel_for(nFrm, [&](size_t first, size_t last)
+        {
+            for (size_t n = first; n < last; ++n)
+            {
+                const size_t r = ds.root(2 * n);
+                auto &e = m_blk[n / Block3D::NumOfFrame]->frame(n % Block3D::NumOfFrame + 1);
+                e.global_index = label[r / 2];
+                e.opposite = r % 2 == 1;
+            }
+        });
         return global_cnt; // The total num of block frames.
     }
 
     int Mapping3D::coloring_vertex()
     {
-        int global_cnt = 0;
-        for (auto b : m_blk)
+        const size_t nVtx = nBlock() * Block3D::NumOfVertex;
+        DISJOINT_SET ds(nVtx);
+        COMMON::parallel_for(m_entry.size(), [&](size_t first, size_t last)
         {
-            for (short j = 1; j <= Block3D::NumOfVertex; ++j)
+            for (size_t n = first; n < last; ++n)
             {
-                auto v = &b->vertex(j);
-                if (v->global_index != 0)
+                if (m_entry[n]->Type() != BC::ONE_TO_ONE)
                     continue;
 
-                ++global_cnt;
-                std::stack<Block3D::VERTEX*> s;
-                s.push(v);
-
-                // DFS
-                while (!s.empty())
+                auto p = static_cast<const DoubleSideEntry*>(m_entry[n]);
+                const size_t b1 = p->Range1().B() - 1, b2 = p->Range2().B() - 1;
+                const auto &sf = m_blk[b1]->surf(p->Range1().F());
+                for (int i = 0; i < 4; ++i)
                 {
-                    auto cv = s.top();
-                    s.pop();
-                    cv->global_index = global_cnt;
-
-                    for (auto sf : cv->dependentSurf)
-                    {
-                        if (!sf)
-                            throw std::runtime_error("Dependent surface of a vertex should NOT be empty.");
-
-                        if (sf->neighbourSurf)
-                        {
-                            Block3D::VERTEX *t = nullptr;
-                            for (int ii = 0; ii < 4; ++ii)
-                                if (sf->includedVertex[ii] == cv)
-                                {
-                                    t = sf->counterpartVertex[ii];
-                                    break;
-                                }
-                            if (!t)
-                                throw std::runtime_error("Counterpart vertex should exist.");
-
-                            if (t->global_index == 0)
-                                s.push(t);
-                        }
-                    }
+                    const size_t v1 = b1 * Block3D::NumOfVertex + sf.includedVertex[i]->local_index - 1;
+                    const size_t v2 = b2 * Block3D::NumOfVertex + sf.counterpartVertex[i]->local_index - 1;
+                    ds.unite(v1, v2);
                 }
             }
-        }
+        });
+
+        ds.flatten();
+
+        std::vector<int> label(nVtx, 0);
+        COMMON::parallel_for(nVtx, [&](size_t first, size_t last)
+        {
+            for (size_t n = first; n < last; ++n)
+                if (ds.root(n) == n)
+                    label[n] = 1;
+        });
+        int global_cnt = 0;
+        for (auto &e : label)
+            if (e)
+                e = ++global_cnt;
+
+        COMMON::parallel_for(nVtx, [&](size_t first, size_t last)
+        {
+            for (size_t n = first; n < last; ++n)
+            {
+                auto &v = m_blk[n / Block3D::NumOfVertex]->vertex(n % Block3D::NumOfVertex + 1);
+                v.global_index = label[ds.root(n)];
+            }
+        });
         return global_cnt;
     }
 
-    void Mapping3D::numbering_cell()
+    template<typename F>
+    void Mapping3D::interface_traverse(const DoubleSideEntry *p, bool isNode, F &&f) const
     {
-        const auto totalCellNum = nCell();
+        const auto &rg1 = p->Range1();
+        const auto &rg2 = p->Range2();
 
-        size_t cnt = 0;
-        for (auto b : m_blk)
-            for (size_t k = 1; k < b->KDIM(); ++k)
-                for (size_t j = 1; j < b->JDIM(); ++j)
-                    for (size_t i = 1; i < b->IDIM(); ++i)
-                        b->cell(i, j, k).CellSeq() = ++cnt;
+        std::vector<size_t> b1_dim_pri, b1_dim_sec, b2_dim_pri, b2_dim_sec;
+        distribute_index(rg1.S1(), rg1.E1(), b1_dim_pri);
+        distribute_index(rg1.S2(), rg1.E2(), b1_dim_sec);
+        distribute_index(rg2.S1(), rg2.E1(), b2_dim_pri);
+        distribute_index(rg2.S2(), rg2.E2(), b2_dim_sec);
+        if (p->Swap())
+            std::swap(b2_dim_pri, b2_dim_sec);
 
-        if (cnt != totalCellNum)
-            throw std::length_error("Inconsistent num of cells.");
+        if (b1_dim_pri.size() != b2_dim_pri.size() || b1_dim_sec.size() != b2_dim_sec.size())
+            throw std::runtime_error("Inconsistent num of nodes.");
+
+        const auto n1 = rg1.pri_node_num();
+        const auto n2 = rg1.sec_node_num();
+
+        /// Internal nodes are taken as is, while faces are identified by the
+        /// cell between 2 consecutive nodes, which has the smaller index.
+        auto at = [isNode](const std::vector<size_t> &d, size_t l)
+        {
+            return isNode ? d[l - 1] : std::min(d[l - 1], d[l]);
+        };
+        const size_t first = isNode ? 2 : 1;
+
+        for (size_t l1 = first; l1 <= n1 - 1; ++l1)
+            for (size_t l2 = first; l2 <= n2 - 1; ++l2)
+            {
+                const auto b1i1 = at(b1_dim_pri, l1);
+                const auto b1i2 = at(b1_dim_sec, l2);
+                const auto b2i1 = at(b2_dim_pri, l1);
+                const auto b2i2 = at(b2_dim_sec, l2);
+                if (p->Swap())
+                    f(b1i1, b1i2, b2i2, b2i1);
+                else
+                    f(b1i1, b1i2, b2i1, b2i2);
+            }
     }
 
-    void Mapping3D::numbering_face()
+    void Mapping3D::numbering_layout(std::vector<Block3D::NUMBERING> &num) const
     {
-        size_t totalFaceNum = 0, innerFaceNum = 0, bdryFaceNum = 0;
-        nFace(totalFaceNum, innerFaceNum, bdryFaceNum);
+        num.assign(nBlock(), Block3D::NUMBERING());
+        for (size_t n = 0; n < nBlock(); ++n)
+        {
+            const auto b = m_blk[n];
+            for (short s = 1; s <= Block3D::NumOfSurf; ++s)
+            {
+                if (b->surf(s).neighbourSurf)
+                {
+                    num[n].sharedFace[s - 1].assign(b->surface_face_num(s), 0);
+                    num[n].sharedNode[s - 1].assign(b->surface_internal_node_num(s), 0);
+                }
+            }
+        }
 
+        /// Cells
         size_t cnt = 0;
-        for (auto b : m_blk)
+        for (size_t n = 0; n < nBlock(); ++n)
         {
-            /* Internal faces */
-            // K - direction
-            for (size_t k = 1; k <= b->KDIM() - 2; ++k)
-                for (size_t j = 1; j <= b->JDIM() - 1; ++j)
-                    for (size_t i = 1; i <= b->IDIM() - 1; ++i)
-                        b->cell(i, j, k + 1).FaceSeq(1) = b->cell(i, j, k).FaceSeq(2) = ++cnt;
-
-            // I - direction
-            for (size_t i = 1; i <= b->IDIM() - 2; ++i)
-                for (size_t k = 1; k <= b->KDIM() - 1; ++k)
-                    for (size_t j = 1; j <= b->JDIM() - 1; ++j)
-                        b->cell(i + 1, j, k).FaceSeq(3) = b->cell(i, j, k).FaceSeq(4) = ++cnt;
-
-            // J - direction
-            for (size_t j = 1; j <= b->JDIM() - 2; ++j)
-                for (size_t i = 1; i <= b->IDIM() - 1; ++i)
-                    for (size_t k = 1; k <= b->KDIM() - 1; ++k)
-                        b->cell(i, j + 1, k).FaceSeq(5) = b->cell(i, j, k).FaceSeq(6) = ++cnt;
-
-            /* External faces */
-            // Single-Sided
-            for (short f = 1; f <= Block3D::NumOfSurf; ++f)
+            num[n].cell = cnt;
+            cnt += m_blk[n]->cell_num();
+        }
+        if (cnt != nCell())
+            throw std::length_error("Inconsistent num of cells.");
+
+        /// Faces
+        size_t totalFaceNum = 0, innerFaceNum = 0, bdryFaceNum = 0;
+        nFace(totalFaceNum, innerFaceNum, bdryFaceNum);
+        cnt = 0;
+        for (size_t n = 0; n < nBlock(); ++n)
+        {
+            const auto b = m_blk[n];
+            num[n].interiorFace = cnt;
+            cnt += b->face_num() - b->shell_face_num();
+            for (short s = 1; s <= Block3D::NumOfSurf; ++s)
             {
-                auto &sf = b->surf(f);
-                if (!sf.neighbourSurf)
+                if (!b->surf(s).neighbourSurf)
                 {
-                    if (sf.local_index == 1)
-                    {
-                        for (size_t j = 1; j <= b->JDIM() - 1; ++j)
-                            for (size_t i = 1; i <= b->IDIM() - 1; ++i)
-                                b->cell(i, j, 1).FaceSeq(1) = ++cnt;
-                    }
-                    else if (sf.local_index == 2)
-                    {
-                        for (size_t j = 1; j <= b->JDIM() - 1; ++j)
-                            for (size_t i = 1; i <= b->IDIM() - 1; ++i)
-                                b->cell(i, j, b->KDIM() - 1).FaceSeq(2) = ++cnt;
-                    }
-                    else if (sf.local_index == 3)
-                    {
-                        for (size_t k = 1; k <= b->KDIM() - 1; ++k)
-                            for (size_t j = 1; j <= b->JDIM() - 1; ++j)
-                                b->cell(1, j, k).FaceSeq(3) = ++cnt;
-                    }
-                    else if (sf.local_index == 4)
-                    {
-                        for (size_t k = 1; k <= b->KDIM() - 1; ++k)
-                            for (size_t j = 1; j <= b->JDIM() - 1; ++j)
-                                b->cell(b->IDIM() - 1, j, k).FaceSeq(4) = ++cnt;
-                    }
-                    else if (sf.local_index == 5)
-                    {
-                        for (size_t i = 1; i <= b->IDIM() - 1; ++i)
-                            for (size_t k = 1; k <= b->KDIM() - 1; ++k)
-                                b->cell(i, 1, k).FaceSeq(5) = ++cnt;
-                    }
-                    else if (sf.local_index == 6)
-                    {
-                        for (size_t i = 1; i <= b->IDIM() - 1; ++i)
-                            for (size_t k = 1; k <= b->KDIM() - 1; ++k)
-                                b->cell(i, b->JDIM() - 1, k).FaceSeq(6) = ++cnt;
-                    }
-                    else
-                        throw std::invalid_argument("Internal error: Wrong local index of block surface.");
+                    num[n].surfFace[s - 1] = cnt;
+                    cnt += b->surface_face_num(s);
                 }
             }
         }
-
-        // Double-Sided
         for (auto e : m_entry)
         {
             if (e->Type() == BC::ONE_TO_ONE)
             {
                 auto p = static_cast<DoubleSideEntry*>(e);
-                const auto &rg1 = p->Range1();
-                const auto &rg2 = p->Range2();
-                auto b1 = &block(rg1.B());
-                const auto f1 = rg1.F();
-                auto b2 = &block(rg2.B());
-                const auto f2 = rg2.F();
-
-                std::vector<size_t> b1_dim_pri, b1_dim_sec, b2_dim_pri, b2_dim_sec;
-                distribute_index(rg1.S1(), rg1.E1(), b1_dim_pri);
-                distribute_index(rg1.S2(), rg1.E2(), b1_dim_sec);
-                distribute_index(rg2.S1(), rg2.E1(), b2_dim_pri);
-                distribute_index(rg2.S2(), rg2.E2(), b2_dim_sec);
-                if (p->Swap())
-                    std::swap(b2_dim_pri, b2_dim_sec);
+                const size_t n1 = p->Range1().B() - 1, n2 = p->Range2().B() - 1;
+                const auto f1 = p->Range1().F(), f2 = p->Range2().F();
+                const size_t np1 = m_blk[n1]->surface_pri_node_num(f1), np2 = m_blk[n2]->surface_pri_node_num(f2);
+                auto &tab1 = num[n1].sharedFace[f1 - 1];
+                auto &tab2 = num[n2].sharedFace[f2 - 1];
 
-                if (b1_dim_pri.size() != b2_dim_pri.size() || b1_dim_sec.size() != b2_dim_sec.size())
-                    throw std::runtime_error("Inconsistent num of nodes.");
-
-                const auto n1 = rg1.pri_node_num();
-                const auto n2 = rg1.sec_node_num();
-                if (p->Swap())
+                interface_traverse(p, false, [&](size_t pri1, size_t sec1, size_t pri2, size_t sec2)
                 {
-                    for (size_t l1 = 1; l1 <= n1 - 1; ++l1)
-                        for (size_t l2 = 1; l2 <= n2 - 1; ++l2)
-                        {
-                            const auto b1i1 = b1_dim_pri[l1 - 1];
-                            const auto b1i2 = b1_dim_sec[l2 - 1];
-                            const auto b2i1 = b2_dim_pri[l1 - 1];
-                            const auto b2i2 = b2_dim_sec[l2 - 1];
-                            b1->surface_face_index(f1, b1i1, b1i2) = b2->surface_face_index(f2, b2i2, b2i1) = ++cnt;
-                        }
-                }
-                else
-                {
-                    for (size_t l1 = 1; l1 <= n1 - 1; ++l1)
-                        for (size_t l2 = 1; l2 <= n2 - 1; ++l2)
-                        {
-                            const auto b1i1 = b1_dim_pri[l1 - 1];
-                            const auto b1i2 = b1_dim_sec[l2 - 1];
-                            const auto b2i1 = b2_dim_pri[l1 - 1];
-                            const auto b2i2 = b2_dim_sec[l2 - 1];
-                            b1->surface_face_index(f1, b1i1, b1i2) = b2->surface_face_index(f2, b2i1, b2i2) = ++cnt;
-                        }
-                }
+                    tab1.at((pri1 - 1) + (np1 - 1) * (sec1 - 1)) = tab2.at((pri2 - 1) + (np2 - 1) * (sec2 - 1)) = ++cnt;
+                });
             }
         }
-
         if (cnt != totalFaceNum)
             throw std::length_error("Inconsistent num of faces detected.");
-    }
-
-    void Mapping3D::numbering_node()
-    {
-        const auto totalNodeNum = nNode();
-
-        size_t cnt = 0;
-
-        // Block interior
-        for (auto b : m_blk)
-        {
-            std::vector<size_t*> boc(8, nullptr);
-            for (size_t k = 2; k <= b->KDIM() - 1; ++k)
-                for (size_t j = 2; j <= b->JDIM() - 1; ++j)
-                    for (size_t i = 2; i <= b->IDIM() - 1; ++i)
-                    {
-                        ++cnt;
-                        b->interior_node_occurance(i, j, k, boc);
-                        for (auto r : boc)
-                            *r = cnt;
-                    }
-        }
 
-        // Vertex
-        for (const auto &e : m_vertex)
+        /// Nodes
+        cnt = 0;
+        for (size_t n = 0; n < nBlock(); ++n)
         {
-            ++cnt;
-            for (auto r : e)
-                r->dependentBlock->vertex_node_index(r->local_index) = cnt;
+            num[n].interiorNode = cnt;
+            cnt += m_blk[n]->block_internal_node_num();
         }
-
-        // Interior of double-sided surface
+        for (size_t n = 0; n < nBlock(); ++n)
+            for (short v = 1; v <= Block3D::NumOfVertex; ++v)
+                num[n].vertexNode[v - 1] = cnt + m_blk[n]->vertex(v).global_index;
+        cnt += nVertex();
         for (auto e : m_entry)
         {
             if (e->Type() == BC::ONE_TO_ONE)
             {
                 auto p = static_cast<DoubleSideEntry*>(e);
-                const auto &rg1 = p->Range1();
-                const auto &rg2 = p->Range2();
-                auto b1 = &block(rg1.B());
-                auto b2 = &block(rg2.B());
-                const auto f1 = rg1.F();
-                const auto f2 = rg2.F();
-                const auto n1 = rg1.pri_node_num();
-                const auto n2 = rg1.sec_node_num();
-
-                std::vector<size_t> b1_dim_pri, b1_dim_sec, b2_dim_pri, b2_dim_sec;
-                distribute_index(rg1.S1(), rg1.E1(), b1_dim_pri);
-                distribute_index(rg1.S2(), rg1.E2(), b1_dim_sec);
-                distribute_index(rg2.S1(), rg2.E1(), b2_dim_pri);
-                distribute_index(rg2.S2(), rg2.E2(), b2_dim_sec);
-                if (p->Swap())
-                    std::swap(b2_dim_pri, b2_dim_sec);
+                const size_t n1 = p->Range1().B() - 1, n2 = p->Range2().B() - 1;
+                const auto f1 = p->Range1().F(), f2 = p->Range2().F();
+                const size_t np1 = m_blk[n1]->surface_pri_node_num(f1), np2 = m_blk[n2]->surface_pri_node_num(f2);
+                auto &tab1 = num[n1].sharedNode[f1 - 1];
+                auto &tab2 = num[n2].sharedNode[f2 - 1];
 
-                if (b1_dim_pri.size() != b2_dim_pri.size() || b1_dim_sec.size() != b2_dim_sec.size())
-                    throw std::runtime_error("Inconsistent num of nodes.");
-
-                std::vector<size_t*> sioc(4, nullptr);
-                if (p->Swap())
-                {
-                    for (size_t l1 = 2; l1 <= n1 - 1; ++l1)
-                        for (size_t l2 = 2; l2 <= n2 - 1; ++l2)
-                        {
-                            ++cnt;
-
-                            const auto b1i1 = b1_dim_pri[l1 - 1];
-                            const auto b1i2 = b1_dim_sec[l2 - 1];
-                            const auto b2i1 = b2_dim_pri[l1 - 1];
-                            const auto b2i2 = b2_dim_sec[l2 - 1];
-
-                            b1->surface_internal_node_occurance(f1, b1i1, b1i2, sioc);
-                            for (auto r : sioc)
-                                *r = cnt;
-
-                            b2->surface_internal_node_occurance(f2, b2i2, b2i1, sioc);
-                            for (auto r : sioc)
-                                *r = cnt;
-                        }
-                }
-                else
+                interface_traverse(p, true, [&](size_t pri1, size_t sec1, size_t pri2, size_t sec2)
                 {
-                    for (size_t l1 = 2; l1 <= n1 - 1; ++l1)
-                        for (size_t l2 = 2; l2 <= n2 - 1; ++l2)
-                        {
-                            ++cnt;
-
-                            const auto b1i1 = b1_dim_pri[l1 - 1];
-                            const auto b1i2 = b1_dim_sec[l2 - 1];
-                            const auto b2i1 = b2_dim_pri[l1 - 1];
-                            const auto b2i2 = b2_dim_sec[l2 - 1];
-
-                            b1->surface_internal_node_occurance(f1, b1i1, b1i2, sioc);
-                            for (auto r : sioc)
-                                *r = cnt;
-
-                            b2->surface_internal_node_occurance(f2, b2i1, b2i2, sioc);
-                            for (auto r : sioc)
-                                *r = cnt;
-                        }
-                }
+                    tab1.at((pri1 - 2) + (np1 - 2) * (sec1 - 2)) = tab2.at((pri2 - 2) + (np2 - 2) * (sec2 - 2)) = ++cnt;
+                });
             }
         }
-
-        // Interior of single-sided surface
-        for (auto b : m_blk)
+        for (size_t n = 0; n < nBlock(); ++n)
         {
-            std::vector<size_t*> sioc(4, nullptr);
-            for (short i = 1; i <= Block3D::NumOfSurf; ++i)
+            const auto b = m_blk[n];
+            for (short s = 1; s <= Block3D::NumOfSurf; ++s)
             {
-                auto &f = b->surf(i);
-                if (!f.neighbourSurf)
+                if (!b->surf(s).neighbourSurf)
                 {
-                    size_t pri_end = 0, sec_end = 0;
-                    switch (i)
-                    {
-                    case 1:
-                    case 2:
-                        pri_end = b->IDIM() - 1;
-                        sec_end = b->JDIM() - 1;
-                        break;
-                    case 3:
-                    case 4:
-                        pri_end = b->JDIM() - 1;
-                        sec_end = b->KDIM() - 1;
-                        break;
-                    case 5:
-                    case 6:
-                        pri_end = b->KDIM() - 1;
-                        sec_end = b->IDIM() - 1;
-                        break;
-                    default:
-                        break;
-                    }
-                    for (size_t sec = 2; sec <= sec_end; ++sec)
-                        for (size_t pri = 2; pri <= pri_end; ++pri)
-                        {
-                            ++cnt;
-                            b->surface_internal_node_occurance(i, pri, sec, sioc);
-                            for (auto r : sioc)
-                                *r = cnt;
-                        }
+                    num[n].surfNode[s - 1] = cnt;
+                    cnt += b->surface_internal_node_num(s);
                 }
             }
         }
-
-        // Frame
         for (const auto &e : m_frame)
         {
-            // Identify directions
-            std::map<Block3D::FRAME*, size_t> ptr2idx;
-            for (size_t i = 0; i < e.size(); ++i)
-                ptr2idx[e[i]] = i;
-            if (ptr2idx.size() != e.size())
-                throw std::runtime_error("Something wired happens...");
-            std::vector<bool> swap_flag(e.size(), false);
-            std::vector<bool> visited(e.size(), false);
-            visited[0] = true;
-            std::queue<Block3D::FRAME*> q;
-            q.push(e[0]);
-
-            while (!q.empty())
+            for (auto f : e)
             {
-                auto r = q.front();
-                q.pop();
-                auto par_idx = ptr2idx[r];
-
-                for (auto s : r->dependentSurf)
-                {
-                    if (s->neighbourSurf)
-                    {
-                        size_t i = 0;
-                        while (i < s->includedFrame.size() && s->includedFrame[i] != r)
-                            ++i;
-                        if (i >= s->includedFrame.size())
-                            throw std::runtime_error("Internal error detected.");
-
-                        auto rr = s->counterpartFrame[i];
-                        auto loc_idx = ptr2idx[rr];
-                        if (!visited[loc_idx])
-                        {
-                            visited[loc_idx] = true;
-                            swap_flag[loc_idx] = s->counterpartFrameIsOpposite[i] ? !swap_flag[par_idx] : swap_flag[par_idx];
-                            q.push(rr);
-                        }
-                    }
-                }
-            }
-
-            // Assign index
-            auto r0 = e[0];
-            auto b0 = r0->dependentBlock;
-            const auto itn = b0->frame_internal_node_num(r0->local_index);
-            for (size_t lidx = 0; lidx < itn; ++lidx)
-            {
-                auto cur_cnt = ++cnt;
-                for (size_t i = 0; i < e.size(); ++i)
-                {
-                    std::vector<size_t*> fnoc(2, nullptr);
-                    auto r = e[i];
-                    auto b = r->dependentBlock;
-                    const size_t loc_pos = swap_flag[i] ? (itn + 1 - lidx) : (lidx + 2);
-                    b->frame_internal_node_occurace(r->local_index, loc_pos, fnoc);
-                    *fnoc[0] = *fnoc[1] = cur_cnt;
-                }
+                const size_t n = f->dependentBlock->index() - 1;
+                num[n].frameNode[f->local_index - 1] = cnt;
+                num[n].frameReversed[f->local_index - 1] = f->opposite;
             }
+            cnt += e[0]->dependentBlock->frame_internal_node_num(e[0]->local_index);
         }
-
-        // Ensure total amount is right
-        if (cnt != totalNodeNum)
+        if (cnt != nNode())
             throw std::length_error("Inconsistent num of nodes detected.");
     }
 }
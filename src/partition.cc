@@ -0,0 +1,396 @@
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include "../inc/xf.h"
+
+static const char HALO_MAGIC[8] = { 'X', 'F', 'H', 'A', 'L', 'O', '\0', '\0' };
+static const std::uint32_t HALO_VERSION = 1;
+
+static void write_size(std::ostream &out, size_t val)
+{
+    const std::uint64_t tmp = val;
+    out.write(reinterpret_cast<const char*>(&tmp), sizeof(tmp));
+}
+
+static size_t read_size(std::istream &in)
+{
+    std::uint64_t tmp = 0;
+    in.read(reinterpret_cast<char*>(&tmp), sizeof(tmp));
+    if (!in)
+        throw std::runtime_error("Unexpected end of the halo file.");
+    return static_cast<size_t>(tmp);
+}
+
+template<typename T>
+static void write_array(std::ostream &out, const std::vector<T> &src)
+{
+    write_size(out, src.size());
+    for (const auto &e : src)
+    {
+        const std::int64_t tmp = static_cast<std::int64_t>(e);
+        out.write(reinterpret_cast<const char*>(&tmp), sizeof(tmp));
+    }
+}
+
+template<typename T>
+static void read_array(std::istream &in, std::vector<T> &dst)
+{
+    const size_t n = read_size(in);
+    std::vector<std::int64_t> buf(n);
+    in.read(reinterpret_cast<char*>(buf.data()), n * sizeof(std::int64_t));
+    if (!in)
+        throw std::runtime_error("Unexpected end of the halo file.");
+
+    dst.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        dst[i] = static_cast<T>(buf[i]);
+}
+
+namespace GridTool::XF
+{
+    PARTITION::PARTITION() :
+        rank(0),
+        nPart(0),
+        nLayer(0),
+        nOwnedCell(0)
+    {
+        /// Empty body.
+    }
+
+    size_t PARTITION::numOfCell() const
+    {
+        return cellL2G.size();
+    }
+
+    size_t PARTITION::numOfFace() const
+    {
+        return faceL2G.size();
+    }
+
+    size_t PARTITION::numOfNode() const
+    {
+        return nodeL2G.size();
+    }
+
+    void PARTITION::writeToFile(const std::string &dst) const
+    {
+        std::ofstream fout(dst, std::ios::binary);
+        if (fout.fail())
+            throw std::runtime_error("Failed to open output halo file: \"" + dst + "\".");
+
+        /// Header
+        fout.write(HALO_MAGIC, sizeof(HALO_MAGIC));
+        fout.write(reinterpret_cast<const char*>(&HALO_VERSION), sizeof(HALO_VERSION));
+        write_size(fout, rank);
+        write_size(fout, nPart);
+        write_size(fout, nLayer);
+        write_size(fout, nOwnedCell);
+        write_array(fout, nGhostCell);
+
+        /// Numbering
+        write_array(fout, cellL2G);
+        write_array(fout, faceL2G);
+        write_array(fout, nodeL2G);
+        write_array(fout, cellOwner);
+
+        /// Geometry
+        write_size(fout, coordinate.size());
+        for (const auto &e : coordinate)
+            fout.write(reinterpret_cast<const char*>(e.data()), 3 * sizeof(double));
+
+        /// Connectivity
+        write_array(fout, faceNodeNum);
+        write_array(fout, faceNode);
+        write_array(fout, faceLeftCell);
+        write_array(fout, faceRightCell);
+        write_array(fout, faceZone);
+        write_array(fout, cellFaceStart);
+        write_array(fout, cellFace);
+
+        /// Exchange lists
+        write_size(fout, send.size());
+        for (const auto &e : send)
+        {
+            write_size(fout, e.rank);
+            write_array(fout, e.cell);
+        }
+        write_size(fout, recv.size());
+        for (const auto &e : recv)
+        {
+            write_size(fout, e.rank);
+            write_array(fout, e.cell);
+        }
+
+        fout.close();
+    }
+
+    void PARTITION::readFromFile(const std::string &src)
+    {
+        std::ifstream fin(src, std::ios::binary);
+        if (fin.fail())
+            throw std::runtime_error("Failed to open input halo file: \"" + src + "\".");
+
+        /// Header
+        char magic[sizeof(HALO_MAGIC)];
+        fin.read(magic, sizeof(magic));
+        if (!fin || std::memcmp(magic, HALO_MAGIC, sizeof(HALO_MAGIC)) != 0)
+            throw std::runtime_error("\"" + src + "\" is not a halo file.");
+        std::uint32_t ver = 0;
+        fin.read(reinterpret_cast<char*>(&ver), sizeof(ver));
+        if (ver != HALO_VERSION)
+            throw std::runtime_error("Unsupported halo file version: " + std::to_string(ver) + ".");
+        rank = read_size(fin);
+        nPart = read_size(fin);
+        nLayer = read_size(fin);
+        nOwnedCell = read_size(fin);
+        read_array(fin, nGhostCell);
+
+        /// Numbering
+        read_array(fin, cellL2G);
+        read_array(fin, faceL2G);
+        read_array(fin, nodeL2G);
+        read_array(fin, cellOwner);
+
+        /// Geometry
+        coordinate.resize(read_size(fin));
+        for (auto &e : coordinate)
+            fin.read(reinterpret_cast<char*>(e.data()), 3 * sizeof(double));
+        if (!fin)
+            throw std::runtime_error("Unexpected end of the halo file.");
+
+        /// Connectivity
+        read_array(fin, faceNodeNum);
+        read_array(fin, faceNode);
+        read_array(fin, faceLeftCell);
+        read_array(fin, faceRightCell);
+        read_array(fin, faceZone);
+        read_array(fin, cellFaceStart);
+        read_array(fin, cellFace);
+
+        /// Exchange lists
+        send.resize(read_size(fin));
+        for (auto &e : send)
+        {
+            e.rank = read_size(fin);
+            read_array(fin, e.cell);
+        }
+        recv.resize(read_size(fin));
+        for (auto &e : recv)
+        {
+            e.rank = read_size(fin);
+            read_array(fin, e.cell);
+        }
+
+        fin.close();
+
+        if (numOfCell() != nOwnedCell + std::accumulate(nGhostCell.begin(), nGhostCell.end(), size_t(0)))
+            throw std::runtime_error("Inconsistent num of cells in halo file: \"" + src + "\".");
+    }
+
+    void MESH::partition(const std::vector<size_t> &cell_part, size_t nLayer, std::vector<PARTITION> &dst) const
+    {
+        if (cell_part.size() != numOfCell())
+            throw std::invalid_argument("Size of the partition vector is inconsistent with num of cells.");
+        if (nLayer < 1 || nLayer > 2)
+            throw std::invalid_argument("Only 1 or 2 layers of ghost cells are supported.");
+
+        /// Owned cells of each partition, in ascending global order.
+        const size_t nPart = cell_part.empty() ? 0 : *std::max_element(cell_part.begin(), cell_part.end()) + 1;
+        std::vector<std::vector<size_t>> owned(nPart);
+        for (size_t i = 1; i <= numOfCell(); ++i)
+            owned[cell_part[i - 1]].push_back(i);
+
+        /// Real zone index of each face.
+        std::vector<size_t> face_zone(numOfFace(), 0);
+        for (size_t i = 1; i <= numOfZone(); ++i)
+        {
+            const auto &z = zone(i);
+            if (z.obj == nullptr || z.obj->identity() != SECTION::FACE)
+                continue;
+            for (size_t j = z.obj->first_index(); j <= z.obj->last_index(); ++j)
+                face_zone[j - 1] = z.ID;
+        }
+
+        /// Scratch of global-to-local mapping, reset after each partition.
+        std::vector<size_t> cell_g2l(numOfCell(), 0);
+        std::vector<size_t> face_g2l(numOfFace(), 0);
+        std::vector<size_t> node_g2l(numOfNode(), 0);
+
+        dst.clear();
+        dst.resize(nPart);
+        for (size_t p = 0; p < nPart; ++p)
+        {
+            auto &cur = dst[p];
+            cur.rank = p;
+            cur.nPart = nPart;
+            cur.nLayer = nLayer;
+            cur.nOwnedCell = owned[p].size();
+            cur.nGhostCell.assign(nLayer, 0);
+
+            /// Owned cells
+            cur.cellL2G = owned[p];
+            for (size_t i = 0; i < cur.cellL2G.size(); ++i)
+                cell_g2l[cur.cellL2G[i] - 1] = i + 1;
+
+            /// 1st layer: face neighbours of owned cells.
+            std::vector<size_t> layer;
+            for (size_t i = 0; i < cur.nOwnedCell; ++i)
+            {
+                const size_t c = cur.cellL2G[i];
+                for (auto f : cell(c).includedFace)
+                {
+                    const auto &cf = face(f);
+                    const size_t adj = cf.leftCell == c ? cf.rightCell : cf.leftCell;
+                    if (adj != 0 && cell_g2l[adj - 1] == 0)
+                    {
+                        cell_g2l[adj - 1] = std::numeric_limits<size_t>::max();
+                        layer.push_back(adj);
+                    }
+                }
+            }
+
+            auto append_layer = [&](size_t l)
+            {
+                std::sort(layer.begin(), layer.end(), [&cell_part](size_t a, size_t b)
+                {
+                    const size_t pa = cell_part[a - 1], pb = cell_part[b - 1];
+                    return pa == pb ? a < b : pa < pb;
+                });
+                for (auto c : layer)
+                {
+                    cur.cellL2G.push_back(c);
+                    cell_g2l[c - 1] = cur.cellL2G.size();
+                }
+                cur.nGhostCell[l] = layer.size();
+            };
+            append_layer(0);
+
+            /// 2nd layer: node neighbours of the 1st layer.
+            if (nLayer == 2)
+            {
+                const size_t l1_first = cur.nOwnedCell;
+                const size_t l1_last = l1_first + cur.nGhostCell[0];
+                layer.clear();
+                for (size_t i = l1_first; i < l1_last; ++i)
+                {
+                    for (auto n : cell(cur.cellL2G[i]).includedNode)
+                    {
+                        for (auto adj : node(n).dependentCell)
+                        {
+                            if (cell_g2l[adj - 1] == 0)
+                            {
+                                cell_g2l[adj - 1] = std::numeric_limits<size_t>::max();
+                                layer.push_back(adj);
+                            }
+                        }
+                    }
+                }
+                append_layer(1);
+            }
+
+            const size_t nLocalCell = cur.cellL2G.size();
+            cur.cellOwner.resize(nLocalCell);
+            for (size_t i = 0; i < nLocalCell; ++i)
+                cur.cellOwner[i] = cell_part[cur.cellL2G[i] - 1];
+
+            /// Faces whose adjacent cells are all available locally,
+            /// nodes in the order of first touch.
+            cur.cellFaceStart.assign(1, 0);
+            for (size_t i = 0; i < nLocalCell; ++i)
+            {
+                const auto &c = cell(cur.cellL2G[i]);
+                for (auto f : c.includedFace)
+                {
+                    const auto &cf = face(f);
+                    const bool lc_ok = cf.leftCell == 0 || cell_g2l[cf.leftCell - 1] != 0;
+                    const bool rc_ok = cf.rightCell == 0 || cell_g2l[cf.rightCell - 1] != 0;
+                    if (!lc_ok || !rc_ok)
+                        continue;
+
+                    if (face_g2l[f - 1] == 0)
+                    {
+                        cur.faceL2G.push_back(f);
+                        face_g2l[f - 1] = cur.faceL2G.size();
+
+                        cur.faceNodeNum.push_back(static_cast<int>(cf.includedNode.size()));
+                        for (size_t j = 0; j < 4; ++j)
+                        {
+                            size_t ln = 0;
+                            if (j < cf.includedNode.size())
+                            {
+                                const size_t n = cf.includedNode[j];
+                                if (node_g2l[n - 1] == 0)
+                                {
+                                    cur.nodeL2G.push_back(n);
+                                    node_g2l[n - 1] = cur.nodeL2G.size();
+                                }
+                                ln = node_g2l[n - 1];
+                            }
+                            cur.faceNode.push_back(ln);
+                        }
+                        cur.faceLeftCell.push_back(cf.leftCell == 0 ? 0 : cell_g2l[cf.leftCell - 1]);
+                        cur.faceRightCell.push_back(cf.rightCell == 0 ? 0 : cell_g2l[cf.rightCell - 1]);
+                        cur.faceZone.push_back(face_zone[f - 1]);
+                    }
+                    cur.cellFace.push_back(face_g2l[f - 1]);
+                }
+                cur.cellFaceStart.push_back(cur.cellFace.size());
+            }
+
+            cur.coordinate.resize(cur.nodeL2G.size());
+            for (size_t i = 0; i < cur.nodeL2G.size(); ++i)
+                cur.coordinate[i] = node(cur.nodeL2G[i]).coordinate;
+
+            /// Receiving lists, ghost cells are already grouped by owner within each layer.
+            std::map<size_t, size_t> recv_pos;
+            for (size_t i = cur.nOwnedCell; i < nLocalCell; ++i)
+            {
+                const size_t q = cur.cellOwner[i];
+                auto it = recv_pos.find(q);
+                if (it == recv_pos.end())
+                {
+                    it = recv_pos.emplace(q, cur.recv.size()).first;
+                    cur.recv.push_back({ q, {} });
+                }
+                cur.recv[it->second].cell.push_back(i + 1);
+            }
+            std::sort(cur.recv.begin(), cur.recv.end(), [](const PARTITION::EXCHANGE &a, const PARTITION::EXCHANGE &b)
+            {
+                return a.rank < b.rank;
+            });
+
+            /// Reset scratch
+            for (auto c : cur.cellL2G)
+                cell_g2l[c - 1] = 0;
+            for (auto f : cur.faceL2G)
+                face_g2l[f - 1] = 0;
+            for (auto n : cur.nodeL2G)
+                node_g2l[n - 1] = 0;
+        }
+
+        /// Sending lists, mirror of the receiving lists on the other side.
+        /// Owned cells are sorted by global index, so local index is found by bisection.
+        for (size_t q = 0; q < nPart; ++q)
+        {
+            const auto &src = dst[q];
+            for (const auto &r : src.recv)
+            {
+                auto &peer = dst[r.rank];
+                PARTITION::EXCHANGE e{ q, {} };
+                e.cell.reserve(r.cell.size());
+                for (auto lc : r.cell)
+                {
+                    const size_t gc = src.cellL2G[lc - 1];
+                    const auto first = peer.cellL2G.begin();
+                    const auto last = first + peer.nOwnedCell;
+                    const auto it = std::lower_bound(first, last, gc);
+                    if (it == last || *it != gc)
+                        throw internal_error("ghost cell is not owned by its owner");
+                    e.cell.push_back(static_cast<size_t>(it - first) + 1);
+                }
+                peer.send.push_back(std::move(e));
+            }
+        }
+    }
+}
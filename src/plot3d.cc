@@ -1,4 +1,6 @@
 #include <string>
+#include <cctype>
+#include <charconv>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
@@ -28,6 +30,117 @@ struct invalid_dimension_size : public std::invalid_argument
 
 namespace GridTool::PLOT3D
 {
+    static int read_block_num(std::istream &fin)
+    {
+        std::string s;
+        std::getline(fin, s);
+        std::stringstream ss(s);
+        int blk_num = 0;
+        ss >> blk_num;
+        if (blk_num <= 0)
+            throw std::invalid_argument("Invalid num of blocks.");
+
+        return blk_num;
+    }
+
+    /// "IMAX", "JMAX" and "KMAX" of the n-th block, 0-based.
+    /// "KMAX" is set to 0 if not given.
+    static std::array<int, 3> read_block_dimension(std::istream &fin, int n)
+    {
+        std::string s;
+        std::getline(fin, s);
+        std::stringstream ss(s);
+
+        int IMAX = 0, JMAX = 0, KMAX = 0;
+        ss >> IMAX >> JMAX;
+        if (IMAX <= 0)
+            throw std::invalid_argument("Invalid I dimension of Block " + std::to_string(n + 1) + ".");
+        if (JMAX <= 0)
+            throw std::invalid_argument("Invalid J dimension of Block " + std::to_string(n + 1) + ".");
+        if (!(ss >> KMAX))
+            KMAX = 0;
+        else if (KMAX <= 0)
+            throw std::invalid_argument("Invalid K dimension of Block " + std::to_string(n + 1) + ".");
+
+        return { IMAX, JMAX, KMAX };
+    }
+
+    static BLK *create_block(const std::array<int, 3> &d)
+    {
+        if (d[2] == 0)
+            return new BLK((size_t)d[0], (size_t)d[1], false);
+        else if (d[2] == 1)
+            return new BLK((size_t)d[0], (size_t)d[1], true);
+        else
+            return new BLK((size_t)d[0], (size_t)d[1], (size_t)d[2]);
+    }
+
+    /// Same as "operator>>" on a floating-point value, but much faster
+    /// on large grids as the stream buffer is accessed directly.
+    static bool read_value(std::streambuf *sb, double &dst)
+    {
+        int c = sb->sgetc();
+        while (c != EOF && std::isspace(c))
+            c = sb->snextc();
+        if (c == '+')
+            c = sb->snextc();
+
+        char buf[64];
+        size_t n = 0;
+        while (c != EOF && !std::isspace(c) && n < sizeof(buf))
+        {
+            buf[n++] = static_cast<char>(c);
+            c = sb->snextc();
+        }
+
+        const auto ret = std::from_chars(buf, buf + n, dst);
+        return n > 0 && ret.ec == std::errc() && ret.ptr == buf + n;
+    }
+
+    static void read_block_coordinate(std::istream &fin, BLK &b)
+    {
+        const size_t NX = b.nI(), NY = b.nJ(), NZ = b.nK();
+        auto sb = fin.rdbuf();
+        bool ok = true;
+        if (b.dimension() == 3)
+        {
+            for (size_t k = 0; k < NZ; ++k)
+                for (size_t j = 0; j < NY; ++j)
+                    for (size_t i = 0; i < NX; ++i)
+                        ok = ok && read_value(sb, b.at(i, j, k).x());
+
+            for (size_t k = 0; k < NZ; ++k)
+                for (size_t j = 0; j < NY; ++j)
+                    for (size_t i = 0; i < NX; ++i)
+                        ok = ok && read_value(sb, b.at(i, j, k).y());
+
+            for (size_t k = 0; k < NZ; ++k)
+                for (size_t j = 0; j < NY; ++j)
+                    for (size_t i = 0; i < NX; ++i)
+                        ok = ok && read_value(sb, b.at(i, j, k).z());
+        }
+        else
+        {
+            for (size_t j = 0; j < NY; ++j)
+                for (size_t i = 0; i < NX; ++i)
+                    ok = ok && read_value(sb, b.at(i, j).x());
+
+            for (size_t j = 0; j < NY; ++j)
+                for (size_t i = 0; i < NX; ++i)
+                    ok = ok && read_value(sb, b.at(i, j).y());
+
+            if (b.is3D())
+            {
+                for (size_t j = 0; j < NY; ++j)
+                    for (size_t i = 0; i < NX; ++i)
+                        ok = ok && read_value(sb, b.at(i, j).z());
+            }
+        }
+
+        if (!fin || !ok)
+            throw std::runtime_error("Unexpected end of the input grid.");
+    }
+
     BLK::BLK(size_t nI, size_t nJ, bool is3D) :
         DIM(2, is3D),
         ArrayND<Vector>(nI, nJ, { 0.0, 0.0, 0.0 })
@@ -139,21 +252,13 @@ namespace GridTool::PLOT3D
 
     void GRID::readFromFile(const std::string &src)
     {
-        std::string s;
-        std::stringstream ss;
-
         // Open input grid file.
         std::ifstream fin(src);
         if (!fin)
             throw std::runtime_error("Failed to read the input grid.");
 
         // Read block num.
-        std::getline(fin, s);
-        ss << s;
-        int blk_num = 0;
-        ss >> blk_num;
-        if (blk_num <= 0)
-            throw std::invalid_argument("Invalid num of blocks.");
+        const int blk_num = read_block_num(fin);
 
         // Drop previous contents.
         release_all();
@@ -161,69 +266,11 @@ namespace GridTool::PLOT3D
         // Read dimensions of each block,and allocate new storage.
         m_blk.resize(blk_num, nullptr);
         for (int n = 0; n < blk_num; ++n)
-        {
-            int IMAX = 0, JMAX = 0, KMAX = 0;
-            std::getline(fin, s);
-            ss.clear();
-            ss << s;
-            ss >> IMAX >> JMAX;
-            if (IMAX <= 0)
-                throw std::invalid_argument("Invalid I dimension of Block " + std::to_string(n + 1) + ".");
-            if (JMAX <= 0)
-                throw std::invalid_argument("Invalid J dimension of Block " + std::to_string(n + 1) + ".");
-
-            if (!(ss >> KMAX))
-                m_blk[n] = new BLK((size_t)IMAX, (size_t)JMAX, false);
-            else if (KMAX == 1)
-                m_blk[n] = new BLK((size_t)IMAX, (size_t)JMAX, true);
-            else
-            {
-                if (JMAX <= 0)
-                    throw std::invalid_argument("Invalid K dimension of Block " + std::to_string(n + 1) + ".");
-                else
-                    m_blk[n] = new BLK((size_t)IMAX, (size_t)JMAX, (size_t)KMAX);
-            }
-        }
+            m_blk[n] = create_block(read_block_dimension(fin, n));
 
         // Read coordinates of each block.
         for (auto b : m_blk)
-        {
-            const size_t NX = b->nI(), NY = b->nJ(), NZ = b->nK();
-            if (b->dimension() == 3)
-            {
-                for (size_t k = 0; k < NZ; ++k)
-                    for (size_t j = 0; j < NY; ++j)
-                        for (size_t i = 0; i < NX; ++i)
-                            fin >> b->at(i, j, k).x();
-
-                for (size_t k = 0; k < NZ; ++k)
-                    for (size_t j = 0; j < NY; ++j)
-                        for (size_t i = 0; i < NX; ++i)
-                            fin >> b->at(i, j, k).y();
-
-                for (size_t k = 0; k < NZ; ++k)
-                    for (size_t j = 0; j < NY; ++j)
-                        for (size_t i = 0; i < NX; ++i)
-                            fin >> b->at(i, j, k).z();
-            }
-            else
-            {
-                for (size_t j = 0; j < NY; ++j)
-                    for (size_t i = 0; i < NX; ++i)
-                        fin >> b->at(i, j).x();
-
-                for (size_t j = 0; j < NY; ++j)
-                    for (size_t i = 0; i < NX; ++i)
-                        fin >> b->at(i, j).y();
-
-                if (b->is3D())
-                {
-                    for (size_t j = 0; j < NY; ++j)
-                        for (size_t i = 0; i < NX; ++i)
-                            fin >> b->at(i, j).z();
-                }
-            }
-        }
+            read_block_coordinate(fin, *b);
 
         // Close file.
         fin.close();
@@ -309,6 +356,75 @@ namespace GridTool::PLOT3D
         return m_blk[loc_idx];
     }
 
+    const BLK *GRID::block(size_t loc_idx) const
+    {
+        return m_blk[loc_idx];
+    }
+
+    BLK *GRID::add_block(size_t nI, size_t nJ, size_t nK)
+    {
+        if (dimension() != 3)
+            throw std::runtime_error("Inconsistent DIM properties of the grid.");
+
+        auto b = new BLK(nI, nJ, nK);
+        m_blk.push_back(b);
+        return b;
+    }
+
+    BLK *GRID::split_block(size_t loc_idx, char dir, size_t idx)
+    {
+        if (dimension() != 3)
+            throw std::runtime_error("Inconsistent DIM properties of the grid.");
+        if (loc_idx >= numOfBlock())
+            throw std::out_of_range("Invalid block index: " + std::to_string(loc_idx) + ".");
+        if (dir != 'I' && dir != 'J' && dir != 'K')
+            throw std::invalid_argument("Invalid direction: " + std::string(1, dir) + ".");
+
+        const auto b = m_blk[loc_idx];
+        const short d = dir - 'I';
+        const size_t n[3] = { b->nI(), b->nJ(), b->nK() };
+        if (idx <= 1 || idx >= n[d])
+            throw std::invalid_argument("Node index " + std::to_string(idx) + " is not inside the block along " + std::string(1, dir) + ".");
+
+        size_t lo[3] = { n[0], n[1], n[2] }, hi[3] = { n[0], n[1], n[2] }, offset[3] = { 0, 0, 0 };
+        lo[d] = idx;
+        hi[d] = n[d] - idx + 1;
+        offset[d] = idx - 1;
+
+        /// Nothing is changed if allocation fails.
+        m_blk.reserve(m_blk.size() + 1);
+        auto b1 = new BLK(lo[0], lo[1], lo[2]);
+        BLK *b2 = nullptr;
+        try
+        {
+            b2 = new BLK(hi[0], hi[1], hi[2]);
+        }
+        catch (...)
+        {
+            delete b1;
+            throw;
+        }
+
+        COMMON::parallel_for(n[2], [&](size_t first, size_t last)
+        {
+            for (size_t k = first; k < last; ++k)
+                for (size_t j = 0; j < n[1]; ++j)
+                    for (size_t i = 0; i < n[0]; ++i)
+                    {
+                        const auto &x = b->at(i, j, k);
+                        if (i < lo[0] && j < lo[1] && k < lo[2])
+                            b1->at(i, j, k) = x;
+                        if (i >= offset[0] && j >= offset[1] && k >= offset[2])
+                            b2->at(i - offset[0], j - offset[1], k - offset[2]) = x;
+                    }
+        });
+
+        delete b;
+        m_blk[loc_idx] = b1;
+        m_blk.push_back(b2);
+        return b2;
+    }
+
     void GRID::release_all()
     {
         for (auto e : m_blk)
@@ -316,4 +432,56 @@ namespace GridTool::PLOT3D
 
         m_blk.clear();
     }
+
+    READER::READER(const std::string &src) :
+        DIM(3),
+        m_fin(src),
+        m_next(0)
+    {
+        if (!m_fin)
+            throw std::runtime_error("Failed to read the input grid.");
+
+        const int blk_num = read_block_num(m_fin);
+        m_blkDim.resize(blk_num);
+        for (int n = 0; n < blk_num; ++n)
+            m_blkDim[n] = read_block_dimension(m_fin, n);
+
+        // Same DIM attributes as "GRID".
+        for (int n = 0; n < blk_num; ++n)
+        {
+            const bool is3D = m_blkDim[n][2] != 0;
+            const int dim = m_blkDim[n][2] > 1 ? 3 : 2;
+            if (n == 0)
+            {
+                m_is3D = is3D;
+                m_dim = dim;
+            }
+            else if (is3D != m_is3D || dim != m_dim)
+                throw std::runtime_error("Inconsistent DIM properties of Block " + std::to_string(n + 1) + ".");
+        }
+    }
+
+    size_t READER::numOfBlock() const
+    {
+        return m_blkDim.size();
+    }
+
+    BLK *READER::next()
+    {
+        if (m_next >= numOfBlock())
+            return nullptr;
+
+        auto b = create_block(m_blkDim[m_next]);
+        try
+        {
+            read_block_coordinate(m_fin, *b);
+        }
+        catch (...)
+        {
+            delete b;
+            throw;
+        }
+        ++m_next;
+        return b;
+    }
 }
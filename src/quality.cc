@@ -0,0 +1,473 @@
+#include <cmath>
+#include <atomic>
+#include <limits>
+#include <iomanip>
+#include "../inc/quality.h"
+
+namespace GridTool::QUALITY
+{
+    using COMMON::Vector;
+
+    static const double PI = 3.14159265358979323846;
+
+    std::string metric_name(int m)
+    {
+        switch (m)
+        {
+        case SKEWNESS:
+            return "Skewness";
+        case ASPECT_RATIO:
+            return "Aspect-Ratio";
+        case NON_ORTHOGONALITY:
+            return "Non-Orthogonality";
+        case VOLUME_RATIO:
+            return "Volume-Ratio";
+        default:
+            throw COMMON::wrong_index(m, "is not a valid quality metric");
+        }
+    }
+
+    /// Angle in degrees between "a" and "b".
+    static double angle_between(const Vector &a, const Vector &b)
+    {
+        const double la = a.norm();
+        const double lb = b.norm();
+        if (la == 0.0 || lb == 0.0)
+            return 180.0;
+
+        double c = a.dot(b) / (la * lb);
+        c = std::max(-1.0, std::min(1.0, c));
+        return std::acos(c) * 180.0 / PI;
+    }
+
+    /// Equiangle skewness of a polygon with "n" corners.
+    static double equiangle_skewness(const Vector *p, size_t n)
+    {
+        if (n < 3)
+            return 0.0;
+
+        const double theta_e = 180.0 * (n - 2) / n;
+        double theta_min = 180.0, theta_max = 0.0;
+        for (size_t k = 0; k < n; ++k)
+        {
+            Vector a, b;
+            COMMON::delta(p[k], p[(k + n - 1) % n], a);
+            COMMON::delta(p[k], p[(k + 1) % n], b);
+            const double theta = angle_between(a, b);
+            theta_min = std::min(theta_min, theta);
+            theta_max = std::max(theta_max, theta);
+        }
+        return std::max((theta_max - theta_e) / (180.0 - theta_e), (theta_e - theta_min) / theta_e);
+    }
+
+    /// Thread-local accumulation of a single zone.
+    class ACC
+    {
+    public:
+        size_t nCell = 0;
+        size_t nNegative = 0;
+        std::array<double, NumOfMetric> min, max, sum;
+        std::array<std::vector<size_t>, NumOfMetric> histogram;
+        std::array<std::vector<RECORD>, NumOfMetric> worst;
+        std::vector<size_t> negative;
+
+    private:
+        const OPTION *m_opt;
+
+        /// Min-heap on value, so that the best one among the worst is on top.
+        static bool heap_cmp(const RECORD &a, const RECORD &b)
+        {
+            return a.value > b.value || (a.value == b.value && a.cell < b.cell);
+        }
+
+        void add_worst(int m, const RECORD &r)
+        {
+            auto &w = worst[m];
+            if (w.size() < m_opt->nWorst)
+            {
+                w.push_back(r);
+                std::push_heap(w.begin(), w.end(), heap_cmp);
+            }
+            else if (!w.empty() && heap_cmp(r, w.front()))
+            {
+                std::pop_heap(w.begin(), w.end(), heap_cmp);
+                w.back() = r;
+                std::push_heap(w.begin(), w.end(), heap_cmp);
+            }
+        }
+
+    public:
+        explicit ACC(const OPTION &opt) :
+            m_opt(&opt)
+        {
+            min.fill(std::numeric_limits<double>::max());
+            max.fill(std::numeric_limits<double>::lowest());
+            sum.fill(0.0);
+            for (auto &e : histogram)
+                e.assign(opt.nBin, 0);
+        }
+
+        void add_negative(size_t cell)
+        {
+            ++nCell;
+            ++nNegative;
+            negative.push_back(cell);
+        }
+
+        void add(size_t cell, const std::array<double, NumOfMetric> &val)
+        {
+            ++nCell;
+            for (int m = 0; m < NumOfMetric; ++m)
+            {
+                const double v = val[m];
+                min[m] = std::min(min[m], v);
+                max[m] = std::max(max[m], v);
+                sum[m] += v;
+
+                if (m_opt->nBin > 0)
+                {
+                    const double lo = m_opt->lower[m], hi = m_opt->upper[m];
+                    const double t = (v - lo) / (hi - lo) * m_opt->nBin;
+                    size_t b = 0;
+                    if (t >= m_opt->nBin)
+                        b = m_opt->nBin - 1;
+                    else if (t > 0.0)
+                        b = static_cast<size_t>(t);
+                    ++histogram[m][b];
+                }
+
+                add_worst(m, RECORD{ cell, v });
+            }
+        }
+
+        void merge(const ACC &rhs)
+        {
+            nCell += rhs.nCell;
+            nNegative += rhs.nNegative;
+            for (int m = 0; m < NumOfMetric; ++m)
+            {
+                min[m] = std::min(min[m], rhs.min[m]);
+                max[m] = std::max(max[m], rhs.max[m]);
+                sum[m] += rhs.sum[m];
+                for (size_t b = 0; b < histogram[m].size(); ++b)
+                    histogram[m][b] += rhs.histogram[m][b];
+                for (const auto &r : rhs.worst[m])
+                    add_worst(m, r);
+            }
+            negative.insert(negative.end(), rhs.negative.begin(), rhs.negative.end());
+        }
+
+        void finalize(size_t id, const std::string &name, ZONE_REPORT &dst) const
+        {
+            dst.ID = id;
+            dst.name = name;
+            dst.nCell = nCell;
+            dst.nNegative = nNegative;
+
+            const size_t nValid = nCell - nNegative;
+            for (int m = 0; m < NumOfMetric; ++m)
+            {
+                dst.min[m] = nValid > 0 ? min[m] : 0.0;
+                dst.max[m] = nValid > 0 ? max[m] : 0.0;
+                dst.mean[m] = nValid > 0 ? sum[m] / nValid : 0.0;
+                dst.histogram[m] = histogram[m];
+                dst.worst[m] = worst[m];
+                std::sort(dst.worst[m].begin(), dst.worst[m].end(), heap_cmp);
+            }
+
+            dst.negative = negative;
+            std::sort(dst.negative.begin(), dst.negative.end());
+            if (dst.negative.size() > m_opt->nWorst)
+                dst.negative.resize(m_opt->nWorst);
+        }
+    };
+
+    /// Evaluate "f(i, acc)" for i in [0, n) concurrently, one accumulator per chunk.
+    /// "f" returns "false" to stop the current chunk.
+    template<typename F>
+    static void accumulate(size_t n, const OPTION &opt, ACC &dst, const F &f)
+    {
+        const size_t nChunk = std::max<size_t>(1, std::min(COMMON::num_of_thread(), n));
+        std::vector<ACC> acc(nChunk, ACC(opt));
+
+        COMMON::parallel_for(nChunk, [&](size_t c0, size_t c1)
+        {
+            for (size_t c = c0; c < c1; ++c)
+            {
+                const size_t first = n * c / nChunk;
+                const size_t last = n * (c + 1) / nChunk;
+                for (size_t i = first; i < last; ++i)
+                    if (!f(i, acc[c]))
+                        break;
+            }
+        });
+
+        for (const auto &e : acc)
+            dst.merge(e);
+    }
+
+    void analyze(const XF::MESH &mesh, const OPTION &opt, REPORT &dst)
+    {
+        dst.option = opt;
+        dst.aborted = false;
+        dst.zone.clear();
+
+        std::atomic<bool> stop(false);
+
+        for (size_t z = 1; z <= mesh.numOfZone(); ++z)
+        {
+            /// Zones after the stop are left out rather than reported empty.
+            if (stop.load())
+                break;
+
+            const auto &curZone = mesh.zone(z);
+            if (curZone.obj == nullptr || curZone.obj->identity() != XF::SECTION::CELL)
+                continue;
+
+            const size_t first = curZone.obj->first_index();
+            const size_t nCell = curZone.obj->num();
+
+            ACC acc(opt);
+            accumulate(nCell, opt, acc, [&](size_t loc, ACC &cur)
+            {
+                if (stop.load(std::memory_order_relaxed))
+                    return false;
+
+                const size_t i = first + loc;
+                const auto &c = mesh.cell(i);
+                if (!(c.volume > 0.0))
+                {
+                    cur.add_negative(i);
+                    if (opt.stopAtNegativeVolume)
+                    {
+                        stop.store(true, std::memory_order_relaxed);
+                        return false;
+                    }
+                    return true;
+                }
+
+                std::array<double, NumOfMetric> val{ 0.0, 1.0, 0.0, 1.0 };
+                double dmin = std::numeric_limits<double>::max(), dmax = 0.0;
+                Vector p[4];
+                for (size_t j = 0; j < c.includedFace.size(); ++j)
+                {
+                    const auto &f = mesh.face(c.includedFace.at(j));
+                    const size_t adj = c.adjacentCell.at(j);
+
+                    Vector d;
+                    COMMON::delta(c.center, f.center, d);
+                    const double L = d.norm();
+                    dmin = std::min(dmin, L);
+                    dmax = std::max(dmax, L);
+
+                    if (adj != 0)
+                    {
+                        const auto &nc = mesh.cell(adj);
+                        COMMON::delta(c.center, nc.center, d);
+                        if (nc.volume > 0.0)
+                            val[VOLUME_RATIO] = std::max(val[VOLUME_RATIO], std::max(c.volume / nc.volume, nc.volume / c.volume));
+                    }
+                    val[NON_ORTHOGONALITY] = std::max(val[NON_ORTHOGONALITY], angle_between(c.n.at(j), d));
+
+                    const size_t nFaceNode = f.includedNode.size();
+                    if (nFaceNode >= 3 && nFaceNode <= 4)
+                    {
+                        for (size_t k = 0; k < nFaceNode; ++k)
+                            p[k] = mesh.node(f.includedNode.at(k)).coordinate;
+                        val[SKEWNESS] = std::max(val[SKEWNESS], equiangle_skewness(p, nFaceNode));
+                    }
+                }
+
+                /// 2D cells are polygons themselves.
+                if (!mesh.is3D() && c.includedNode.size() >= 3 && c.includedNode.size() <= 4)
+                {
+                    for (size_t k = 0; k < c.includedNode.size(); ++k)
+                        p[k] = mesh.node(c.includedNode.at(k)).coordinate;
+                    val[SKEWNESS] = equiangle_skewness(p, c.includedNode.size());
+                }
+
+                val[ASPECT_RATIO] = dmin > 0.0 ? dmax / dmin : std::numeric_limits<double>::infinity();
+                cur.add(i, val);
+                return true;
+            });
+
+            dst.zone.emplace_back();
+            acc.finalize(curZone.ID, curZone.name, dst.zone.back());
+        }
+
+        dst.aborted = stop.load();
+    }
+
+    /// Node offsets of each face in the right-hand order, outward normal.
+    /// Sequence: I-min, I-max, J-min, J-max, K-min, K-max.
+    static const short FACE_NODE[6][4][3] = {
+        { { 0, 0, 0 }, { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 0 } },
+        { { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 }, { 1, 0, 1 } },
+        { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 } },
+        { { 0, 1, 0 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 0 } },
+        { { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 } },
+        { { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 } }
+    };
+
+    /// Geometry of a hexahedral cell within a structured block.
+    /// "S" is the outward area vector, "fc" is the face center.
+    static void hex_geom(const PLOT3D::BLK &blk, size_t i, size_t j, size_t k, Vector p[6][4], Vector fc[6], Vector S[6], Vector &cc, double &vol)
+    {
+        cc = Vector(0.0, 0.0, 0.0);
+        for (short di = 0; di < 2; ++di)
+            for (short dj = 0; dj < 2; ++dj)
+                for (short dk = 0; dk < 2; ++dk)
+                    cc += blk.at(i + di, j + dj, k + dk);
+        cc /= 8.0;
+
+        vol = 0.0;
+        for (short f = 0; f < 6; ++f)
+        {
+            fc[f] = Vector(0.0, 0.0, 0.0);
+            for (short n = 0; n < 4; ++n)
+            {
+                p[f][n] = blk.at(i + FACE_NODE[f][n][0], j + FACE_NODE[f][n][1], k + FACE_NODE[f][n][2]);
+                fc[f] += p[f][n];
+            }
+            fc[f] /= 4.0;
+
+            Vector d1, d2;
+            COMMON::delta(p[f][0], p[f][2], d1);
+            COMMON::delta(p[f][1], p[f][3], d2);
+            S[f] = d1.cross(d2);
+            S[f] *= 0.5;
+
+            vol += fc[f].dot(S[f]);
+        }
+        vol /= 3.0;
+    }
+
+    void analyze(const PLOT3D::BLK &blk, size_t blkID, const OPTION &opt, REPORT &dst)
+    {
+        if (!blk.is3D())
+            throw std::invalid_argument("Only 3D blocks are supported in quality analysis.");
+
+        dst.option = opt;
+        dst.aborted = false;
+        dst.zone.clear();
+
+        const size_t nI = blk.nI() - 1, nJ = blk.nJ() - 1, nK = blk.nK() - 1;
+        const size_t nCell = nI * nJ * nK;
+
+        /// 1st pass: centroid and volume of all cells,
+        /// stored contiguously to be looked up by neighbours.
+        std::vector<double> cx(nCell), cy(nCell), cz(nCell), vol(nCell);
+        COMMON::parallel_for(nJ * nK, [&](size_t first, size_t last)
+        {
+            Vector p[6][4], fc[6], S[6], cc;
+            for (size_t jk = first; jk < last; ++jk)
+            {
+                const size_t j = jk % nJ, k = jk / nJ;
+                for (size_t i = 0; i < nI; ++i)
+                {
+                    const size_t n = i + nI * jk;
+                    hex_geom(blk, i, j, k, p, fc, S, cc, vol[n]);
+                    cx[n] = cc.x();
+                    cy[n] = cc.y();
+                    cz[n] = cc.z();
+                }
+            }
+        });
+
+        /// 2nd pass: metrics.
+        std::atomic<bool> stop(false);
+        const long long stride[6] = { -1, 1, -(long long)nI, (long long)nI, -(long long)(nI * nJ), (long long)(nI * nJ) };
+
+        ACC acc(opt);
+        accumulate(nCell, opt, acc, [&](size_t n, ACC &cur)
+        {
+            if (stop.load(std::memory_order_relaxed))
+                return false;
+
+            if (!(vol[n] > 0.0))
+            {
+                cur.add_negative(n + 1);
+                if (opt.stopAtNegativeVolume)
+                {
+                    stop.store(true, std::memory_order_relaxed);
+                    return false;
+                }
+                return true;
+            }
+
+            const size_t i = n % nI, j = (n / nI) % nJ, k = n / (nI * nJ);
+            const bool atBdry[6] = { i == 0, i + 1 == nI, j == 0, j + 1 == nJ, k == 0, k + 1 == nK };
+
+            Vector p[6][4], fc[6], S[6], cc;
+            double V;
+            hex_geom(blk, i, j, k, p, fc, S, cc, V);
+
+            std::array<double, NumOfMetric> val{ 0.0, 1.0, 0.0, 1.0 };
+            double dmin = std::numeric_limits<double>::max(), dmax = 0.0;
+            for (short f = 0; f < 6; ++f)
+            {
+                Vector d;
+                COMMON::delta(cc, fc[f], d);
+                const double L = d.norm();
+                dmin = std::min(dmin, L);
+                dmax = std::max(dmax, L);
+
+                if (!atBdry[f])
+                {
+                    const size_t m = n + stride[f];
+                    d = Vector(cx[m] - cc.x(), cy[m] - cc.y(), cz[m] - cc.z());
+                    if (vol[m] > 0.0)
+                        val[VOLUME_RATIO] = std::max(val[VOLUME_RATIO], std::max(V / vol[m], vol[m] / V));
+                }
+                val[NON_ORTHOGONALITY] = std::max(val[NON_ORTHOGONALITY], angle_between(S[f], d));
+                val[SKEWNESS] = std::max(val[SKEWNESS], equiangle_skewness(p[f], 4));
+            }
+            val[ASPECT_RATIO] = dmin > 0.0 ? dmax / dmin : std::numeric_limits<double>::infinity();
+
+            cur.add(n + 1, val);
+            return true;
+        });
+
+        dst.zone.emplace_back();
+        acc.finalize(blkID, "B" + std::to_string(blkID), dst.zone.back());
+        dst.aborted = stop.load();
+    }
+
+    void REPORT::summary(std::ostream &out) const
+    {
+        static const std::string SEP = "  ";
+
+        if (aborted)
+            out << "Analysis stopped early due to non-positive volume." << std::endl;
+
+        for (const auto &z : zone)
+        {
+            out << "Zone " << z.ID << " \"" << z.name << "\": " << z.nCell << " cells examined, " << z.nNegative << " with non-positive volume" << std::endl;
+            if (!z.negative.empty())
+            {
+                out << SEP << "Non-positive volume:";
+                for (auto e : z.negative)
+                    out << " " << e;
+                out << std::endl;
+            }
+
+            for (int m = 0; m < NumOfMetric; ++m)
+            {
+                out << SEP << metric_name(m) << ": min=" << z.min[m] << ", max=" << z.max[m] << ", mean=" << z.mean[m] << std::endl;
+
+                const size_t nBin = z.histogram[m].size();
+                const double h = (option.upper[m] - option.lower[m]) / std::max<size_t>(nBin, 1);
+                for (size_t b = 0; b < nBin; ++b)
+                {
+                    const double lo = option.lower[m] + b * h;
+                    out << SEP << SEP << "[" << std::setw(10) << lo << ", " << std::setw(10) << lo + h << "): " << z.histogram[m][b] << std::endl;
+                }
+
+                out << SEP << SEP << "Worst:";
+                for (const auto &r : z.worst[m])
+                    out << " " << r.cell << "(" << r.value << ")";
+                out << std::endl;
+            }
+        }
+    }
+}
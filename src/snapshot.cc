@@ -0,0 +1,514 @@
+#include <cstring>
+#include "../inc/xf.h"
+
+#ifdef _WIN32
+#define SNAPSHOT_NO_MMAP
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static const char SNAPSHOT_MAGIC[8] = { 'X', 'F', 'S', 'N', 'A', 'P', '\0', '\0' };
+static const std::uint64_t SNAPSHOT_VERSION = 1;
+
+/// FNV-1a over 64-bit words.
+static std::uint64_t checksum(const std::uint64_t *w, size_t n, std::uint64_t h = 14695981039346656037ULL)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        h ^= w[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/// Size in bytes rounded up to multiples of 8.
+static size_t padded(size_t nBytes)
+{
+    return (nBytes + 7) / 8 * 8;
+}
+
+/// Num of 64-bit words per zone in the zone table:
+/// ID, section, first, last, type offset, type length, name offset, name length.
+static const size_t ZONE_RECORD = 8;
+
+namespace GridTool::XF
+{
+    struct SNAPSHOT::HEADER
+    {
+        char magic[8];
+        std::uint64_t version;
+        std::uint64_t dimension;
+        std::uint64_t nNode, nFace, nCell, nZone;
+        std::uint64_t nFaceNode; /// Total length of face node lists.
+        std::uint64_t nCellFace; /// Total length of cell face lists.
+        std::uint64_t nChar; /// Total length of zone types and names.
+        std::uint64_t payload; /// Size in bytes of everything after the header.
+        std::uint64_t checksum;
+    };
+
+    /// Buffered output with running checksum.
+    /// Everything written is 8-byte aligned after "pad".
+    class SNAPSHOT_WRITER
+    {
+    private:
+        std::ostream &m_out;
+        std::vector<std::uint64_t> m_buf;
+        size_t m_pos; /// In bytes.
+        size_t m_total;
+        std::uint64_t m_hash;
+
+    public:
+        explicit SNAPSHOT_WRITER(std::ostream &out) :
+            m_out(out),
+            m_buf(1 << 17),
+            m_pos(0),
+            m_total(0),
+            m_hash(checksum(nullptr, 0))
+        {
+            /// Empty body.
+        }
+
+        template<typename T>
+        void put(const T &val)
+        {
+            write(&val, sizeof(T));
+        }
+
+        void write(const void *src, size_t n)
+        {
+            const char *p = static_cast<const char*>(src);
+            char *buf = reinterpret_cast<char*>(m_buf.data());
+            const size_t cap = m_buf.size() * sizeof(std::uint64_t);
+            while (n > 0)
+            {
+                const size_t k = std::min(n, cap - m_pos);
+                std::memcpy(buf + m_pos, p, k);
+                m_pos += k;
+                p += k;
+                n -= k;
+                if (m_pos == cap)
+                    flush();
+            }
+        }
+
+        /// Zero-fill up to the next multiple of 8.
+        void pad()
+        {
+            static const char zero[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+            const size_t n = padded(m_total + m_pos) - (m_total + m_pos);
+            write(zero, n);
+        }
+
+        void flush()
+        {
+            pad_check();
+            m_hash = checksum(m_buf.data(), m_pos / sizeof(std::uint64_t), m_hash);
+            m_out.write(reinterpret_cast<const char*>(m_buf.data()), m_pos);
+            m_total += m_pos;
+            m_pos = 0;
+        }
+
+        size_t total() const
+        {
+            return m_total + m_pos;
+        }
+
+        std::uint64_t hash() const
+        {
+            return m_hash;
+        }
+
+    private:
+        void pad_check() const
+        {
+            if (m_pos % sizeof(std::uint64_t) != 0)
+                throw std::runtime_error("Unaligned snapshot record.");
+        }
+    };
+
+    void MESH::writeSnapshot(const std::string &dst) const
+    {
+        std::ofstream fout(dst, std::ios::binary);
+        if (fout.fail())
+            throw std::runtime_error("Failed to open output snapshot file: \"" + dst + "\".");
+
+        SNAPSHOT::HEADER header;
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.version = SNAPSHOT_VERSION;
+        header.dimension = dimension();
+        header.nNode = numOfNode();
+        header.nFace = numOfFace();
+        header.nCell = numOfCell();
+        header.nZone = numOfZone();
+        header.nFaceNode = 0;
+        for (size_t i = 1; i <= numOfFace(); ++i)
+            header.nFaceNode += face(i).includedNode.size();
+        header.nCellFace = 0;
+        for (size_t i = 1; i <= numOfCell(); ++i)
+            header.nCellFace += cell(i).includedFace.size();
+        header.nChar = 0;
+        for (size_t i = 1; i <= numOfZone(); ++i)
+            header.nChar += zone(i).type.size() + zone(i).name.size();
+        header.payload = 0;
+        header.checksum = 0;
+
+        /// Placeholder, rewritten when the payload is done.
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        SNAPSHOT_WRITER w(fout);
+
+        for (size_t i = 1; i <= numOfNode(); ++i)
+            w.write(node(i).coordinate.data(), 3 * sizeof(double));
+
+        std::uint64_t cnt = 0;
+        w.put(cnt);
+        for (size_t i = 1; i <= numOfFace(); ++i)
+        {
+            cnt += face(i).includedNode.size();
+            w.put(cnt);
+        }
+        for (size_t i = 1; i <= numOfFace(); ++i)
+            for (auto e : face(i).includedNode)
+                w.put(static_cast<std::uint64_t>(e));
+        for (size_t i = 1; i <= numOfFace(); ++i)
+            w.put(static_cast<std::int32_t>(face(i).type));
+        w.pad();
+        for (size_t i = 1; i <= numOfFace(); ++i)
+            w.put(static_cast<std::uint64_t>(face(i).leftCell));
+        for (size_t i = 1; i <= numOfFace(); ++i)
+            w.put(static_cast<std::uint64_t>(face(i).rightCell));
+        for (size_t i = 1; i <= numOfFace(); ++i)
+            w.write(face(i).center.data(), 3 * sizeof(double));
+        for (size_t i = 1; i <= numOfFace(); ++i)
+            w.put(face(i).area);
+        for (size_t i = 1; i <= numOfFace(); ++i)
+            w.write(face(i).n_LR.data(), 3 * sizeof(double));
+
+        for (size_t i = 1; i <= numOfCell(); ++i)
+            w.put(static_cast<std::int32_t>(cell(i).type));
+        w.pad();
+        cnt = 0;
+        w.put(cnt);
+        for (size_t i = 1; i <= numOfCell(); ++i)
+        {
+            cnt += cell(i).includedFace.size();
+            w.put(cnt);
+        }
+        for (size_t i = 1; i <= numOfCell(); ++i)
+            for (auto e : cell(i).includedFace)
+                w.put(static_cast<std::uint64_t>(e));
+        for (size_t i = 1; i <= numOfCell(); ++i)
+            w.write(cell(i).center.data(), 3 * sizeof(double));
+        for (size_t i = 1; i <= numOfCell(); ++i)
+            w.put(cell(i).volume);
+
+        std::uint64_t pos = 0;
+        for (size_t i = 1; i <= numOfZone(); ++i)
+        {
+            const auto &z = zone(i);
+            const std::uint64_t rec[ZONE_RECORD] = {
+                z.ID,
+                static_cast<std::uint64_t>(z.obj ? z.obj->identity() : 0),
+                z.obj ? z.obj->first_index() : 0,
+                z.obj ? z.obj->last_index() : 0,
+                pos,
+                z.type.size(),
+                pos + z.type.size(),
+                z.name.size()
+            };
+            w.write(rec, sizeof(rec));
+            pos += z.type.size() + z.name.size();
+        }
+        for (size_t i = 1; i <= numOfZone(); ++i)
+        {
+            w.write(zone(i).type.data(), zone(i).type.size());
+            w.write(zone(i).name.data(), zone(i).name.size());
+        }
+        w.pad();
+        w.flush();
+
+        header.payload = w.total();
+        header.checksum = w.hash();
+        fout.seekp(0);
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!fout)
+            throw std::runtime_error("Failed to write snapshot file: \"" + dst + "\".");
+
+        fout.close();
+    }
+
+    SNAPSHOT::SNAPSHOT(const std::string &src, bool verify) :
+        DIM(3),
+        m_data(nullptr),
+        m_size(0),
+        m_mapped(false),
+        m_header(nullptr)
+    {
+#ifdef SNAPSHOT_NO_MMAP
+        std::ifstream fin(src, std::ios::binary | std::ios::ate);
+        if (fin.fail())
+            throw std::runtime_error("Failed to open input snapshot file: \"" + src + "\".");
+        m_size = fin.tellg();
+        m_buffer.resize(padded(m_size) / sizeof(std::uint64_t));
+        fin.seekg(0);
+        fin.read(reinterpret_cast<char*>(m_buffer.data()), m_size);
+        if (!fin)
+            throw std::runtime_error("Failed to read snapshot file: \"" + src + "\".");
+        fin.close();
+        m_data = reinterpret_cast<const char*>(m_buffer.data());
+#else
+        const int fd = ::open(src.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Failed to open input snapshot file: \"" + src + "\".");
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Failed to query size of snapshot file: \"" + src + "\".");
+        }
+        m_size = st.st_size;
+        if (m_size > 0)
+        {
+            void *p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("Failed to map snapshot file: \"" + src + "\".");
+            }
+            m_data = static_cast<const char*>(p);
+            m_mapped = true;
+        }
+        ::close(fd);
+#endif
+
+        try
+        {
+            if (m_size < sizeof(HEADER))
+                throw std::runtime_error("\"" + src + "\" is not a snapshot file.");
+            m_header = reinterpret_cast<const HEADER*>(m_data);
+            if (std::memcmp(m_header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+                throw std::runtime_error("\"" + src + "\" is not a snapshot file.");
+            if (m_header->version != SNAPSHOT_VERSION)
+                throw std::runtime_error("Unsupported snapshot file version: " + std::to_string(m_header->version) + ".");
+            if (m_header->dimension != 2 && m_header->dimension != 3)
+                throw std::runtime_error("Invalid dimension in snapshot file: " + std::to_string(m_header->dimension) + ".");
+            if (sizeof(HEADER) + m_header->payload != m_size)
+                throw std::runtime_error("Inconsistent size of snapshot file: \"" + src + "\".");
+
+            m_dim = static_cast<int>(m_header->dimension);
+            m_is3D = m_dim == 3;
+
+            /// Locate each array, check against the file size before touching it.
+            size_t pos = sizeof(HEADER);
+            auto take = [&](size_t nBytes) -> const char *
+            {
+                const char *ret = m_data + pos;
+                pos += padded(nBytes);
+                if (pos > m_size)
+                    throw std::runtime_error("Unexpected end of the snapshot file.");
+                return ret;
+            };
+
+            const HEADER &h = *m_header;
+            m_coordinate = reinterpret_cast<const double*>(take(3 * sizeof(double) * h.nNode));
+            m_faceNodeStart = reinterpret_cast<const std::uint64_t*>(take(sizeof(std::uint64_t) * (h.nFace + 1)));
+            m_faceNode = reinterpret_cast<const std::uint64_t*>(take(sizeof(std::uint64_t) * h.nFaceNode));
+            m_faceType = reinterpret_cast<const std::int32_t*>(take(sizeof(std::int32_t) * h.nFace));
+            m_faceLeftCell = reinterpret_cast<const std::uint64_t*>(take(sizeof(std::uint64_t) * h.nFace));
+            m_faceRightCell = reinterpret_cast<const std::uint64_t*>(take(sizeof(std::uint64_t) * h.nFace));
+            m_faceCenter = reinterpret_cast<const double*>(take(3 * sizeof(double) * h.nFace));
+            m_faceArea = reinterpret_cast<const double*>(take(sizeof(double) * h.nFace));
+            m_faceNormal = reinterpret_cast<const double*>(take(3 * sizeof(double) * h.nFace));
+            m_cellType = reinterpret_cast<const std::int32_t*>(take(sizeof(std::int32_t) * h.nCell));
+            m_cellFaceStart = reinterpret_cast<const std::uint64_t*>(take(sizeof(std::uint64_t) * (h.nCell + 1)));
+            m_cellFace = reinterpret_cast<const std::uint64_t*>(take(sizeof(std::uint64_t) * h.nCellFace));
+            m_cellCenter = reinterpret_cast<const double*>(take(3 * sizeof(double) * h.nCell));
+            m_cellVolume = reinterpret_cast<const double*>(take(sizeof(double) * h.nCell));
+            const auto *zoneRec = reinterpret_cast<const std::uint64_t*>(take(ZONE_RECORD * sizeof(std::uint64_t) * h.nZone));
+            const char *zoneChar = take(h.nChar);
+            if (pos != m_size)
+                throw std::runtime_error("Inconsistent layout of snapshot file: \"" + src + "\".");
+            if (m_faceNodeStart[h.nFace] != h.nFaceNode || m_cellFaceStart[h.nCell] != h.nCellFace)
+                throw std::runtime_error("Inconsistent connectivity in snapshot file: \"" + src + "\".");
+
+            if (verify && !this->verify())
+                throw std::runtime_error("Checksum mismatch in snapshot file: \"" + src + "\".");
+
+            m_zone.resize(h.nZone);
+            for (size_t i = 0; i < h.nZone; ++i)
+            {
+                const std::uint64_t *rec = zoneRec + ZONE_RECORD * i;
+                if (rec[4] + rec[5] > h.nChar || rec[6] + rec[7] > h.nChar)
+                    throw std::runtime_error("Invalid zone record in snapshot file: \"" + src + "\".");
+
+                auto &z = m_zone[i];
+                z.ID = rec[0];
+                z.section = static_cast<int>(rec[1]);
+                z.first = rec[2];
+                z.last = rec[3];
+                z.type.assign(zoneChar + rec[4], rec[5]);
+                z.name.assign(zoneChar + rec[6], rec[7]);
+            }
+        }
+        catch (...)
+        {
+#ifndef SNAPSHOT_NO_MMAP
+            if (m_mapped)
+                ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+            throw;
+        }
+    }
+
+    SNAPSHOT::~SNAPSHOT()
+    {
+#ifndef SNAPSHOT_NO_MMAP
+        if (m_mapped)
+            ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    bool SNAPSHOT::verify() const
+    {
+        const auto *payload = reinterpret_cast<const std::uint64_t*>(m_data + sizeof(HEADER));
+        return checksum(payload, m_header->payload / sizeof(std::uint64_t)) == m_header->checksum;
+    }
+
+    size_t SNAPSHOT::numOfNode() const
+    {
+        return m_header->nNode;
+    }
+
+    size_t SNAPSHOT::numOfFace() const
+    {
+        return m_header->nFace;
+    }
+
+    size_t SNAPSHOT::numOfCell() const
+    {
+        return m_header->nCell;
+    }
+
+    size_t SNAPSHOT::numOfZone() const
+    {
+        return m_header->nZone;
+    }
+
+    Vector SNAPSHOT::coordinate(size_t node) const
+    {
+        const double *p = m_coordinate + 3 * (node - 1);
+        return Vector(p[0], p[1], p[2]);
+    }
+
+    int SNAPSHOT::faceType(size_t face) const
+    {
+        return m_faceType[face - 1];
+    }
+
+    SNAPSHOT::LIST SNAPSHOT::faceNode(size_t face) const
+    {
+        return LIST(m_faceNode + m_faceNodeStart[face - 1], m_faceNode + m_faceNodeStart[face]);
+    }
+
+    size_t SNAPSHOT::faceLeftCell(size_t face) const
+    {
+        return m_faceLeftCell[face - 1];
+    }
+
+    size_t SNAPSHOT::faceRightCell(size_t face) const
+    {
+        return m_faceRightCell[face - 1];
+    }
+
+    Vector SNAPSHOT::faceCenter(size_t face) const
+    {
+        const double *p = m_faceCenter + 3 * (face - 1);
+        return Vector(p[0], p[1], p[2]);
+    }
+
+    double SNAPSHOT::faceArea(size_t face) const
+    {
+        return m_faceArea[face - 1];
+    }
+
+    Vector SNAPSHOT::faceNormal(size_t face) const
+    {
+        const double *p = m_faceNormal + 3 * (face - 1);
+        return Vector(p[0], p[1], p[2]);
+    }
+
+    int SNAPSHOT::cellType(size_t cell) const
+    {
+        return m_cellType[cell - 1];
+    }
+
+    SNAPSHOT::LIST SNAPSHOT::cellFace(size_t cell) const
+    {
+        return LIST(m_cellFace + m_cellFaceStart[cell - 1], m_cellFace + m_cellFaceStart[cell]);
+    }
+
+    Vector SNAPSHOT::cellCenter(size_t cell) const
+    {
+        const double *p = m_cellCenter + 3 * (cell - 1);
+        return Vector(p[0], p[1], p[2]);
+    }
+
+    double SNAPSHOT::cellVolume(size_t cell) const
+    {
+        return m_cellVolume[cell - 1];
+    }
+
+    const SNAPSHOT::ZONE_ENTRY &SNAPSHOT::zone(size_t id) const
+    {
+        return m_zone.at(id - 1);
+    }
+
+    SNAPSHOT::LIST SNAPSHOT::adjacentCell(size_t cell) const
+    {
+        std::call_once(m_adjacentCellFlag, [this]()
+        {
+            m_adjacentCell.resize(m_header->nCellFace);
+            COMMON::parallel_for(numOfCell(), [&](size_t first, size_t last)
+            {
+                for (size_t i = first; i < last; ++i)
+                    for (size_t j = m_cellFaceStart[i]; j < m_cellFaceStart[i + 1]; ++j)
+                    {
+                        const size_t f = m_cellFace[j] - 1;
+                        const size_t l = m_faceLeftCell[f], r = m_faceRightCell[f];
+                        m_adjacentCell[j] = l == i + 1 ? r : l;
+                    }
+            });
+        });
+
+        return LIST(m_adjacentCell.data() + m_cellFaceStart[cell - 1], m_adjacentCell.data() + m_cellFaceStart[cell]);
+    }
+
+    SNAPSHOT::LIST SNAPSHOT::dependentFace(size_t node) const
+    {
+        std::call_once(m_dependentFaceFlag, [this]()
+        {
+            /// Count, scan, then fill in ascending order of faces.
+            m_dependentFaceStart.assign(numOfNode() + 1, 0);
+            for (size_t i = 0; i < m_header->nFaceNode; ++i)
+            {
+                const size_t n = m_faceNode[i];
+                if (n == 0 || n > numOfNode())
+                    throw std::runtime_error("Invalid node index in snapshot: " + std::to_string(n) + ".");
+                ++m_dependentFaceStart[n];
+            }
+            for (size_t i = 1; i <= numOfNode(); ++i)
+                m_dependentFaceStart[i] += m_dependentFaceStart[i - 1];
+
+            std::vector<std::uint64_t> loc(m_dependentFaceStart.begin(), m_dependentFaceStart.end() - 1);
+            m_dependentFace.resize(m_header->nFaceNode);
+            for (size_t i = 0; i < numOfFace(); ++i)
+                for (size_t j = m_faceNodeStart[i]; j < m_faceNodeStart[i + 1]; ++j)
+                    m_dependentFace[loc[m_faceNode[j] - 1]++] = i + 1;
+        });
+
+        return LIST(m_dependentFace.data() + m_dependentFaceStart[node - 1], m_dependentFace.data() + m_dependentFaceStart[node]);
+    }
+}
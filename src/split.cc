@@ -0,0 +1,321 @@
+#include <algorithm>
+#include "../inc/nmf.h"
+#include "../inc/plot3d.h"
+
+namespace GridTool::NMF
+{
+    /// Surfaces at the lower and upper end of each direction.
+    static const short SPLIT_LOWER_SURF[3] = { 3, 5, 1 };
+    static const short SPLIT_UPPER_SURF[3] = { 4, 6, 2 };
+
+    /// Direction of the primary and secondary index on each surface, 0 for I, 1 for J, 2 for K.
+    static const short SPLIT_PRI_DIR[Block3D::NumOfSurf] = { 0, 0, 1, 1, 2, 2 };
+    static const short SPLIT_SEC_DIR[Block3D::NumOfSurf] = { 1, 1, 2, 2, 0, 0 };
+
+    static void split_check(const Mapping3D &nmf, const PLOT3D::GRID &grid)
+    {
+        if (!grid.is3D())
+            throw std::invalid_argument("Only 3D grid is supported.");
+        if (grid.numOfBlock() != nmf.nBlock())
+            throw std::invalid_argument("Inconsistent num of blocks between NMF and PLOT3D.");
+        for (size_t n = 1; n <= nmf.nBlock(); ++n)
+        {
+            const auto &b = nmf.block(n);
+            const auto g = grid.block(n - 1);
+            if (b.IDIM() != g->nI() || b.JDIM() != g->nJ() || b.KDIM() != g->nK())
+                throw std::invalid_argument("Inconsistent dimensions of Block " + std::to_string(n) + ".");
+        }
+    }
+
+    void Mapping3D::split(PLOT3D::GRID &grid, size_t b, char dir, const std::vector<size_t> &idx)
+    {
+        split_check(*this, grid);
+        if (dir != 'I' && dir != 'J' && dir != 'K')
+            throw std::invalid_argument("Invalid direction: " + std::string(1, dir) + ".");
+        const short d = dir - 'I';
+        const auto &blk = block(b);
+        const size_t nNode = d == 0 ? blk.IDIM() : (d == 1 ? blk.JDIM() : blk.KDIM());
+        for (size_t i = 0; i < idx.size(); ++i)
+        {
+            if (idx[i] <= 1 || idx[i] >= nNode)
+                throw std::invalid_argument("Node index " + std::to_string(idx[i]) + " is not inside Block " + std::to_string(b) + " along " + std::string(1, dir) + ".");
+            if (i > 0 && idx[i] <= idx[i - 1])
+                throw std::invalid_argument("Node indices are not in ascending order.");
+        }
+        if (idx.empty())
+            return;
+
+        /// The remaining part is always the last block.
+        split_block(grid, b, d, idx[0]);
+        for (size_t i = 1; i < idx.size(); ++i)
+            split_block(grid, nBlock(), d, idx[i] - idx[i - 1] + 1);
+
+        split_propagate(grid);
+        split_rebuild();
+    }
+
+    void Mapping3D::split(PLOT3D::GRID &grid, size_t maxCell)
+    {
+        split_check(*this, grid);
+        if (maxCell == 0)
+            throw std::invalid_argument("Max num of cells must be positive.");
+
+        bool changed = false;
+        while (true)
+        {
+            size_t b = 0, nCell = 0;
+            for (size_t n = 1; n <= nBlock(); ++n)
+            {
+                if (block(n).cell_num() > nCell)
+                {
+                    b = n;
+                    nCell = block(n).cell_num();
+                }
+            }
+            if (nCell <= maxCell)
+                break;
+
+            /// A block with more than 1 cell has at least 2 cells along some direction.
+            const auto &blk = block(b);
+            const size_t nEdge[3] = { blk.IDIM() - 1, blk.JDIM() - 1, blk.KDIM() - 1 };
+            const short d = static_cast<short>(std::max_element(nEdge, nEdge + 3) - nEdge);
+            split_block(grid, b, d, 1 + nEdge[d] / 2);
+            split_propagate(grid);
+            changed = true;
+        }
+
+        if (changed)
+            split_rebuild();
+    }
+
+    void Mapping3D::split_block(PLOT3D::GRID &grid, size_t b, short d, size_t c)
+    {
+        const auto &blk = block(b);
+        const size_t dim[3] = { blk.IDIM(), blk.JDIM(), blk.KDIM() };
+        if (c <= 1 || c >= dim[d])
+            throw std::invalid_argument("Node index " + std::to_string(c) + " is not inside Block " + std::to_string(b) + ".");
+
+        size_t lower[3] = { dim[0], dim[1], dim[2] }, upper[3] = { dim[0], dim[1], dim[2] };
+        lower[d] = c;
+        upper[d] = dim[d] - c + 1;
+        const size_t nb = nBlock() + 1;
+
+        /// Index along the cut direction within a range on block "b", nullptr if the
+        /// range is on other blocks or on surfaces perpendicular to the cut.
+        auto along = [b, d](auto &rg, bool start) -> size_t *
+        {
+            if (rg.B() != b || rg.F() == SPLIT_LOWER_SURF[d] || rg.F() == SPLIT_UPPER_SURF[d])
+                return nullptr;
+            if (SPLIT_PRI_DIR[rg.F() - 1] == d)
+                return start ? &rg.S1() : &rg.E1();
+            else
+                return start ? &rg.S2() : &rg.E2();
+        };
+
+        /// The cut passes through the interior of the range.
+        auto across = [&](auto &rg)
+        {
+            const size_t *s = along(rg, true), *e = along(rg, false);
+            return s != nullptr && std::min(*s, *e) < c && c < std::max(*s, *e);
+        };
+
+        /// Move to the new block if the range is beyond the cut.
+        auto relocate = [&](auto &rg)
+        {
+            if (rg.B() != b)
+                return;
+            if (rg.F() == SPLIT_UPPER_SURF[d])
+                rg.B() = nb;
+            else if (rg.F() != SPLIT_LOWER_SURF[d])
+            {
+                size_t *s = along(rg, true), *e = along(rg, false);
+                if (std::min(*s, *e) >= c)
+                {
+                    rg.B() = nb;
+                    *s -= c - 1;
+                    *e -= c - 1;
+                }
+            }
+        };
+
+        /// Entries are cut into 2 pieces from the starting index to the cut, and from
+        /// the cut to the ending index, so that both sides of an interface keep paired.
+        /// Entries on block "b" are rewritten on copies, and "grid" is split at last,
+        /// so that nothing is changed if an exception is thrown.
+        std::vector<ENTRY*> entry, created, replaced, discarded;
+        Block3D *b1 = nullptr, *b2 = nullptr;
+        auto clone = [&created](const ENTRY *src)
+        {
+            created.push_back(nullptr);
+            auto p = dynamic_cast<const DoubleSideEntry*>(src);
+            if (p)
+                created.back() = new DoubleSideEntry(*p);
+            else
+                created.back() = new SingleSideEntry(*static_cast<const SingleSideEntry*>(src));
+            return created.back();
+        };
+
+        try
+        {
+            entry.reserve(m_entry.size() + 1);
+            for (auto e : m_entry)
+            {
+                auto q = dynamic_cast<DoubleSideEntry*>(e);
+                if (e->Range1().B() != b && (q == nullptr || q->Range2().B() != b))
+                {
+                    entry.push_back(e);
+                    continue;
+                }
+
+                replaced.push_back(e);
+                std::vector<ENTRY*> pending(1, clone(e));
+                while (!pending.empty())
+                {
+                    auto cur = pending.back();
+                    pending.pop_back();
+                    auto p = dynamic_cast<DoubleSideEntry*>(cur);
+
+                    short side = -1;
+                    if (across(cur->Range1()))
+                        side = 0;
+                    else if (p && across(p->Range2()))
+                        side = 1;
+
+                    if (side < 0)
+                    {
+                        relocate(cur->Range1());
+                        if (p)
+                            relocate(p->Range2());
+                        entry.push_back(cur);
+                        continue;
+                    }
+
+                    discarded.push_back(cur);
+                    ENTRY *piece[2] = { clone(cur), clone(cur) };
+
+                    /// The 2nd range is only taken from double-sided entries.
+                    auto range = [side](ENTRY *x, bool self) -> auto &
+                    {
+                        if ((side == 0) == self)
+                            return x->Range1();
+                        return static_cast<DoubleSideEntry*>(x)->Range2();
+                    };
+
+                    auto &rg = range(cur, true);
+                    const bool onPri = SPLIT_PRI_DIR[rg.F() - 1] == d;
+                    const size_t s = onPri ? rg.S1() : rg.S2();
+                    const size_t offset = c > s ? c - s : s - c;
+                    (onPri ? range(piece[0], true).E1() : range(piece[0], true).E2()) = c;
+                    (onPri ? range(piece[1], true).S1() : range(piece[1], true).S2()) = c;
+
+                    if (p)
+                    {
+                        /// Primary direction of one side runs along the secondary one
+                        /// of the other side when swapped.
+                        auto &rgp = range(cur, false);
+                        const bool onPriP = onPri != p->Swap();
+                        const size_t sp = onPriP ? rgp.S1() : rgp.S2();
+                        const size_t ep = onPriP ? rgp.E1() : rgp.E2();
+                        const size_t cp = ep > sp ? sp + offset : sp - offset;
+                        (onPriP ? range(piece[0], false).E1() : range(piece[0], false).E2()) = cp;
+                        (onPriP ? range(piece[1], false).S1() : range(piece[1], false).S2()) = cp;
+                    }
+
+                    pending.push_back(piece[1]);
+                    pending.push_back(piece[0]);
+                }
+            }
+
+            /// Interface between the 2 pieces.
+            const short fl = SPLIT_UPPER_SURF[d], fu = SPLIT_LOWER_SURF[d];
+            const size_t nPri = lower[SPLIT_PRI_DIR[fl - 1]], nSec = lower[SPLIT_SEC_DIR[fl - 1]];
+            created.push_back(nullptr);
+            created.back() = new DoubleSideEntry(BC::idx2str(BC::ONE_TO_ONE), b, fl, 1, nPri, 1, nSec, nb, fu, 1, nPri, 1, nSec, false);
+            entry.push_back(created.back());
+
+            /// The 1st piece keeps the name, the 2nd one is named after it with its own index.
+            b1 = new Block3D(static_cast<int>(lower[0]), static_cast<int>(lower[1]), static_cast<int>(lower[2]));
+            b1->index() = b;
+            b1->name() = blk.name();
+            b2 = new Block3D(static_cast<int>(upper[0]), static_cast<int>(upper[1]), static_cast<int>(upper[2]));
+            b2->index() = nb;
+            b2->name() = (blk.name().empty() ? "B" + std::to_string(b) : blk.name()) + "_" + std::to_string(nb);
+            m_blk.reserve(nb);
+
+            grid.split_block(b - 1, static_cast<char>('I' + d), c);
+        }
+        catch (...)
+        {
+            for (auto e : created)
+                delete e;
+            delete b1;
+            delete b2;
+            throw;
+        }
+
+        /// No exception from here on.
+        for (auto e : replaced)
+            delete e;
+        for (auto e : discarded)
+            delete e;
+        m_entry.swap(entry);
+        delete m_blk(b);
+        m_blk(b) = b1;
+        m_blk.push_back(b2);
+    }
+
+    void Mapping3D::split_propagate(PLOT3D::GRID &grid)
+    {
+        while (true)
+        {
+            /// 1st end of a ONE_TO_ONE range inside its block.
+            size_t b = 0, c = 0;
+            short d = -1;
+            for (auto e : m_entry)
+            {
+                if (e->Type() != BC::ONE_TO_ONE)
+                    continue;
+
+                auto p = static_cast<DoubleSideEntry*>(e);
+                for (auto rg : { &p->Range1(), &p->Range2() })
+                {
+                    const auto &blk = block(rg->B());
+                    const size_t dim[3] = { blk.IDIM(), blk.JDIM(), blk.KDIM() };
+                    const short dp = SPLIT_PRI_DIR[rg->F() - 1], ds = SPLIT_SEC_DIR[rg->F() - 1];
+                    const std::pair<short, size_t> end[4] = { { dp, rg->S1() }, { dp, rg->E1() }, { ds, rg->S2() }, { ds, rg->E2() } };
+                    for (const auto &x : end)
+                    {
+                        if (1 < x.second && x.second < dim[x.first])
+                        {
+                            b = rg->B();
+                            d = x.first;
+                            c = x.second;
+                            break;
+                        }
+                    }
+                    if (b != 0)
+                        break;
+                }
+                if (b != 0)
+                    break;
+            }
+
+            if (b == 0)
+                break;
+            split_block(grid, b, d, c);
+        }
+    }
+
+    void Mapping3D::split_rebuild()
+    {
+        for (auto &e : m_blk)
+        {
+            auto b = new Block3D(*e);
+            b->index() = e->index();
+            b->name() = e->name();
+            delete e;
+            e = b;
+        }
+        compute_topology();
+    }
+}
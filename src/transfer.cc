@@ -0,0 +1,286 @@
+#include <numeric>
+#include "../inc/xf.h"
+
+/// Sampling points of a cell, all with equal share of volume.
+/// Points are "c + (n_i - c) / 2 + (n_j - c) / 4" for all nodes "n_i" and "n_j",
+/// which are centers of the 64 sub-cells of a parallelepiped after splitting twice.
+static void sample_cell(const GridTool::XF::MESH &mesh, size_t i, std::vector<GridTool::COMMON::Vector> &dst)
+{
+    const auto &c = mesh.cell(i);
+    const size_t n = c.includedNode.size();
+
+    std::vector<GridTool::COMMON::Vector> r(n);
+    for (size_t j = 0; j < n; ++j)
+        GridTool::COMMON::delta(c.center, mesh.node(c.includedNode.at(j)).coordinate, r[j]);
+
+    dst.resize(n * n);
+    for (size_t j = 0; j < n; ++j)
+    {
+        for (size_t k = 0; k < n; ++k)
+        {
+            auto &p = dst[j * n + k];
+            for (short m = 0; m < 3; ++m)
+                p[m] = c.center[m] + 0.5 * r[j][m] + 0.25 * r[k][m];
+        }
+    }
+}
+
+/// Merge duplicated columns, sorted by index.
+static void compress(std::vector<std::pair<size_t, double>> &row)
+{
+    std::sort(row.begin(), row.end());
+    size_t n = 0;
+    for (size_t k = 0; k < row.size(); ++k)
+    {
+        if (n > 0 && row[n - 1].first == row[k].first)
+            row[n - 1].second += row[k].second;
+        else
+            row[n++] = row[k];
+    }
+    row.resize(n);
+}
+
+namespace GridTool::XF
+{
+    TRANSFER::TRANSFER() :
+        mode(LINEAR)
+    {
+        /// Empty body.
+    }
+
+    size_t TRANSFER::numOfTarget() const
+    {
+        return start.empty() ? 0 : start.size() - 1;
+    }
+
+    void TRANSFER::build(const MESH &src, const MESH &dst, int m)
+    {
+        if (m != LINEAR && m != CONSERVATIVE)
+            throw std::invalid_argument("Invalid transfer mode: " + std::to_string(m) + ".");
+        mode = m;
+
+        const size_t nSrc = src.numOfCell();
+        const size_t nDst = dst.numOfCell();
+        std::vector<std::vector<std::pair<size_t, double>>> row(nDst);
+
+        const LOCATOR srcLoc(src);
+        if (mode == LINEAR)
+        {
+            COMMON::parallel_for(nDst, [&](size_t first, size_t last)
+            {
+                size_t seed = 0;
+                for (size_t t = first; t < last; ++t)
+                {
+                    const auto &p = dst.cell(t + 1).center;
+                    size_t s = srcLoc.locate(p, seed);
+                    if (s == 0)
+                        s = srcLoc.nearest(p);
+                    else
+                        seed = s;
+
+                    auto &cur = row[t];
+                    cur.emplace_back(s, 1.0);
+
+                    /// Least-squares over interior neighbours only,
+                    /// so that no boundary value is required.
+                    const auto &c = src.cell(s);
+                    double A[9] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+                    for (size_t j = 0; j < c.includedFace.size(); ++j)
+                    {
+                        const size_t adj = c.adjacentCell.at(j);
+                        if (adj == 0)
+                            continue;
+
+                        Vector d;
+                        COMMON::delta(c.center, src.cell(adj).center, d);
+                        const double L2 = d.dot(d);
+                        for (short m = 0; m < 3; ++m)
+                            for (short n = 0; n < 3; ++n)
+                                A[3 * m + n] += d[m] * d[n] / L2;
+                    }
+                    if (!src.is3D())
+                        A[8] = 1.0;
+
+                    /// Too few neighbours, keep the value of the cell.
+                    double B[9];
+                    if (!COMMON::matrix_inverse(A, B))
+                        continue;
+                    if (!src.is3D())
+                        B[8] = 0.0;
+
+                    /// Coefficient of each neighbour is "r^T B d_j / |d_j|^2".
+                    Vector r, rB;
+                    COMMON::delta(c.center, p, r);
+                    for (short k = 0; k < 3; ++k)
+                        rB[k] = r[0] * B[k] + r[1] * B[3 + k] + r[2] * B[6 + k];
+
+                    for (size_t j = 0; j < c.includedFace.size(); ++j)
+                    {
+                        const size_t adj = c.adjacentCell.at(j);
+                        if (adj == 0)
+                            continue;
+
+                        Vector d;
+                        COMMON::delta(c.center, src.cell(adj).center, d);
+                        const double coef = rB.dot(d) / d.dot(d);
+                        cur.emplace_back(adj, coef);
+                        cur.front().second -= coef;
+                    }
+                    compress(cur);
+                }
+            });
+        }
+        else
+        {
+            /// Overlap estimated from samples of target cells.
+            COMMON::parallel_for(nDst, [&](size_t first, size_t last)
+            {
+                std::vector<Vector> pnt;
+                size_t seed = 0;
+                for (size_t t = first; t < last; ++t)
+                {
+                    sample_cell(dst, t + 1, pnt);
+                    const double dv = dst.cell(t + 1).volume / pnt.size();
+                    for (const auto &p : pnt)
+                    {
+                        size_t s = srcLoc.locate(p, seed);
+                        if (s == 0)
+                            s = srcLoc.nearest(p);
+                        else
+                            seed = s;
+                        row[t].emplace_back(s, dv);
+                    }
+                    compress(row[t]);
+                }
+            });
+
+            std::vector<double> colSum(nSrc, 0.0);
+            for (const auto &r : row)
+                for (const auto &e : r)
+                    colSum[e.first - 1] += e.second;
+
+            /// Estimates are more accurate when sampling the finer side.
+            /// Source cells finer than the target cell containing their centroid,
+            /// or missed by all target samples, are sampled in turn.
+            /// Their samples outside the target mesh are dropped.
+            const LOCATOR dstLoc(dst);
+            std::vector<char> fromSrc(nSrc, 0);
+            std::vector<std::vector<std::pair<size_t, double>>> hit(nSrc);
+            COMMON::parallel_for(nSrc, [&](size_t first, size_t last)
+            {
+                std::vector<Vector> pnt;
+                size_t seed = 0;
+                for (size_t s = first; s < last; ++s)
+                {
+                    const auto &c = src.cell(s + 1);
+                    const size_t t0 = dstLoc.locate(c.center, seed);
+                    if (colSum[s] > 0.0 && (t0 == 0 || c.volume > dst.cell(t0).volume))
+                        continue;
+
+                    fromSrc[s] = 1;
+                    sample_cell(src, s + 1, pnt);
+                    const double dv = c.volume / pnt.size();
+                    for (const auto &p : pnt)
+                    {
+                        const size_t t = dstLoc.locate(p, seed);
+                        if (t == 0)
+                            continue;
+                        seed = t;
+                        hit[s].emplace_back(t, dv);
+                    }
+                }
+            });
+
+            COMMON::parallel_for(nDst, [&](size_t first, size_t last)
+            {
+                for (size_t t = first; t < last; ++t)
+                {
+                    auto &r = row[t];
+                    r.erase(std::remove_if(r.begin(), r.end(), [&](const std::pair<size_t, double> &e) { return fromSrc[e.first - 1] != 0; }), r.end());
+                }
+            });
+            for (size_t s = 0; s < nSrc; ++s)
+                for (const auto &e : hit[s])
+                    row[e.first - 1].emplace_back(s + 1, e.second);
+
+            COMMON::parallel_for(nDst, [&](size_t first, size_t last)
+            {
+                for (size_t t = first; t < last; ++t)
+                    compress(row[t]);
+            });
+
+            /// Balance the estimated overlap volumes, so that rows sum to target volumes
+            /// and columns sum to source volumes, by alternating scaling.
+            /// The last step is on columns, thus the integral is preserved exactly.
+            static const size_t NumOfBalance = 8;
+            for (size_t it = 0; it < NumOfBalance; ++it)
+            {
+                COMMON::parallel_for(nDst, [&](size_t first, size_t last)
+                {
+                    for (size_t t = first; t < last; ++t)
+                    {
+                        double sum = 0.0;
+                        for (const auto &e : row[t])
+                            sum += e.second;
+                        if (sum > 0.0)
+                            for (auto &e : row[t])
+                                e.second *= dst.cell(t + 1).volume / sum;
+                    }
+                });
+
+                colSum.assign(nSrc, 0.0);
+                for (const auto &r : row)
+                    for (const auto &e : r)
+                        colSum[e.first - 1] += e.second;
+
+                COMMON::parallel_for(nDst, [&](size_t first, size_t last)
+                {
+                    for (size_t t = first; t < last; ++t)
+                        for (auto &e : row[t])
+                            e.second *= src.cell(e.first).volume / colSum[e.first - 1];
+                });
+            }
+
+            /// Weights are overlap volumes over target volumes.
+            COMMON::parallel_for(nDst, [&](size_t first, size_t last)
+            {
+                for (size_t t = first; t < last; ++t)
+                    for (auto &e : row[t])
+                        e.second /= dst.cell(t + 1).volume;
+            });
+        }
+
+        /// Flatten into CSR.
+        start.assign(nDst + 1, 0);
+        for (size_t t = 0; t < nDst; ++t)
+            start[t + 1] = start[t] + row[t].size();
+        cell.resize(start.back());
+        weight.resize(start.back());
+        COMMON::parallel_for(nDst, [&](size_t first, size_t last)
+        {
+            for (size_t t = first; t < last; ++t)
+            {
+                for (size_t k = 0; k < row[t].size(); ++k)
+                {
+                    cell[start[t] + k] = row[t][k].first;
+                    weight[start[t] + k] = row[t][k].second;
+                }
+            }
+        });
+    }
+
+    void TRANSFER::apply(const std::vector<double> &src, std::vector<double> &dst) const
+    {
+        dst.resize(numOfTarget());
+        COMMON::parallel_for(numOfTarget(), [&](size_t first, size_t last)
+        {
+            for (size_t t = first; t < last; ++t)
+            {
+                double val = 0.0;
+                for (size_t k = start[t]; k < start[t + 1]; ++k)
+                    val += weight[k] * src.at(cell[k] - 1);
+                dst[t] = val;
+            }
+        });
+    }
+}
@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <cstdint>
+#include "../inc/xf.h"
+
+namespace GridTool::XF
+{
+    const std::string &VALIDITY::check_name(int x)
+    {
+        static const std::array<std::string, NumOfCheck> NAME = {
+            "open cell",
+            "wrong orientation",
+            "shared face",
+            "orphan node",
+            "misplaced boundary"
+        };
+
+        if (x < 0 || x >= NumOfCheck)
+            throw wrong_index(x, "is not a valid check index");
+
+        return NAME[x];
+    }
+
+    size_t VALIDITY::total(int check) const
+    {
+        size_t ret = 0;
+        for (const auto &e : zone)
+            ret += e.count.at(check);
+        return ret;
+    }
+
+    bool VALIDITY::ok() const
+    {
+        for (int i = 0; i < NumOfCheck; ++i)
+            if (total(i) > 0)
+                return false;
+        return true;
+    }
+
+    void VALIDITY::summary(std::ostream &out) const
+    {
+        for (const auto &e : zone)
+        {
+            out << "Zone " << e.ID << " \"" << e.name << "\":";
+            bool flag = false;
+            for (int i = 0; i < NumOfCheck; ++i)
+            {
+                if (e.count[i] == 0)
+                    continue;
+                out << " " << e.count[i] << " " << check_name(i) << (e.count[i] > 1 ? "s" : "") << ";";
+                flag = true;
+            }
+            if (!flag)
+                out << " OK";
+            out << std::endl;
+        }
+    }
+
+    void MESH::validate(VALIDITY &dst, double tol) const
+    {
+        const size_t nZone = numOfZone();
+
+        dst.zone.resize(nZone);
+        for (size_t i = 1; i <= nZone; ++i)
+        {
+            auto &cur = dst.zone[i - 1];
+            cur.ID = zone(i).ID;
+            cur.name = zone(i).name;
+            cur.count.fill(0);
+        }
+
+        /// 1-based storage index of zone of each element, 0 if not assigned.
+        std::vector<size_t> nodeZone(numOfNode(), 0), faceZone(numOfFace(), 0), cellZone(numOfCell(), 0);
+        for (size_t i = 1; i <= nZone; ++i)
+        {
+            const auto curObj = zone(i).obj;
+            if (curObj == nullptr)
+                continue;
+
+            std::vector<size_t> *z = nullptr;
+            if (curObj->identity() == SECTION::NODE)
+                z = &nodeZone;
+            else if (curObj->identity() == SECTION::FACE)
+                z = &faceZone;
+            else if (curObj->identity() == SECTION::CELL)
+                z = &cellZone;
+            else
+                continue;
+
+            for (size_t j = curObj->first_index(); j <= curObj->last_index(); ++j)
+                z->at(j - 1) = i;
+        }
+
+        /// Vector area from "leftCell" to "rightCell".
+        /// It only depends on the boundary of the face, so that faces of a closed cell always sum up
+        /// to 0, which is not the case for "S" of cells, as warped quadrilaterals are taken as 2 triangles.
+        auto vector_area = [&](const FACE_ELEM &f, Vector &dst)
+        {
+            const auto &n = f.includedNode;
+            if (n.size() == 2)
+            {
+                dst = f.n_LR;
+                dst *= f.area;
+                return;
+            }
+
+            Vector r1, r2;
+            if (n.size() == 3)
+            {
+                COMMON::delta(node(n(1)).coordinate, node(n(2)).coordinate, r1);
+                COMMON::delta(node(n(1)).coordinate, node(n(3)).coordinate, r2);
+            }
+            else if (n.size() == 4)
+            {
+                COMMON::delta(node(n(1)).coordinate, node(n(3)).coordinate, r1);
+                COMMON::delta(node(n(2)).coordinate, node(n(4)).coordinate, r2);
+            }
+            else
+                throw FACE::polygon_not_supported();
+            dst = r1.cross(r2);
+            dst *= 0.5;
+        };
+
+        /// Sorted nodes of a face, padded with 0.
+        auto face_key = [&](size_t i, std::array<size_t, 4> &dst)
+        {
+            const auto &n = face(i).includedNode;
+            if (n.size() > dst.size())
+                throw FACE::polygon_not_supported();
+            dst.fill(0);
+            std::copy(n.begin(), n.end(), dst.begin());
+            std::sort(dst.begin(), dst.end());
+        };
+
+        /// All elements are checked within a single traversal, with cells first, then faces,
+        /// and nodes at last, as each check only reads derived data. Counting is thread-local.
+        /// Multiplicity of faces is resolved afterwards, as it involves all of them.
+        const size_t nCell = numOfCell(), nFace = numOfFace(), nNode = numOfNode();
+        const size_t nElem = nCell + nFace + nNode;
+        const size_t nChunk = std::max<size_t>(1, COMMON::num_of_thread());
+        std::vector<std::vector<std::array<size_t, VALIDITY::NumOfCheck>>> cnt(nChunk);
+        std::vector<std::pair<std::uint64_t, size_t>> key(nFace);
+        COMMON::parallel_for(nChunk, [&](size_t c0, size_t c1)
+        {
+            Vector s;
+            std::array<size_t, 4> sorted;
+            for (size_t c = c0; c < c1; ++c)
+            {
+                auto &loc = cnt[c];
+                loc.assign(nZone + 1, std::array<size_t, VALIDITY::NumOfCheck>{});
+                for (size_t i = nElem * c / nChunk + 1; i <= nElem * (c + 1) / nChunk; ++i)
+                {
+                    if (i <= nCell)
+                    {
+                        /// Closure
+                        const auto &cur = cell(i);
+                        Vector sum(0.0, 0.0, 0.0);
+                        double area = 0.0;
+                        for (auto f : cur.includedFace)
+                        {
+                            if (f == 0 || f > nFace)
+                                continue;
+
+                            vector_area(face(f), s);
+                            if (face(f).rightCell == i)
+                                s *= -1.0;
+                            sum += s;
+                            area += s.norm();
+                        }
+                        if (!(sum.norm() <= tol * area))
+                            ++loc[cellZone[i - 1]][VALIDITY::OPEN_CELL];
+                    }
+                    else if (i <= nCell + nFace)
+                    {
+                        /// Orientation, zone, and multiplicity
+                        const size_t fi = i - nCell;
+                        const auto &f = face(fi);
+                        auto &cur = loc[faceZone[fi - 1]];
+
+                        bool flag = true;
+                        Vector d;
+                        if (f.leftCell != 0)
+                        {
+                            COMMON::delta(cell(f.leftCell).center, f.center, d);
+                            flag = flag && d.dot(f.n_LR) > 0.0;
+                        }
+                        if (f.rightCell != 0)
+                        {
+                            COMMON::delta(f.center, cell(f.rightCell).center, d);
+                            flag = flag && d.dot(f.n_LR) > 0.0;
+                        }
+                        if (!flag)
+                            ++cur[VALIDITY::WRONG_ORIENTATION];
+
+                        const unsigned nAdj = (f.leftCell != 0) + (f.rightCell != 0);
+                        if (nAdj == 1 && faceZone[fi - 1] != 0)
+                        {
+                            const auto curObj = dynamic_cast<const FACE*>(zone(faceZone[fi - 1]).obj);
+                            if (curObj != nullptr && curObj->bc_type() == BC::INTERIOR)
+                                ++cur[VALIDITY::MISPLACED_BOUNDARY];
+                        }
+
+                        if (nAdj == 0)
+                            ++cur[VALIDITY::SHARED_FACE];
+
+                        /// Hash of sorted nodes for multiplicity.
+                        face_key(fi, sorted);
+                        std::uint64_t h = 14695981039346656037ULL;
+                        for (auto e : sorted)
+                            h = (h ^ e) * 1099511628211ULL;
+                        key[fi - 1] = std::make_pair(h, fi);
+                    }
+                    else
+                    {
+                        /// Usage
+                        const size_t ni = i - nCell - nFace;
+                        if (node(ni).dependentFace.empty())
+                            ++loc[nodeZone[ni - 1]][VALIDITY::ORPHAN_NODE];
+                    }
+                }
+            }
+        });
+
+        /// Faces with identical nodes have the same hash, and are adjacent after sorting.
+        /// Each of them is counted, while collisions of hash are resolved by comparing nodes.
+        std::sort(key.begin(), key.end());
+        std::vector<std::array<size_t, 4>> group;
+        for (size_t i = 0; i < key.size();)
+        {
+            size_t j = i + 1;
+            while (j < key.size() && key[j].first == key[i].first)
+                ++j;
+            if (j - i > 1)
+            {
+                group.resize(j - i);
+                for (size_t k = i; k < j; ++k)
+                    face_key(key[k].second, group[k - i]);
+                for (size_t k = i; k < j; ++k)
+                {
+                    const auto nSame = std::count(group.begin(), group.end(), group[k - i]);
+                    if (nSame > 1)
+                        ++cnt[0][faceZone[key[k].second - 1]][VALIDITY::SHARED_FACE];
+                }
+            }
+            i = j;
+        }
+
+        /// Elements without zone are reported in an extra entry with index 0.
+        std::array<size_t, VALIDITY::NumOfCheck> unassigned{};
+        for (const auto &loc : cnt)
+        {
+            for (size_t i = 0; i < loc.size(); ++i)
+            {
+                auto &cur = i == 0 ? unassigned : dst.zone[i - 1].count;
+                for (int k = 0; k < VALIDITY::NumOfCheck; ++k)
+                    cur[k] += loc[i][k];
+            }
+        }
+        for (auto e : unassigned)
+        {
+            if (e > 0)
+            {
+                dst.zone.push_back(VALIDITY::ZONE_COUNT{ 0, "", unassigned });
+                break;
+            }
+        }
+    }
+}
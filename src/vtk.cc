@@ -0,0 +1,341 @@
+#include <cstdint>
+#include <cstring>
+#include "../inc/xf.h"
+#include "../inc/plot3d.h"
+
+/// VTK cell types
+static const std::uint8_t VTK_TRIANGLE = 5;
+static const std::uint8_t VTK_QUAD = 9;
+static const std::uint8_t VTK_TETRA = 10;
+static const std::uint8_t VTK_HEXAHEDRON = 12;
+static const std::uint8_t VTK_WEDGE = 13;
+static const std::uint8_t VTK_PYRAMID = 14;
+
+static const char *byte_order()
+{
+    const std::uint16_t x = 1;
+    return *reinterpret_cast<const std::uint8_t*>(&x) == 1 ? "LittleEndian" : "BigEndian";
+}
+
+/// Buffered writer of the appended raw data section.
+/// Each array is preceded by its size in bytes as UInt64.
+class APPENDED_WRITER
+{
+private:
+    std::ostream &m_out;
+    std::vector<char> m_buf;
+    size_t m_pos;
+
+public:
+    explicit APPENDED_WRITER(std::ostream &out) :
+        m_out(out),
+        m_buf(1 << 20),
+        m_pos(0)
+    {
+        /// Empty body.
+    }
+
+    ~APPENDED_WRITER()
+    {
+        flush();
+    }
+
+    template<typename T>
+    void put(const T &val)
+    {
+        if (m_pos + sizeof(T) > m_buf.size())
+            flush();
+        std::memcpy(m_buf.data() + m_pos, &val, sizeof(T));
+        m_pos += sizeof(T);
+    }
+
+    void begin(std::uint64_t nBytes)
+    {
+        put(nBytes);
+    }
+
+    void flush()
+    {
+        m_out.write(m_buf.data(), m_pos);
+        m_pos = 0;
+    }
+};
+
+/// Offset of each array within the appended section.
+static std::vector<std::uint64_t> appended_offset(const std::vector<std::uint64_t> &nBytes)
+{
+    std::vector<std::uint64_t> ret(nBytes.size(), 0);
+    for (size_t i = 1; i < nBytes.size(); ++i)
+        ret[i] = ret[i - 1] + sizeof(std::uint64_t) + nBytes[i - 1];
+    return ret;
+}
+
+static double signed_volume(const GridTool::COMMON::Vector &p0, const GridTool::COMMON::Vector &p1, const GridTool::COMMON::Vector &p2, const GridTool::COMMON::Vector &p3)
+{
+    GridTool::COMMON::Vector a, b, c;
+    GridTool::COMMON::delta(p0, p1, a);
+    GridTool::COMMON::delta(p0, p2, b);
+    GridTool::COMMON::delta(p0, p3, c);
+    return a.cross(b).dot(c);
+}
+
+namespace GridTool::XF
+{
+    void MESH::writeToVTK(const std::string &dst) const
+    {
+        /// Cell types and the num of nodes.
+        const size_t nCell = numOfCell();
+        std::vector<std::uint8_t> vtkType(nCell);
+        size_t nConn = 0;
+        for (size_t i = 1; i <= nCell; ++i)
+        {
+            const auto &c = cell(i);
+            std::uint8_t t = 0;
+            size_t n = 0;
+            switch (c.type)
+            {
+            case CELL::TRIANGULAR:
+                t = VTK_TRIANGLE, n = 3;
+                break;
+            case CELL::QUADRILATERAL:
+                t = VTK_QUAD, n = 4;
+                break;
+            case CELL::TETRAHEDRAL:
+                t = VTK_TETRA, n = 4;
+                break;
+            case CELL::PYRAMID:
+                t = VTK_PYRAMID, n = 5;
+                break;
+            case CELL::WEDGE:
+                t = VTK_WEDGE, n = 6;
+                break;
+            case CELL::HEXAHEDRAL:
+                t = VTK_HEXAHEDRON, n = 8;
+                break;
+            default:
+                throw std::runtime_error("Cell " + std::to_string(i) + " of type \"" + CELL::idx2str_elem(c.type) + "\" is not supported in VTK output.");
+            }
+            if (c.includedNode.size() != n)
+                throw std::runtime_error("Inconsistent num of nodes in cell " + std::to_string(i) + ".");
+
+            vtkType[i - 1] = t;
+            nConn += n;
+        }
+
+        /// Real zone index of each cell.
+        std::vector<std::int32_t> cellZone(nCell, 0);
+        for (size_t i = 1; i <= numOfZone(); ++i)
+        {
+            const auto &z = zone(i);
+            if (z.obj == nullptr || z.obj->identity() != SECTION::CELL)
+                continue;
+            for (size_t j = z.obj->first_index(); j <= z.obj->last_index(); ++j)
+                cellZone[j - 1] = static_cast<std::int32_t>(z.ID);
+        }
+
+        std::ofstream fout(dst, std::ios::binary);
+        if (fout.fail())
+            throw std::runtime_error("Failed to open output VTK file: \"" + dst + "\".");
+
+        /// Header
+        const std::vector<std::uint64_t> nBytes = {
+            3 * sizeof(double) * numOfNode(),
+            sizeof(std::int64_t) * nConn,
+            sizeof(std::int64_t) * nCell,
+            sizeof(std::uint8_t) * nCell,
+            sizeof(std::int32_t) * nCell
+        };
+        const auto offset = appended_offset(nBytes);
+
+        fout << "<?xml version=\"1.0\"?>\n";
+        fout << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"" << byte_order() << "\" header_type=\"UInt64\">\n";
+        fout << "  <UnstructuredGrid>\n";
+        fout << "    <Piece NumberOfPoints=\"" << numOfNode() << "\" NumberOfCells=\"" << nCell << "\">\n";
+        fout << "      <Points>\n";
+        fout << "        <DataArray type=\"Float64\" NumberOfComponents=\"3\" format=\"appended\" offset=\"" << offset[0] << "\"/>\n";
+        fout << "      </Points>\n";
+        fout << "      <Cells>\n";
+        fout << "        <DataArray type=\"Int64\" Name=\"connectivity\" format=\"appended\" offset=\"" << offset[1] << "\"/>\n";
+        fout << "        <DataArray type=\"Int64\" Name=\"offsets\" format=\"appended\" offset=\"" << offset[2] << "\"/>\n";
+        fout << "        <DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\"" << offset[3] << "\"/>\n";
+        fout << "      </Cells>\n";
+        fout << "      <CellData Scalars=\"ZoneID\">\n";
+        fout << "        <DataArray type=\"Int32\" Name=\"ZoneID\" format=\"appended\" offset=\"" << offset[4] << "\"/>\n";
+        fout << "      </CellData>\n";
+        fout << "    </Piece>\n";
+        fout << "  </UnstructuredGrid>\n";
+        fout << "  <AppendedData encoding=\"raw\">\n";
+        fout << "_";
+
+        {
+            APPENDED_WRITER w(fout);
+
+            /// Points
+            w.begin(nBytes[0]);
+            for (size_t i = 1; i <= numOfNode(); ++i)
+            {
+                const auto &p = node(i).coordinate;
+                w.put(p.x());
+                w.put(p.y());
+                w.put(p.z());
+            }
+
+            /// Connectivity, 0-based.
+            /// Nodes are permuted when necessary, so that VTK sees positive volumes.
+            w.begin(nBytes[1]);
+            for (size_t i = 1; i <= nCell; ++i)
+            {
+                const auto &c = cell(i);
+                size_t v[8];
+                for (size_t j = 0; j < c.includedNode.size(); ++j)
+                    v[j] = c.includedNode[j];
+
+                auto p = [&](size_t j) -> const Vector & { return node(v[j]).coordinate; };
+                switch (vtkType[i - 1])
+                {
+                case VTK_TETRA:
+                    if (signed_volume(p(0), p(1), p(2), p(3)) < 0.0)
+                        std::swap(v[1], v[2]);
+                    break;
+                case VTK_PYRAMID:
+                    if (signed_volume(p(0), p(1), p(3), p(4)) < 0.0)
+                        std::swap(v[1], v[3]);
+                    break;
+                case VTK_WEDGE:
+                    /// Normal of the 1st triangle points away from the 2nd.
+                    if (signed_volume(p(0), p(1), p(2), p(3)) > 0.0)
+                    {
+                        std::swap(v[1], v[2]);
+                        std::swap(v[4], v[5]);
+                    }
+                    break;
+                case VTK_HEXAHEDRON:
+                    if (signed_volume(p(0), p(1), p(3), p(4)) < 0.0)
+                    {
+                        std::swap(v[1], v[3]);
+                        std::swap(v[5], v[7]);
+                    }
+                    break;
+                default:
+                    break;
+                }
+
+                for (size_t j = 0; j < c.includedNode.size(); ++j)
+                    w.put(static_cast<std::int64_t>(v[j] - 1));
+            }
+
+            /// Offsets
+            w.begin(nBytes[2]);
+            std::int64_t cnt = 0;
+            for (size_t i = 1; i <= nCell; ++i)
+            {
+                cnt += cell(i).includedNode.size();
+                w.put(cnt);
+            }
+
+            /// Types
+            w.begin(nBytes[3]);
+            for (auto e : vtkType)
+                w.put(e);
+
+            /// Zones
+            w.begin(nBytes[4]);
+            for (auto e : cellZone)
+                w.put(e);
+        }
+
+        fout << "\n  </AppendedData>\n";
+        fout << "</VTKFile>\n";
+        if (!fout)
+            throw std::runtime_error("Failed to write VTK file: \"" + dst + "\".");
+        fout.close();
+    }
+}
+
+namespace GridTool::PLOT3D
+{
+    /// Single block as VTK structured grid.
+    static void write_vts(const BLK &b, std::int32_t blkID, const std::string &dst)
+    {
+        std::ofstream fout(dst, std::ios::binary);
+        if (fout.fail())
+            throw std::runtime_error("Failed to open output VTK file: \"" + dst + "\".");
+
+        const size_t nI = b.nI(), nJ = b.nJ(), nK = b.nK();
+        const std::vector<std::uint64_t> nBytes = {
+            3 * sizeof(double) * b.node_num(),
+            sizeof(std::int32_t) * b.cell_num()
+        };
+        const auto offset = appended_offset(nBytes);
+        const std::string extent = "0 " + std::to_string(nI - 1) + " 0 " + std::to_string(nJ - 1) + " 0 " + std::to_string(nK - 1);
+
+        fout << "<?xml version=\"1.0\"?>\n";
+        fout << "<VTKFile type=\"StructuredGrid\" version=\"1.0\" byte_order=\"" << byte_order() << "\" header_type=\"UInt64\">\n";
+        fout << "  <StructuredGrid WholeExtent=\"" << extent << "\">\n";
+        fout << "    <Piece Extent=\"" << extent << "\">\n";
+        fout << "      <Points>\n";
+        fout << "        <DataArray type=\"Float64\" NumberOfComponents=\"3\" format=\"appended\" offset=\"" << offset[0] << "\"/>\n";
+        fout << "      </Points>\n";
+        fout << "      <CellData Scalars=\"BlockID\">\n";
+        fout << "        <DataArray type=\"Int32\" Name=\"BlockID\" format=\"appended\" offset=\"" << offset[1] << "\"/>\n";
+        fout << "      </CellData>\n";
+        fout << "    </Piece>\n";
+        fout << "  </StructuredGrid>\n";
+        fout << "  <AppendedData encoding=\"raw\">\n";
+        fout << "_";
+
+        {
+            APPENDED_WRITER w(fout);
+
+            /// Points, I-index varies fastest.
+            w.begin(nBytes[0]);
+            for (size_t k = 0; k < nK; ++k)
+                for (size_t j = 0; j < nJ; ++j)
+                    for (size_t i = 0; i < nI; ++i)
+                    {
+                        const auto p = b.at(i, j, k);
+                        w.put(p.x());
+                        w.put(p.y());
+                        w.put(p.z());
+                    }
+
+            w.begin(nBytes[1]);
+            for (size_t i = 0; i < b.cell_num(); ++i)
+                w.put(blkID);
+        }
+
+        fout << "\n  </AppendedData>\n";
+        fout << "</VTKFile>\n";
+        if (!fout)
+            throw std::runtime_error("Failed to write VTK file: \"" + dst + "\".");
+        fout.close();
+    }
+
+    void GRID::writeToVTK(const std::string &dst) const
+    {
+        /// Blocks are written next to the ".vtm" file.
+        const size_t sep = dst.find_last_of("/\\");
+        const std::string dir = sep == std::string::npos ? "" : dst.substr(0, sep + 1);
+        std::string stem = sep == std::string::npos ? dst : dst.substr(sep + 1);
+        const size_t dot = stem.find_last_of('.');
+        if (dot != std::string::npos)
+            stem = stem.substr(0, dot);
+
+        std::ofstream fout(dst);
+        if (fout.fail())
+            throw std::runtime_error("Failed to open output VTK file: \"" + dst + "\".");
+
+        fout << "<?xml version=\"1.0\"?>\n";
+        fout << "<VTKFile type=\"vtkMultiBlockDataSet\" version=\"1.0\" byte_order=\"" << byte_order() << "\" header_type=\"UInt64\">\n";
+        fout << "  <vtkMultiBlockDataSet>\n";
+        for (size_t i = 0; i < m_blk.size(); ++i)
+        {
+            const std::string name = stem + "_B" + std::to_string(i + 1) + ".vts";
+            write_vts(*m_blk[i], static_cast<std::int32_t>(i + 1), dir + name);
+            fout << "    <DataSet index=\"" << i << "\" name=\"B" << i + 1 << "\" file=\"" << name << "\"/>\n";
+        }
+        fout << "  </vtkMultiBlockDataSet>\n";
+        fout << "</VTKFile>\n";
+        fout.close();
+    }
+}
@@ -0,0 +1,58 @@
+#include "../inc/bvh.h"
+#include "../inc/xf.h"
+
+namespace GridTool::XF
+{
+    void MESH::wall_distance(std::vector<double> &dst) const
+    {
+        /// Collect wall faces.
+        std::vector<size_t> wall;
+        for (size_t i = 1; i <= numOfZone(); ++i)
+        {
+            const auto curObj = dynamic_cast<const FACE*>(zone(i).obj);
+            if (curObj == nullptr || curObj->bc_type() != BC::WALL)
+                continue;
+
+            for (size_t j = curObj->first_index(); j <= curObj->last_index(); ++j)
+                wall.push_back(j);
+        }
+        if (wall.empty())
+            throw std::runtime_error("No wall boundary found.");
+
+        /// Hierarchy over boxes of wall faces.
+        std::vector<COMMON::BOX> box(wall.size());
+        COMMON::parallel_for(wall.size(), [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+                for (auto e : face(wall[i]).includedNode)
+                    box[i].expand(node(e).coordinate);
+        });
+        COMMON::BVH tree;
+        tree.build(box);
+
+        /// Exact distance from centroids.
+        dst.resize(numOfCell());
+        COMMON::parallel_for(numOfCell(), [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                const auto &p = cell(i + 1).center;
+                tree.nearest(p, [&](size_t k)
+                {
+                    const auto &v = face(wall[k]).includedNode;
+                    switch (v.size())
+                    {
+                    case 2:
+                        return COMMON::point_line_distance(p, node(v[0]).coordinate, node(v[1]).coordinate);
+                    case 3:
+                        return COMMON::point_triangle_distance(p, node(v[0]).coordinate, node(v[1]).coordinate, node(v[2]).coordinate);
+                    case 4:
+                        return COMMON::point_quadrilateral_distance(p, node(v[0]).coordinate, node(v[1]).coordinate, node(v[2]).coordinate, node(v[3]).coordinate);
+                    default:
+                        throw std::runtime_error("Unsupported shape of wall face " + std::to_string(wall[k]) + ".");
+                    }
+                }, dst[i]);
+            }
+        });
+    }
+}
@@ -0,0 +1,133 @@
+#include <cstdint>
+#include <cstring>
+#include "../inc/xf.h"
+
+static const char WEIGHT_MAGIC[8] = { 'X', 'F', 'W', 'G', 'H', 'T', '\0', '\0' };
+static const std::uint64_t WEIGHT_VERSION = 1;
+
+namespace GridTool::XF
+{
+    size_t WEIGHT::numOfCell() const
+    {
+        return lsqInv.size() / 9;
+    }
+
+    size_t WEIGHT::numOfFace() const
+    {
+        return faceWeight.size();
+    }
+
+    void WEIGHT::writeToFile(const std::string &dst) const
+    {
+        std::ofstream fout(dst, std::ios::binary);
+        if (fout.fail())
+            throw std::runtime_error("Failed to open output weight file: \"" + dst + "\".");
+
+        const std::uint64_t header[3] = { WEIGHT_VERSION, numOfCell(), numOfFace() };
+        fout.write(WEIGHT_MAGIC, sizeof(WEIGHT_MAGIC));
+        fout.write(reinterpret_cast<const char*>(header), sizeof(header));
+        fout.write(reinterpret_cast<const char*>(lsqInv.data()), lsqInv.size() * sizeof(double));
+        fout.write(reinterpret_cast<const char*>(faceWeight.data()), faceWeight.size() * sizeof(double));
+        if (!fout)
+            throw std::runtime_error("Failed to write weight file: \"" + dst + "\".");
+
+        fout.close();
+    }
+
+    void WEIGHT::readFromFile(const std::string &src)
+    {
+        std::ifstream fin(src, std::ios::binary);
+        if (fin.fail())
+            throw std::runtime_error("Failed to open input weight file: \"" + src + "\".");
+
+        char magic[sizeof(WEIGHT_MAGIC)];
+        fin.read(magic, sizeof(magic));
+        if (!fin || std::memcmp(magic, WEIGHT_MAGIC, sizeof(WEIGHT_MAGIC)) != 0)
+            throw std::runtime_error("\"" + src + "\" is not a weight file.");
+
+        std::uint64_t header[3] = { 0, 0, 0 };
+        fin.read(reinterpret_cast<char*>(header), sizeof(header));
+        if (!fin)
+            throw std::runtime_error("Unexpected end of the weight file.");
+        if (header[0] != WEIGHT_VERSION)
+            throw std::runtime_error("Unsupported weight file version: " + std::to_string(header[0]) + ".");
+
+        lsqInv.resize(9 * header[1]);
+        faceWeight.resize(header[2]);
+        fin.read(reinterpret_cast<char*>(lsqInv.data()), lsqInv.size() * sizeof(double));
+        fin.read(reinterpret_cast<char*>(faceWeight.data()), faceWeight.size() * sizeof(double));
+        if (!fin)
+            throw std::runtime_error("Unexpected end of the weight file.");
+
+        fin.close();
+    }
+
+    void MESH::compute_weight(WEIGHT &dst) const
+    {
+        dst.lsqInv.assign(9 * numOfCell(), 0.0);
+        dst.faceWeight.assign(numOfFace(), 0.0);
+
+        /// Least-squares matrices
+        COMMON::parallel_for(numOfCell(), [&](size_t first, size_t last)
+        {
+            for (size_t i = first + 1; i <= last; ++i)
+            {
+                const auto &c = cell(i);
+
+                double A[9] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+                for (size_t j = 0; j < c.includedFace.size(); ++j)
+                {
+                    const size_t adj = c.adjacentCell.at(j);
+                    Vector d;
+                    if (adj == 0)
+                        COMMON::delta(c.center, face(c.includedFace.at(j)).center, d);
+                    else
+                        COMMON::delta(c.center, cell(adj).center, d);
+
+                    const double L2 = d.dot(d);
+                    if (L2 == 0.0)
+                        throw std::runtime_error("Coincident centroids around cell " + std::to_string(i) + ".");
+
+                    for (short m = 0; m < 3; ++m)
+                        for (short n = 0; n < 3; ++n)
+                            A[3 * m + n] += d[m] * d[n] / L2;
+                }
+
+                /// In 2D, the Z-DIM is decoupled by a unit diagonal entry.
+                if (!is3D())
+                    A[8] = 1.0;
+
+                double *B = dst.lsqInv.data() + 9 * (i - 1);
+                if (!COMMON::matrix_inverse(A, B))
+                    throw std::runtime_error("Singular least-squares matrix at cell " + std::to_string(i) + ".");
+                if (!is3D())
+                    B[8] = 0.0;
+            }
+        });
+
+        /// Interpolation weights
+        /// Distances are measured along the face normal.
+        COMMON::parallel_for(numOfFace(), [&](size_t first, size_t last)
+        {
+            for (size_t i = first + 1; i <= last; ++i)
+            {
+                const auto &f = face(i);
+                double &w = dst.faceWeight[i - 1];
+
+                if (f.leftCell == 0)
+                    w = 0.0;
+                else if (f.rightCell == 0)
+                    w = 1.0;
+                else
+                {
+                    Vector dL, dR;
+                    COMMON::delta(cell(f.leftCell).center, f.center, dL);
+                    COMMON::delta(f.center, cell(f.rightCell).center, dR);
+                    const double lL = std::fabs(dL.dot(f.n_LR));
+                    const double lR = std::fabs(dR.dot(f.n_LR));
+                    w = lL + lR > 0.0 ? lR / (lL + lR) : 0.5;
+                }
+            }
+        });
+    }
+}
@@ -1,3 +1,6 @@
+#include <charconv>
+#include <cstring>
+#include <sstream>
 #include "../inc/xf.h"
 
 /// Convert a boundary condition string literal to unified form within the scope of this code.
@@ -387,6 +390,45 @@ namespace GridTool::XF
         out << "))" << std::endl;
     }
 
+    void NODE::repr(std::ostream &out, bool fixedWidth)
+    {
+        if (!fixedWidth)
+        {
+            repr(out);
+            return;
+        }
+
+        out << "(" << std::dec << identity();
+        out << " (" << std::hex << zone() << " " << first_index() << " " << last_index() << " ";
+        out << std::dec << type() << " " << ND() << ")(" << std::endl;
+
+        char line[3 * FIXED_WIDTH + 1];
+        const size_t N = num();
+        for (size_t i = 0; i < N; ++i)
+        {
+            const char *end = fixed_width_repr(at(i), m_dim, line);
+            out.write(line, end - line);
+        }
+        out << "))" << std::endl;
+    }
+
+    char *NODE::fixed_width_repr(const Vector &p, int nd, char *dst)
+    {
+        /// 12 significant digits, same as the default format.
+        /// At most 19 chars even with a 3-digit exponent.
+        char buf[FIXED_WIDTH];
+        for (int k = 0; k < nd; ++k)
+        {
+            const auto ret = std::to_chars(buf, buf + sizeof(buf), p.at(k), std::chars_format::scientific, 11);
+            const size_t len = ret.ptr - buf;
+            std::memset(dst, ' ', FIXED_WIDTH - len);
+            std::memcpy(dst + FIXED_WIDTH - len, buf, len);
+            dst += FIXED_WIDTH;
+        }
+        *dst++ = '\n';
+        return dst;
+    }
+
     bool CELL::isValidTypeIdx(int x)
     {
         static const std::set<int> candidate_set{
@@ -1111,7 +1153,12 @@ namespace GridTool::XF
                     node(i).atBdry = flag;
                 }
             }
+        }
 
+        /// Face geometry relies on nodal coordinates,
+        /// while NODE sections may come after FACE sections.
+        for (auto curPtr : m_content)
+        {
             if (curPtr->identity() == SECTION::FACE)
             {
                 auto curObj = dynamic_cast<FACE*>(curPtr);
@@ -1667,7 +1714,7 @@ namespace GridTool::XF
         fout << "Done!" << std::endl;
     }
 
-    void MESH::writeToFile(const std::string &dst) const
+    void MESH::writeToFile(const std::string &dst, bool fixedWidthNode) const
     {
         if (numOfCell() == 0)
             throw std::runtime_error("Invalid num of cells.");
@@ -1707,12 +1754,191 @@ namespace GridTool::XF
 
         /// Contents
         for (; i < m_content.size(); ++i)
-            m_content[i]->repr(fout);
+        {
+            auto curObj = dynamic_cast<NODE*>(m_content[i]);
+            if (curObj && fixedWidthNode)
+                curObj->repr(fout, true);
+            else
+                m_content[i]->repr(fout);
+        }
 
         /// Close grid file
         fout.close();
     }
 
+    void MESH::patchNode(const std::string &dst, const std::vector<Vector> &coord)
+    {
+        std::ifstream fin(dst, std::ios::binary | std::ios::ate);
+        if (fin.fail())
+            throw std::runtime_error("Failed to open grid file: \"" + dst + "\".");
+        const size_t fileSize = static_cast<size_t>(fin.tellg());
+
+        /// Bytes within [at, at + n) of the file.
+        auto peek = [&fin, fileSize](size_t at, size_t n)
+        {
+            std::string ret(n, '\0');
+            if (at + n > fileSize)
+                throw std::runtime_error("Unexpected end of the grid file.");
+            fin.clear();
+            fin.seekg(at);
+            fin.read(&ret[0], n);
+            return ret;
+        };
+
+        /// Sections are found by lines starting with '(',
+        /// while data of NODE sections are skipped as a whole.
+        struct NODE_DATA
+        {
+            size_t first, last;
+            int ND;
+            size_t pos; /// Offset of the 1st char
+        };
+        std::vector<NODE_DATA> section;
+        int dim = 0;
+        size_t totalNodeNum = 0;
+        bool declared = false;
+
+        static const size_t CHUNK = 1 << 22;
+        std::vector<char> buf(CHUNK);
+        size_t bufPos = 0, bufLen = 0;
+        auto load = [&](size_t at)
+        {
+            fin.clear();
+            fin.seekg(at);
+            fin.read(buf.data(), CHUNK);
+            bufPos = at;
+            bufLen = static_cast<size_t>(fin.gcount());
+        };
+
+        size_t pos = 0;
+        while (pos < fileSize)
+        {
+            if (pos < bufPos || pos >= bufPos + bufLen)
+                load(pos);
+
+            const char *first = buf.data() + (pos - bufPos);
+            const char *last = buf.data() + bufLen;
+            auto eol = static_cast<const char*>(std::memchr(first, '\n', last - first));
+            if (!eol && bufPos + bufLen < fileSize)
+            {
+                if (pos == bufPos)
+                    throw std::runtime_error("Line starting at byte " + std::to_string(pos) + " is too long.");
+                load(pos);
+                continue;
+            }
+            const size_t lineEnd = eol ? bufPos + (eol - buf.data()) : fileSize;
+            if (*first != '(')
+            {
+                pos = lineEnd + 1;
+                continue;
+            }
+
+            std::istringstream ss(std::string(first, eol ? eol : last));
+            auto expect = [&ss](char c)
+            {
+                char tmp = 0;
+                ss >> tmp;
+                return tmp == c;
+            };
+            expect('(');
+            int ti = -1;
+            ss >> std::dec >> ti;
+            if (ti == SECTION::DIMENSION)
+                ss >> dim;
+            else if (ti == SECTION::NODE)
+            {
+                if (!expect('('))
+                    throw std::runtime_error("Invalid NODE section at byte " + std::to_string(pos) + ".");
+                size_t zone = 0, first_idx = 0, last_idx = 0;
+                int tp = -1, nd = 0;
+                ss >> std::hex >> zone >> first_idx >> last_idx >> tp;
+                if (!ss)
+                    throw std::runtime_error("Invalid NODE section at byte " + std::to_string(pos) + ".");
+
+                if (zone == 0)
+                {
+                    if (first_idx != 1)
+                        throw std::runtime_error("Invalid \"first-index\" in NODE declaration!");
+                    totalNodeNum = last_idx;
+                    declared = true;
+                }
+                else
+                {
+                    ss >> std::dec >> nd;
+                    if (!expect(')') || ss.get() != '(')
+                        throw std::runtime_error("NODE section at byte " + std::to_string(pos) + " is not followed by data on the next line.");
+                    if (first_idx == 0 || first_idx > last_idx)
+                        throw std::runtime_error("Invalid range of NODE section at byte " + std::to_string(pos) + ".");
+                    if (nd != 2 && nd != 3)
+                        throw std::runtime_error("Invalid ND of NODE section at byte " + std::to_string(pos) + ".");
+
+                    /// Fixed width implies the size of data.
+                    const size_t lineLen = nd * NODE::FIXED_WIDTH + 1;
+                    const size_t dataPos = lineEnd + 1;
+                    const size_t dataLen = (last_idx - first_idx + 1) * lineLen;
+                    if (peek(dataPos + lineLen - 1, 1) != "\n" || peek(dataPos + dataLen - 1, 3) != "\n))")
+                        throw std::runtime_error("NODE section at byte " + std::to_string(pos) + " is not in fixed-width format.");
+
+                    section.push_back({ first_idx, last_idx, nd, dataPos });
+                    pos = dataPos + dataLen;
+                    continue;
+                }
+            }
+            pos = lineEnd + 1;
+        }
+
+        /// Check before touching anything.
+        if (dim != 2 && dim != 3)
+            throw std::runtime_error("Missing or invalid DIMENSION section in \"" + dst + "\".");
+        if (!declared)
+            throw std::runtime_error("Missing NODE declaration in \"" + dst + "\".");
+        if (totalNodeNum != coord.size())
+            throw std::invalid_argument("Inconsistent num of nodes: " + std::to_string(totalNodeNum) + " declared, " + std::to_string(coord.size()) + " given.");
+        if (section.empty())
+            throw std::runtime_error("No NODE section found in \"" + dst + "\".");
+
+        std::sort(section.begin(), section.end(), [](const NODE_DATA &a, const NODE_DATA &b) { return a.first < b.first; });
+        size_t expected = 1;
+        for (const auto &e : section)
+        {
+            if (e.ND != dim)
+                throw std::runtime_error("Inconsistent ND of NODE section with DIMENSION.");
+            if (e.first != expected)
+                throw std::runtime_error("NODE sections do not cover [1, " + std::to_string(totalNodeNum) + "] exactly once.");
+            expected = e.last + 1;
+        }
+        if (expected != totalNodeNum + 1)
+            throw std::runtime_error("NODE sections do not cover [1, " + std::to_string(totalNodeNum) + "] exactly once.");
+        fin.close();
+
+        /// Overwrite in place, text is generated in parallel, a batch at a time.
+        std::fstream fout(dst, std::ios::in | std::ios::out | std::ios::binary);
+        if (fout.fail())
+            throw std::runtime_error("Failed to open grid file: \"" + dst + "\".");
+
+        static const size_t BATCH = 1 << 20;
+        for (const auto &e : section)
+        {
+            const size_t lineLen = e.ND * NODE::FIXED_WIDTH + 1;
+            const size_t N = e.last - e.first + 1;
+            std::vector<char> text(std::min(BATCH, N) * lineLen);
+            fout.seekp(e.pos);
+            for (size_t i0 = 0; i0 < N; i0 += BATCH)
+            {
+                const size_t cnt = std::min(BATCH, N - i0);
+                COMMON::parallel_for(cnt, [&](size_t l, size_t r)
+                {
+                    for (size_t i = l; i < r; ++i)
+                        NODE::fixed_width_repr(coord[e.first - 1 + i0 + i], e.ND, text.data() + i * lineLen);
+                });
+                fout.write(text.data(), cnt * lineLen);
+            }
+        }
+        if (!fout)
+            throw std::runtime_error("Failed to write grid file: \"" + dst + "\".");
+        fout.close();
+    }
+
     void MESH::cell_standardization(CELL_ELEM &c)
     {
         switch (c.type)
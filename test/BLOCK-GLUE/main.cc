@@ -1,40 +1,296 @@
 #include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "../../inc/nmf.h"
+#include "../../inc/plot3d.h"
 #include "../../inc/xf.h"
 
 using namespace GridTool;
 
 static const std::string CASTE_SEP = "  ";
 
+static std::string read_all(const std::string &src)
+{
+    std::ifstream fin(src, std::ios::binary);
+    if (fin.fail())
+        throw std::runtime_error("Failed to open \"" + src + "\".");
+
+    std::ostringstream ss;
+    ss << fin.rdbuf();
+    return ss.str();
+}
+
+/// Same blocks as "p3d", but all surfaces are walls.
+static void write_detached(const PLOT3D::GRID &p3d, const std::string &dst)
+{
+    std::ofstream fout(dst);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open \"" + dst + "\".");
+
+    fout << p3d.numOfBlock() << std::endl;
+    for (size_t n = 0; n < p3d.numOfBlock(); ++n)
+    {
+        const auto b = p3d.block(n);
+        fout << n + 1 << " " << b->nI() << " " << b->nJ() << " " << b->nK() << std::endl;
+    }
+    for (size_t n = 0; n < p3d.numOfBlock(); ++n)
+    {
+        const auto b = p3d.block(n);
+        const size_t nPri[6] = { b->nI(), b->nI(), b->nJ(), b->nJ(), b->nK(), b->nK() };
+        const size_t nSec[6] = { b->nJ(), b->nJ(), b->nK(), b->nK(), b->nI(), b->nI() };
+        for (int s = 1; s <= 6; ++s)
+            fout << "WALL " << n + 1 << " " << s << " 1 " << nPri[s - 1] << " 1 " << nSec[s - 1] << std::endl;
+    }
+}
+
+/// Chain of 4 blocks along X, whose local axes are rotated differently.
+/// Interfaces are swapped, reversed, and both in sequence.
+static void write_chain(const std::string &map_path, const std::string &grid_path)
+{
+    static const size_t dim[4][3] = { { 5, 4, 3 }, { 4, 4, 3 }, { 3, 3, 4 }, { 4, 4, 3 } };
+    static const std::string ONE_TO_ONE[3] = {
+        "ONE_TO_ONE 1 4 1 4 1 3 2 6 1 3 1 4 TRUE",
+        "ONE_TO_ONE 2 5 1 3 1 4 3 3 3 1 1 4 FALSE",
+        "ONE_TO_ONE 3 4 1 3 1 4 4 3 1 4 3 1 TRUE"
+    };
+    static const short linked[4][2] = { { 4, 0 }, { 6, 5 }, { 3, 4 }, { 3, 0 } };
+
+    /// Global lattice index of local node (i, j, k) of block "n".
+    auto global = [](size_t n, size_t i, size_t j, size_t k) -> std::array<size_t, 3>
+    {
+        switch (n)
+        {
+        case 0:
+            return { i, j, k };
+        case 1:
+            return { 7 - j, i, k };
+        case 2:
+            return { 7 + i, k, 2 - j };
+        default:
+            return { 9 + i, j, k };
+        }
+    };
+
+    PLOT3D::GRID grid;
+    for (size_t n = 0; n < 4; ++n)
+    {
+        auto b = grid.add_block(dim[n][0], dim[n][1], dim[n][2]);
+        for (size_t k = 0; k < b->nK(); ++k)
+            for (size_t j = 0; j < b->nJ(); ++j)
+                for (size_t i = 0; i < b->nI(); ++i)
+                {
+                    const auto g = global(n, i, j, k);
+                    const double x = g[0], y = g[1], z = g[2];
+                    b->at(i, j, k) = PLOT3D::Vector(x + 0.1 * std::sin(0.3 * y + 0.2 * z), y + 0.1 * std::sin(0.25 * z + 0.35 * x), z + 0.1 * std::sin(0.15 * x + 0.3 * y));
+                }
+    }
+    grid.writeToFile(grid_path);
+
+    std::ofstream fout(map_path);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open \"" + map_path + "\".");
+    fout << "# Synthetic chain" << std::endl;
+    fout << 4 << std::endl;
+    for (size_t n = 0; n < 4; ++n)
+        fout << n + 1 << " " << dim[n][0] << " " << dim[n][1] << " " << dim[n][2] << std::endl;
+    fout << "#=====================================" << std::endl;
+    for (const auto &e : ONE_TO_ONE)
+        fout << e << std::endl;
+    for (size_t n = 0; n < 4; ++n)
+    {
+        const size_t nPri[6] = { dim[n][0], dim[n][0], dim[n][1], dim[n][1], dim[n][2], dim[n][2] };
+        const size_t nSec[6] = { dim[n][1], dim[n][1], dim[n][2], dim[n][2], dim[n][0], dim[n][0] };
+        for (short s = 1; s <= 6; ++s)
+            if (s != linked[n][0] && s != linked[n][1])
+                fout << "WALL " << n + 1 << " " << s << " 1 " << nPri[s - 1] << " 1 " << nSec[s - 1] << std::endl;
+    }
+}
+
 void test(const std::string &case_name, const std::string &case_desc, const std::string &MAP_PATH, const std::string &GRID_PATH, const std::string &MESH_DIR, const std::string &MESH_NAME)
 {
     const std::string MESH_PATH = MESH_DIR + MESH_NAME + ".msh";
     const std::string REPORT_PATH = MESH_DIR + MESH_NAME + "_report.txt";
 
+    std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
+    std::ofstream frpt(REPORT_PATH);
+    if (frpt.fail())
+        throw std::runtime_error("Failed to open target report file.");
+
+    std::cout << CASTE_SEP << "Combining ..." << std::endl;
+    const XF::MESH mesh(MAP_PATH, GRID_PATH, frpt);
+    frpt.close();
+
+    std::cout << CASTE_SEP << "Writing ..." << std::endl;
+    mesh.writeToFile(MESH_PATH);
+
+    std::cout << CASTE_SEP << "Combining in memory ..." << std::endl;
+    NMF::Mapping3D nmf(MAP_PATH);
+    nmf.numbering();
+    const PLOT3D::GRID p3d(GRID_PATH);
+    const XF::MESH mesh_mem(nmf, p3d, frpt);
+    mesh_mem.writeToFile(MESH_DIR + MESH_NAME + "_mem.msh");
+    if (read_all(MESH_DIR + MESH_NAME + "_mem.msh") != read_all(MESH_PATH))
+        throw std::runtime_error("Mesh glued in memory is inconsistent with the one from files.");
+    XF::VALIDITY validity;
+    mesh_mem.validate(validity);
+    if (!validity.ok())
+        throw std::runtime_error("Invalid mesh glued in memory.");
+    const NMF::Mapping3D unnumbered(MAP_PATH);
+    bool unnumbered_rejected = false;
     try
     {
-        std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
-        std::ofstream frpt(REPORT_PATH);
-        if (frpt.fail())
-            throw std::runtime_error("Failed to open target report file.");
+        const XF::MESH mesh_unnumbered(unnumbered, p3d, frpt);
+    }
+    catch (const std::invalid_argument &)
+    {
+        unnumbered_rejected = true;
+    }
+    if (!unnumbered_rejected)
+        throw std::runtime_error("NMF without numbering is glued.");
 
-        std::cout << CASTE_SEP << "Combining ..." << std::endl;
-        const XF::MESH mesh(MAP_PATH, GRID_PATH, frpt);
-        frpt.close();
+    std::cout << CASTE_SEP << "Detecting ..." << std::endl;
+    NMF::Mapping3D detected;
+    detected.detectFromGrid(p3d, 1e-8);
+    detected.writeToFile(MESH_DIR + MESH_NAME + "_detected.nmf");
+    detected.compute_topology();
+    detected.numbering();
+    if (detected.nNode() != nmf.nNode() || detected.nCell() != nmf.nCell())
+        throw std::runtime_error("Detected connectivity is inconsistent with the given one.");
+    const XF::MESH mesh_detected(detected, p3d, frpt);
+    mesh_detected.writeToFile(MESH_DIR + MESH_NAME + "_detected.msh");
 
-        std::cout << CASTE_SEP << "Writing ..." << std::endl;
-        mesh.writeToFile(MESH_PATH);
+    std::cout << CASTE_SEP << "Merging ..." << std::endl;
+    write_detached(p3d, MESH_DIR + MESH_NAME + "_detached.nmf");
+    NMF::Mapping3D detached(MESH_DIR + MESH_NAME + "_detached.nmf");
+    detached.numbering();
+    XF::MESH mesh_merged(detached, p3d, frpt);
+    mesh_merged.merge_node(1e-8);
+    if (mesh_merged.numOfNode() != mesh.numOfNode() || mesh_merged.numOfFace() != mesh.numOfFace() || mesh_merged.numOfCell() != mesh.numOfCell())
+        throw std::runtime_error("Merged mesh is inconsistent with the glued one.");
+    mesh_merged.writeToFile(MESH_DIR + MESH_NAME + "_merged.msh");
+
+    std::cout << CASTE_SEP << "Assembling ..." << std::endl;
+    std::vector<XF::MESH*> component;
+    for (size_t n = 0; n < p3d.numOfBlock(); ++n)
+    {
+        const auto b = p3d.block(n);
+        PLOT3D::GRID cur;
+        auto d = cur.add_block(b->nI(), b->nJ(), b->nK());
+        for (size_t k = 0; k < b->nK(); ++k)
+            for (size_t j = 0; j < b->nJ(); ++j)
+                for (size_t i = 0; i < b->nI(); ++i)
+                    d->at(i, j, k) = b->at(i, j, k);
+        write_detached(cur, MESH_DIR + MESH_NAME + "_component.nmf");
+        NMF::Mapping3D cur_nmf(MESH_DIR + MESH_NAME + "_component.nmf");
+        cur_nmf.numbering();
+        component.push_back(new XF::MESH(cur_nmf, cur, frpt));
+    }
+    const XF::MESH mesh_assembled(std::vector<const XF::MESH*>(component.begin(), component.end()), 1e-8, frpt);
+    for (auto e : component)
+        delete e;
+    if (mesh_assembled.numOfNode() != mesh.numOfNode() || mesh_assembled.numOfFace() != mesh.numOfFace() || mesh_assembled.numOfCell() != mesh.numOfCell())
+        throw std::runtime_error("Assembled mesh is inconsistent with the glued one.");
+    mesh_assembled.writeToFile(MESH_DIR + MESH_NAME + "_assembled.msh");
+
+    std::cout << CASTE_SEP << "Splitting ..." << std::endl;
+    NMF::Mapping3D nmf_split(nmf);
+    PLOT3D::GRID p3d_split(p3d);
+    const size_t maxCell = std::max<size_t>(nmf.nCell() / 4, 1);
+    nmf_split.split(p3d_split, maxCell);
+    for (size_t n = 1; n <= nmf_split.nBlock(); ++n)
+    {
+        if (nmf_split.block(n).cell_num() > maxCell)
+            throw std::runtime_error("Block " + std::to_string(n) + " is still too large after splitting.");
+        if (n > nmf.nBlock() && nmf_split.block(n).name().empty())
+            throw std::runtime_error("Block " + std::to_string(n) + " is not named after splitting.");
+    }
+    nmf_split.numbering();
+    nmf_split.writeToFile(MESH_DIR + MESH_NAME + "_split.nmf");
+    const XF::MESH mesh_split(nmf_split, p3d_split, frpt);
+    if (mesh_split.numOfNode() != mesh.numOfNode() || mesh_split.numOfFace() != mesh.numOfFace() || mesh_split.numOfCell() != mesh.numOfCell())
+        throw std::runtime_error("Split mesh is inconsistent with the glued one.");
+    mesh_split.writeToFile(MESH_DIR + MESH_NAME + "_split.msh");
 
-        std::cout << CASTE_SEP << "Done!" << std::endl;
+    std::cout << CASTE_SEP << "Patching ..." << std::endl;
+    const std::string FIXED_PATH = MESH_DIR + MESH_NAME + "_fixed.msh";
+    mesh.writeToFile(FIXED_PATH, true);
+    std::vector<XF::Vector> coord(mesh.numOfNode());
+    for (size_t i = 1; i <= mesh.numOfNode(); ++i)
+    {
+        coord[i - 1] = mesh.node(i).coordinate;
+        coord[i - 1] += XF::Vector(0.5, -0.25, 0.125 * (i % 3));
     }
-    catch (std::exception &e)
+    XF::MESH::patchNode(FIXED_PATH, coord);
+    const XF::MESH mesh_patched(FIXED_PATH, frpt);
+    if (mesh_patched.numOfNode() != mesh.numOfNode() || mesh_patched.numOfFace() != mesh.numOfFace() || mesh_patched.numOfCell() != mesh.numOfCell())
+        throw std::runtime_error("Patched mesh is inconsistent with the glued one.");
+    for (size_t i = 1; i <= mesh.numOfNode(); ++i)
     {
-        std::cout << e.what() << std::endl;
+        auto d = mesh_patched.node(i).coordinate;
+        d -= coord[i - 1];
+        if (d.norm() > 1e-9 * (1.0 + coord[i - 1].norm()))
+            throw std::runtime_error("Node " + std::to_string(i) + " is not patched.");
     }
-};
+
+    /// Nodes written by default are not in fixed-width format, the file shall be left untouched.
+    const std::string original = read_all(MESH_PATH);
+    bool rejected = false;
+    try
+    {
+        XF::MESH::patchNode(MESH_PATH, coord);
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    if (!rejected || read_all(MESH_PATH) != original)
+        throw std::runtime_error("Nodes not in fixed-width format are patched.");
+
+    std::cout << CASTE_SEP << "Streaming ..." << std::endl;
+    XF::MESH::glueToFile(MAP_PATH, GRID_PATH, MESH_DIR + MESH_NAME + "_stream.msh");
+    if (read_all(MESH_DIR + MESH_NAME + "_stream.msh") != read_all(MESH_PATH))
+        throw std::runtime_error("Streamed mesh is inconsistent with the glued one.");
+
+    std::cout << CASTE_SEP << "Re-gluing ..." << std::endl;
+    XF::GLUE_SESSION session(MAP_PATH);
+    for (int n = 0; n < 2; ++n)
+    {
+        session.update(GRID_PATH);
+        session.writeToFile(MESH_DIR + MESH_NAME + "_session.msh", true);
+    }
+
+    /// Output modified from elsewhere shall be rewritten entirely.
+    const std::string session_content = read_all(MESH_DIR + MESH_NAME + "_session.msh");
+    std::ofstream(MESH_DIR + MESH_NAME + "_session.msh") << std::string(session_content.size(), '#');
+    session.writeToFile(MESH_DIR + MESH_NAME + "_session.msh", true);
+    if (read_all(MESH_DIR + MESH_NAME + "_session.msh") != session_content)
+        throw std::runtime_error("Session output modified from elsewhere is not rewritten.");
+
+    std::cout << CASTE_SEP << "Batch ..." << std::endl;
+    const size_t nInFlight = COMMON::num_of_thread() + 2;
+    std::vector<std::string> batch_src, batch_dst;
+    for (size_t n = 1; n <= 2 * nInFlight; ++n)
+    {
+        batch_src.push_back(GRID_PATH);
+        batch_dst.push_back(MESH_DIR + MESH_NAME + "_batch" + std::to_string(n) + ".msh");
+    }
+    session.batch(batch_src, batch_dst, nInFlight, true);
+    for (const auto &e : batch_dst)
+        if (read_all(e) != session_content)
+            throw std::runtime_error("Output of batch is inconsistent with the session: \"" + e + "\".");
+
+    std::cout << CASTE_SEP << "Done!" << std::endl;
+
+}
 
 int main(int argc, char *argv[])
 {
     std::cout << "Test the \"Block-Glue\" utilities." << std::endl;
 
+    write_chain("chain.nmf", "chain.fmt");
+    test("Chain", "4 blocks with swapped and reversed interfaces", "chain.nmf", "chain.fmt", "./", "chain");
+
     return 0;
 }
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <chrono>
+#include "../../inc/xf.h"
+
+using namespace GridTool;
+
+static const std::string CASTE_SEP = "  ";
+
+void test(const std::string &case_name, const std::string &case_desc, const std::string &file_dir, const std::string &file_name, size_t nProbe)
+{
+    const std::string REPORT_PATH = file_dir + file_name + "_report.txt";
+    const std::string MESH_PATH = file_dir + file_name + ".msh";
+
+    std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
+    std::ofstream fout(REPORT_PATH);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open report file.");
+
+    std::cout << CASTE_SEP << "Reading ..." << std::endl;
+    XF::MESH msh(MESH_PATH, fout);
+    fout.close();
+
+    std::cout << CASTE_SEP << "Building index ..." << std::endl;
+    auto t0 = std::chrono::steady_clock::now();
+    XF::LOCATOR loc(msh);
+    auto t1 = std::chrono::steady_clock::now();
+    std::cout << CASTE_SEP << CASTE_SEP << std::chrono::duration<double>(t1 - t0).count() << "s" << std::endl;
+
+    /// Each centroid must be found in its own cell.
+    std::cout << CASTE_SEP << "Locating centroids ..." << std::endl;
+    std::vector<COMMON::Vector> pnt(msh.numOfCell());
+    for (size_t i = 1; i <= msh.numOfCell(); ++i)
+        pnt[i - 1] = msh.cell(i).center;
+
+    std::vector<size_t> hit;
+    t0 = std::chrono::steady_clock::now();
+    loc.locate(pnt, hit);
+    t1 = std::chrono::steady_clock::now();
+    std::cout << CASTE_SEP << CASTE_SEP << std::chrono::duration<double>(t1 - t0).count() << "s" << std::endl;
+    for (size_t i = 0; i < hit.size(); ++i)
+        if (hit[i] != i + 1)
+            throw std::runtime_error("Centroid of cell " + std::to_string(i + 1) + " is not located correctly.");
+
+    /// Coherent stream along the diagonal.
+    std::cout << CASTE_SEP << "Locating " << nProbe << " points along the diagonal ..." << std::endl;
+    pnt.resize(nProbe);
+    for (size_t i = 0; i < nProbe; ++i)
+    {
+        const double t = (i + 0.5) / nProbe;
+        pnt[i] = COMMON::Vector(t, t, t);
+    }
+    t0 = std::chrono::steady_clock::now();
+    loc.locate(pnt, hit);
+    t1 = std::chrono::steady_clock::now();
+    std::cout << CASTE_SEP << CASTE_SEP << std::chrono::duration<double>(t1 - t0).count() << "s" << std::endl;
+    for (size_t i = 0; i < hit.size(); ++i)
+        if (hit[i] == 0 || !loc.inside(hit[i], pnt[i]))
+            throw std::runtime_error("Probe " + std::to_string(i) + " is not located correctly.");
+
+    std::cout << CASTE_SEP << "Done!" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << "Testing point location in \"FLUENT\" unstructured mesh ..." << std::endl;
+
+    test("Cavity1", "a 32 x 32 x 32 cube", "../../case/Cavity/FLUENT/", "grid32", 100000);
+    test("Cavity2", "a 128 x 128 x 128 cube", "../../case/Cavity/FLUENT/", "grid128", 1000000);
+
+    return 0;
+}
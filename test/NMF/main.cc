@@ -1,10 +1,16 @@
 #include <iostream>
+#include <chrono>
+#include <type_traits>
+#include <utility>
 #include "../../inc/nmf.h"
 
 using namespace GridTool;
 
 static const std::string CASTE_SEP = "  ";
 
+/// Cells of a const block are accessed through read-only handles.
+static_assert(std::is_same<decltype(std::declval<const NMF::Block3D&>().cell(1, 1, 1)), NMF::Block3D::CONST_CELL_REF>::value, "Cells of a const block shall be read-only.");
+
 void test(const std::string &case_name, const std::string &case_desc, const std::string &file_dir, const std::string &file_name)
 {
     const std::string REPORT_PATH = file_dir + file_name + "_report.txt";
@@ -24,12 +30,98 @@ void test(const std::string &case_name, const std::string &case_desc, const std:
     std::cout << CASTE_SEP << "Numbering ..." << std::endl;
     mapping.numbering();
 
+    std::cout << CASTE_SEP << "Checking implicit numbering ..." << std::endl;
+    NMF::Mapping3D implicit_mapping(MAP_PATH);
+    implicit_mapping.numbering(true);
+    for (size_t n = 1; n <= mapping.nBlock(); ++n)
+    {
+        const auto &b1 = mapping.block(n);
+        const auto &b2 = implicit_mapping.block(n);
+        for (size_t k = 1; k < b1.KDIM(); ++k)
+            for (size_t j = 1; j < b1.JDIM(); ++j)
+                for (size_t i = 1; i < b1.IDIM(); ++i)
+                {
+                    const auto c1 = b1.cell(i, j, k);
+                    const auto c2 = b2.cell(i, j, k);
+                    bool ok = c1.CellSeq() == c2.CellSeq();
+                    for (short r = 1; r <= 8; ++r)
+                        ok = ok && c1.NodeSeq(r) == c2.NodeSeq(r);
+                    for (short r = 1; r <= 6; ++r)
+                        ok = ok && c1.FaceSeq(r) == c2.FaceSeq(r);
+                    if (!ok)
+                        throw std::runtime_error("Implicit numbering mismatch in block " + std::to_string(n) + ".");
+                }
+    }
+
+    /// Non-const handles are readable under implicit numbering, but not writable.
+    auto c = implicit_mapping.block(1).cell(1, 1, 1);
+    if (c.CellSeq() != 1 || c.NodeSeq(1) != mapping.block(1).cell(1, 1, 1).NodeSeq(1))
+        throw std::runtime_error("Failed to read cell through a non-const handle.");
+    bool rejected = false;
+    try
+    {
+        c.setCellSeq(1);
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    if (!rejected)
+        throw std::runtime_error("Cell records shall be read-only under implicit numbering.");
+
     std::cout << CASTE_SEP << "Transcribing ..." << std::endl;
     mapping.writeToFile(TRANSCRIPT_PATH);
 
     std::cout << CASTE_SEP << "Done!" << std::endl;
 }
 
+/// Parse a synthetic chain of single-cell blocks, connected along I.
+/// Each block contributes 4 walls, so "nBlk" = 20000 gives about 100k entries.
+void benchmark(const std::string &file_dir, size_t nBlk)
+{
+    const std::string MAP_PATH = file_dir + "chain.nmf";
+
+    std::cout << "Benchmark on a chain of " << nBlk << " blocks ..." << std::endl;
+
+    std::cout << CASTE_SEP << "Generating ..." << std::endl;
+    std::ofstream fout(MAP_PATH);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open synthetic map file.");
+    fout << "# Synthetic chain\n" << nBlk << "\n";
+    for (size_t n = 1; n <= nBlk; ++n)
+        fout << n << " 2 2 2\n";
+    fout << "#=====================================\n";
+    for (size_t n = 1; n <= nBlk; ++n)
+    {
+        for (short f : { 1, 2 })
+            fout << "WALL " << n << " " << f << " 1 2 1 2\n";
+        for (short f : { 5, 6 })
+            fout << "WALL " << n << " " << f << " 1 2 1 2\n";
+        if (n == 1)
+            fout << "SYM " << n << " 3 1 2 1 2\n";
+        if (n == nBlk)
+            fout << "SYM " << n << " 4 1 2 1 2\n";
+        else
+            fout << "ONE_TO_ONE " << n << " 4 1 2 1 2 " << n + 1 << " 3 1 2 1 2 FALSE\n";
+    }
+    fout.close();
+
+    std::cout << CASTE_SEP << "Reading ..." << std::endl;
+    const auto t0 = std::chrono::steady_clock::now();
+    NMF::Mapping3D mapping;
+    mapping.readFromFile(MAP_PATH);
+    const auto t1 = std::chrono::steady_clock::now();
+    std::cout << CASTE_SEP << CASTE_SEP << std::chrono::duration<double>(t1 - t0).count() << "s" << std::endl;
+
+    std::cout << CASTE_SEP << "Numbering ..." << std::endl;
+    mapping.compute_topology();
+    mapping.numbering();
+    if (mapping.nBlock() != nBlk || mapping.nCell() != nBlk || mapping.nNode() != 4 * (nBlk + 1))
+        throw std::runtime_error("Inconsistent topology of the synthetic chain.");
+
+    std::cout << CASTE_SEP << "Done!" << std::endl;
+}
+
 int main(int argc, char *argv[])
 {
     std::cout << "Test the \"Neutral Map File\" utilities." << std::endl;
@@ -37,6 +129,7 @@ int main(int argc, char *argv[])
     test("Cavity", "a single block", "../../case/Cavity/NMF/", "map");
     test("Sky1", "2 blocks connected through 1 surface", "../../case/Sky1/NMF/", "map");
     test("Langley", "4 blocks in 2 x 2 form", "../../case/Langley/NMF/", "map");
+    benchmark("../../case/", 20000);
 
     return 0;
 }
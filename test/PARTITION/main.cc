@@ -0,0 +1,59 @@
+#include <iostream>
+#include "../../inc/xf.h"
+
+using namespace GridTool;
+
+static const std::string CASTE_SEP = "  ";
+
+void test(const std::string &case_name, const std::string &case_desc, const std::string &file_dir, const std::string &file_name, size_t nPart, size_t nLayer)
+{
+    const std::string REPORT_PATH = file_dir + file_name + "_report.txt";
+    const std::string MESH_PATH = file_dir + file_name + ".msh";
+
+    std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
+    std::ofstream fout(REPORT_PATH);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open report file.");
+
+    std::cout << CASTE_SEP << "Reading ..." << std::endl;
+    XF::MESH msh(MESH_PATH, fout);
+    fout.close();
+
+    /// Contiguous slabs of cells.
+    std::vector<size_t> cell_part(msh.numOfCell());
+    for (size_t i = 0; i < cell_part.size(); ++i)
+        cell_part[i] = i * nPart / cell_part.size();
+
+    std::cout << CASTE_SEP << "Partitioning ..." << std::endl;
+    std::vector<XF::PARTITION> part;
+    msh.partition(cell_part, nLayer, part);
+
+    std::cout << CASTE_SEP << "Writing ..." << std::endl;
+    for (const auto &p : part)
+    {
+        const std::string HALO_PATH = file_dir + file_name + "_part" + std::to_string(p.rank) + ".halo";
+        p.writeToFile(HALO_PATH);
+
+        XF::PARTITION q;
+        q.readFromFile(HALO_PATH);
+        if (q.numOfCell() != p.numOfCell() || q.numOfFace() != p.numOfFace() || q.numOfNode() != p.numOfNode())
+            throw std::runtime_error("Inconsistent halo file: \"" + HALO_PATH + "\".");
+
+        std::cout << CASTE_SEP << CASTE_SEP << "Partition " << p.rank << ": " << p.nOwnedCell << " owned cells";
+        for (size_t l = 0; l < p.nLayer; ++l)
+            std::cout << ", " << p.nGhostCell[l] << " ghost cells in layer " << l + 1;
+        std::cout << std::endl;
+    }
+
+    std::cout << CASTE_SEP << "Done!" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << "Test the partitioning utilities of \"FLUENT\" unstructured mesh ..." << std::endl;
+
+    test("Cavity1", "a 32 x 32 x 32 cube in 4 partitions", "../../case/Cavity/FLUENT/", "grid32", 4, 1);
+    test("Cavity2", "a 64 x 64 x 64 cube in 8 partitions", "../../case/Cavity/FLUENT/", "grid64", 8, 2);
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <fstream>
+#include "../../inc/quality.h"
+
+using namespace GridTool;
+
+static const std::string CASTE_SEP = "  ";
+
+void test_fluent(const std::string &case_name, const std::string &case_desc, const std::string &file_dir, const std::string &file_name)
+{
+    const std::string MESH_PATH = file_dir + file_name + ".msh";
+    const std::string LOG_PATH = file_dir + file_name + "_report.txt";
+    const std::string QUALITY_PATH = file_dir + file_name + "_quality.txt";
+
+    std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
+    std::ofstream fout(LOG_PATH);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open report file.");
+
+    std::cout << CASTE_SEP << "Reading ..." << std::endl;
+    XF::MESH msh(MESH_PATH, fout);
+    fout.close();
+
+    std::cout << CASTE_SEP << "Analyzing ..." << std::endl;
+    QUALITY::OPTION opt;
+    QUALITY::REPORT rpt;
+    QUALITY::analyze(msh, opt, rpt);
+
+    std::ofstream qout(QUALITY_PATH);
+    if (qout.fail())
+        throw std::runtime_error("Failed to open quality file.");
+    rpt.summary(qout);
+    qout.close();
+
+    std::cout << CASTE_SEP << "Done!" << std::endl;
+}
+
+void test_plot3d(const std::string &case_name, const std::string &case_desc, const std::string &file_dir, const std::string &file_name)
+{
+    const std::string GRID_PATH = file_dir + file_name + ".fmt";
+    const std::string QUALITY_PATH = file_dir + file_name + "_quality.txt";
+
+    std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
+
+    std::cout << CASTE_SEP << "Reading ..." << std::endl;
+    PLOT3D::GRID p3d(GRID_PATH);
+
+    std::cout << CASTE_SEP << "Analyzing ..." << std::endl;
+    std::ofstream qout(QUALITY_PATH);
+    if (qout.fail())
+        throw std::runtime_error("Failed to open quality file.");
+
+    QUALITY::OPTION opt;
+    for (size_t i = 0; i < p3d.numOfBlock(); ++i)
+    {
+        QUALITY::REPORT rpt;
+        QUALITY::analyze(*p3d.block(i), i + 1, opt, rpt);
+        rpt.summary(qout);
+    }
+    qout.close();
+
+    std::cout << CASTE_SEP << "Done!" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << "Testing quality analysis of grids ..." << std::endl;
+
+    test_fluent("Cavity1", "a 32 x 32 x 32 cube", "../../case/Cavity/FLUENT/", "grid32");
+    test_fluent("Cavity2", "a 256 x 256 x 256 cube", "../../case/Cavity/FLUENT/", "grid256");
+    test_plot3d("Cube1", "a 3D single-block grid", "../../case/PLOT3D/", "xyz");
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <iostream>
+#include <chrono>
+#include "../../inc/xf.h"
+
+using namespace GridTool;
+
+static const std::string CASTE_SEP = "  ";
+
+void test(const std::string &case_name, const std::string &case_desc, const std::string &file_dir, const std::string &file_name)
+{
+    const std::string REPORT_PATH = file_dir + file_name + "_report.txt";
+    const std::string MESH_PATH = file_dir + file_name + ".msh";
+    const std::string SNAPSHOT_PATH = file_dir + file_name + ".xfs";
+
+    std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
+    std::ofstream fout(REPORT_PATH);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open report file.");
+
+    std::cout << CASTE_SEP << "Reading ..." << std::endl;
+    auto t0 = std::chrono::steady_clock::now();
+    XF::MESH msh(MESH_PATH, fout);
+    auto t1 = std::chrono::steady_clock::now();
+    fout.close();
+    std::cout << CASTE_SEP << CASTE_SEP << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms" << std::endl;
+
+    std::cout << CASTE_SEP << "Writing ..." << std::endl;
+    msh.writeSnapshot(SNAPSHOT_PATH);
+
+    std::cout << CASTE_SEP << "Loading ..." << std::endl;
+    t0 = std::chrono::steady_clock::now();
+    XF::SNAPSHOT s(SNAPSHOT_PATH);
+    t1 = std::chrono::steady_clock::now();
+    std::cout << CASTE_SEP << CASTE_SEP << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms" << std::endl;
+    if (!s.verify())
+        throw std::runtime_error("Checksum mismatch: \"" + SNAPSHOT_PATH + "\".");
+
+    std::cout << CASTE_SEP << "Comparing ..." << std::endl;
+    if (s.dimension() != msh.dimension() || s.numOfNode() != msh.numOfNode() || s.numOfFace() != msh.numOfFace() || s.numOfCell() != msh.numOfCell() || s.numOfZone() != msh.numOfZone())
+        throw std::runtime_error("Inconsistent size.");
+    for (size_t i = 1; i <= msh.numOfNode(); ++i)
+    {
+        if (s.coordinate(i) != msh.node(i).coordinate)
+            throw std::runtime_error("Inconsistent coordinate of node " + std::to_string(i) + ".");
+
+        const auto dep = s.dependentFace(i);
+        if (dep.size() != msh.node(i).dependentFace.size())
+            throw std::runtime_error("Inconsistent dependent faces of node " + std::to_string(i) + ".");
+        for (auto e : msh.node(i).dependentFace)
+            if (std::find(dep.begin(), dep.end(), e) == dep.end())
+                throw std::runtime_error("Inconsistent dependent faces of node " + std::to_string(i) + ".");
+    }
+    for (size_t i = 1; i <= msh.numOfFace(); ++i)
+    {
+        const auto &f = msh.face(i);
+        const auto nd = s.faceNode(i);
+        if (!std::equal(nd.begin(), nd.end(), f.includedNode.begin(), f.includedNode.end()))
+            throw std::runtime_error("Inconsistent nodes of face " + std::to_string(i) + ".");
+        if (s.faceType(i) != f.type || s.faceLeftCell(i) != f.leftCell || s.faceRightCell(i) != f.rightCell)
+            throw std::runtime_error("Inconsistent face " + std::to_string(i) + ".");
+        if (s.faceCenter(i) != f.center || s.faceArea(i) != f.area || s.faceNormal(i) != f.n_LR)
+            throw std::runtime_error("Inconsistent geometry of face " + std::to_string(i) + ".");
+    }
+    for (size_t i = 1; i <= msh.numOfCell(); ++i)
+    {
+        const auto &c = msh.cell(i);
+        const auto fc = s.cellFace(i);
+        const auto adj = s.adjacentCell(i);
+        if (!std::equal(fc.begin(), fc.end(), c.includedFace.begin(), c.includedFace.end()))
+            throw std::runtime_error("Inconsistent faces of cell " + std::to_string(i) + ".");
+        if (!std::equal(adj.begin(), adj.end(), c.adjacentCell.begin(), c.adjacentCell.end()))
+            throw std::runtime_error("Inconsistent adjacent cells of cell " + std::to_string(i) + ".");
+        if (s.cellType(i) != c.type || s.cellCenter(i) != c.center || s.cellVolume(i) != c.volume)
+            throw std::runtime_error("Inconsistent cell " + std::to_string(i) + ".");
+    }
+    for (size_t i = 1; i <= msh.numOfZone(); ++i)
+    {
+        const auto &z = s.zone(i);
+        if (z.ID != msh.zone(i).ID || z.type != msh.zone(i).type || z.name != msh.zone(i).name)
+            throw std::runtime_error("Inconsistent zone " + std::to_string(i) + ".");
+    }
+
+    std::cout << CASTE_SEP << "Done!" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << "Testing native snapshot of \"FLUENT\" unstructured mesh ..." << std::endl;
+
+    test("Cavity1", "a 32 x 32 x 32 cube", "../../case/Cavity/FLUENT/", "grid32");
+    test("Cavity2", "a 64 x 64 x 64 cube", "../../case/Cavity/FLUENT/", "grid64");
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include "../../inc/xf.h"
+
+using namespace GridTool;
+
+static const std::string CASTE_SEP = "  ";
+
+/// Linear field, reproduced exactly by "LINEAR" mode.
+static double field(const COMMON::Vector &p)
+{
+    return 1.0 + 2.0 * p.x() + 3.0 * p.y() - p.z();
+}
+
+static double integral(const XF::MESH &msh, const std::vector<double> &val)
+{
+    double ret = 0.0;
+    for (size_t i = 1; i <= msh.numOfCell(); ++i)
+        ret += val[i - 1] * msh.cell(i).volume;
+    return ret;
+}
+
+void test(const std::string &case_name, const std::string &case_desc, const std::string &file_dir, const std::string &src_name, const std::string &dst_name)
+{
+    const std::string REPORT_PATH = file_dir + src_name + "_report.txt";
+    const std::string SRC_PATH = file_dir + src_name + ".msh";
+    const std::string DST_PATH = file_dir + dst_name + ".msh";
+
+    std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
+    std::ofstream fout(REPORT_PATH);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open report file.");
+
+    std::cout << CASTE_SEP << "Reading ..." << std::endl;
+    XF::MESH src(SRC_PATH, fout);
+    XF::MESH dst(DST_PATH, fout);
+    fout.close();
+
+    std::vector<double> srcVal(src.numOfCell());
+    for (size_t i = 1; i <= src.numOfCell(); ++i)
+        srcVal[i - 1] = field(src.cell(i).center);
+
+    std::cout << CASTE_SEP << "Linear transfer ..." << std::endl;
+    XF::TRANSFER lin;
+    lin.build(src, dst, XF::TRANSFER::LINEAR);
+    std::vector<double> dstVal;
+    lin.apply(srcVal, dstVal);
+
+    double err = 0.0;
+    for (size_t i = 1; i <= dst.numOfCell(); ++i)
+        err = std::max(err, std::fabs(dstVal[i - 1] - field(dst.cell(i).center)));
+    std::cout << CASTE_SEP << CASTE_SEP << "Max error: " << err << std::endl;
+    if (err > 1e-10)
+        throw std::runtime_error("Linear field is not reproduced.");
+
+    std::cout << CASTE_SEP << "Conservative transfer ..." << std::endl;
+    XF::TRANSFER con;
+    con.build(src, dst, XF::TRANSFER::CONSERVATIVE);
+    con.apply(srcVal, dstVal);
+
+    const double I0 = integral(src, srcVal);
+    const double I1 = integral(dst, dstVal);
+    std::cout << CASTE_SEP << CASTE_SEP << "Integral: " << I0 << " -> " << I1 << std::endl;
+    if (std::fabs(I1 - I0) > 1e-10 * std::fabs(I0))
+        throw std::runtime_error("Integral is not preserved.");
+
+    std::cout << CASTE_SEP << "Done!" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << "Testing solution transfer between \"FLUENT\" unstructured meshes ..." << std::endl;
+
+    test("Cavity1", "from 32 x 32 x 32 to 64 x 64 x 64", "../../case/Cavity/FLUENT/", "grid32", "grid64");
+    test("Cavity2", "from 64 x 64 x 64 to 32 x 32 x 32", "../../case/Cavity/FLUENT/", "grid64", "grid32");
+
+    return 0;
+}
@@ -0,0 +1 @@
+g++ main.cc ../../src/common.cc ../../src/xf.cc ../../src/validate.cc -std=c++17 -O3 -pthread
\ No newline at end of file
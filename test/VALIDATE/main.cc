@@ -0,0 +1,135 @@
+#include <iostream>
+#include <array>
+#include <vector>
+#include "../../inc/xf.h"
+
+using namespace GridTool;
+
+static const std::string CASTE_SEP = "  ";
+
+/// Box of 2 x 1 x 1 hexahedral cells along X, where the corner node in the middle is shifted by "warp".
+/// If "detached" is set, the face between cells is given twice as boundary faces of each cell.
+static void write_box(const std::string &dst, double warp, bool detached)
+{
+    std::ofstream fout(dst);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open \"" + dst + "\".");
+
+    auto nid = [](size_t i, size_t j, size_t k) { return 1 + i + 3 * (j + 2 * k); };
+    std::vector<std::array<size_t, 6>> interior, boundary;
+    for (size_t i = 0; i <= 2; ++i)
+    {
+        const std::array<size_t, 6> p = { nid(i, 0, 0), nid(i, 1, 0), nid(i, 1, 1), nid(i, 0, 1), 0, 0 };
+        const std::array<size_t, 6> q = { p[3], p[2], p[1], p[0], 0, 0 };
+        if (i == 0)
+            boundary.push_back({ p[0], p[1], p[2], p[3], 1, 0 });
+        else if (i == 2)
+            boundary.push_back({ q[0], q[1], q[2], q[3], 2, 0 });
+        else if (!detached)
+            interior.push_back({ p[0], p[1], p[2], p[3], 2, 1 });
+        else
+        {
+            boundary.push_back({ p[0], p[1], p[2], p[3], 2, 0 });
+            boundary.push_back({ q[0], q[1], q[2], q[3], 1, 0 });
+        }
+    }
+    for (size_t i = 0; i < 2; ++i)
+    {
+        for (size_t j = 0; j <= 1; ++j)
+        {
+            const size_t p[4] = { nid(i, j, 0), nid(i, j, 1), nid(i + 1, j, 1), nid(i + 1, j, 0) };
+            if (j == 0)
+                boundary.push_back({ p[0], p[1], p[2], p[3], i + 1, 0 });
+            else
+                boundary.push_back({ p[3], p[2], p[1], p[0], i + 1, 0 });
+        }
+        for (size_t k = 0; k <= 1; ++k)
+        {
+            const size_t p[4] = { nid(i, 0, k), nid(i + 1, 0, k), nid(i + 1, 1, k), nid(i, 1, k) };
+            if (k == 0)
+                boundary.push_back({ p[0], p[1], p[2], p[3], i + 1, 0 });
+            else
+                boundary.push_back({ p[3], p[2], p[1], p[0], i + 1, 0 });
+        }
+    }
+
+    const size_t nFace = interior.size() + boundary.size();
+    fout << std::hex;
+    fout << "(2 3)" << std::endl;
+    fout << "(10 (0 1 c 0 3))" << std::endl;
+    fout << "(12 (0 1 2 0 0))" << std::endl;
+    fout << "(13 (0 1 " << nFace << " 0 0))" << std::endl;
+    fout << "(10 (1 1 c 1 3)(" << std::endl;
+    fout << std::dec;
+    for (size_t k = 0; k <= 1; ++k)
+        for (size_t j = 0; j <= 1; ++j)
+            for (size_t i = 0; i <= 2; ++i)
+                fout << " " << i + (nid(i, j, k) == nid(1, 1, 1) ? warp : 0.0) << " " << j << " " << k << std::endl;
+    fout << "))" << std::endl;
+    fout << std::hex;
+    fout << "(12 (2 1 2 1 4))" << std::endl;
+    size_t first = 1;
+    auto write_face = [&](size_t zone, int bc, const std::vector<std::array<size_t, 6>> &f)
+    {
+        fout << "(13 (" << zone << " " << first << " " << first + f.size() - 1 << " " << bc << " 4)(" << std::endl;
+        for (const auto &e : f)
+            fout << " " << e[0] << " " << e[1] << " " << e[2] << " " << e[3] << " " << e[4] << " " << e[5] << std::endl;
+        fout << "))" << std::endl;
+        first += f.size();
+    };
+    if (!interior.empty())
+        write_face(3, 2, interior);
+    write_face(4, 3, boundary);
+    fout << "(39 (2 fluid FLUID)())" << std::endl;
+    if (!interior.empty())
+        fout << "(39 (3 interior int_FLUID)())" << std::endl;
+    fout << "(39 (4 wall WALL)())" << std::endl;
+}
+
+void test(const std::string &case_name, const std::string &case_desc, const std::string &file_dir, const std::string &file_name)
+{
+    const std::string REPORT_PATH = file_dir + file_name + "_report.txt";
+    const std::string MESH_PATH = file_dir + file_name + ".msh";
+
+    std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
+    std::ofstream fout(REPORT_PATH);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open report file.");
+
+    std::cout << CASTE_SEP << "Reading ..." << std::endl;
+    XF::MESH msh(MESH_PATH, fout);
+    fout.close();
+
+    std::cout << CASTE_SEP << "Validating ..." << std::endl;
+    XF::VALIDITY v;
+    msh.validate(v);
+    v.summary(std::cout);
+    if (!v.ok())
+        throw std::runtime_error("Invalid mesh: \"" + MESH_PATH + "\".");
+
+    std::cout << CASTE_SEP << "Done!" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << "Testing validity of \"FLUENT\" unstructured mesh ..." << std::endl;
+
+    std::cout << "Checking a warped box ..." << std::endl;
+    write_box("warped.msh", 0.2, false);
+    test("Warped", "2 cells with non-planar faces", "./", "warped");
+
+    std::cout << "Checking a box with duplicated faces ..." << std::endl;
+    write_box("detached.msh", 0.0, true);
+    XF::MESH detached("detached.msh", std::cout);
+    XF::VALIDITY v;
+    detached.validate(v);
+    v.summary(std::cout);
+    if (v.total(XF::VALIDITY::SHARED_FACE) != 2)
+        throw std::runtime_error("Duplicated faces are not detected.");
+
+    test("Cavity1", "a 32 x 32 x 32 cube", "../../case/Cavity/FLUENT/", "grid32");
+    test("Cavity2", "a 64 x 64 x 64 cube", "../../case/Cavity/FLUENT/", "grid64");
+    test("Cavity3", "a 128 x 128 x 128 cube", "../../case/Cavity/FLUENT/", "grid128");
+
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include <iostream>
+#include "../../inc/xf.h"
+#include "../../inc/plot3d.h"
+
+using namespace GridTool;
+
+static const std::string CASTE_SEP = "  ";
+
+void test_xf(const std::string &case_name, const std::string &case_desc, const std::string &file_dir, const std::string &file_name)
+{
+    const std::string REPORT_PATH = file_dir + file_name + "_report.txt";
+    const std::string MESH_PATH = file_dir + file_name + ".msh";
+    const std::string VTK_PATH = file_dir + file_name + ".vtu";
+
+    std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
+    std::ofstream fout(REPORT_PATH);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open report file.");
+
+    std::cout << CASTE_SEP << "Reading ..." << std::endl;
+    XF::MESH msh(MESH_PATH, fout);
+    fout.close();
+
+    std::cout << CASTE_SEP << "Writing ..." << std::endl;
+    msh.writeToVTK(VTK_PATH);
+
+    std::cout << CASTE_SEP << "Done!" << std::endl;
+}
+
+void test_p3d(const std::string &case_name, const std::string &case_desc, const std::string &file_dir, const std::string &file_name)
+{
+    const std::string GRID_PATH = file_dir + file_name + ".fmt";
+    const std::string VTK_PATH = file_dir + file_name + ".vtm";
+
+    std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
+
+    std::cout << CASTE_SEP << "Reading ..." << std::endl;
+    PLOT3D::GRID p3d(GRID_PATH);
+
+    std::cout << CASTE_SEP << "Writing ..." << std::endl;
+    p3d.writeToVTK(VTK_PATH);
+
+    std::cout << CASTE_SEP << "Done!" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << "Testing VTK export ..." << std::endl;
+
+    test_xf("Cavity1", "a 32 x 32 x 32 cube", "../../case/Cavity/FLUENT/", "grid32");
+    test_xf("Cavity2", "a 64 x 64 x 64 cube", "../../case/Cavity/FLUENT/", "grid64");
+    test_p3d("Cube1", "a 3D single-block grid", "../../case/PLOT3D/", "xyz");
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <iostream>
+#include <chrono>
+#include "../../inc/xf.h"
+
+using namespace GridTool;
+
+static const std::string CASTE_SEP = "  ";
+
+/// Reference solution by brute force.
+static void brute_force(const XF::MESH &msh, std::vector<double> &dst)
+{
+    dst.assign(msh.numOfCell(), std::numeric_limits<double>::max());
+    for (size_t j = 1; j <= msh.numOfFace(); ++j)
+    {
+        const auto &f = msh.face(j);
+        if (!f.atBdry)
+            continue;
+
+        const auto &v = f.includedNode;
+        for (size_t i = 1; i <= msh.numOfCell(); ++i)
+        {
+            const auto &p = msh.cell(i).center;
+            const double d = COMMON::point_quadrilateral_distance(p, msh.node(v[0]).coordinate, msh.node(v[1]).coordinate, msh.node(v[2]).coordinate, msh.node(v[3]).coordinate);
+            dst[i - 1] = std::min(dst[i - 1], d);
+        }
+    }
+}
+
+void test(const std::string &case_name, const std::string &case_desc, const std::string &file_dir, const std::string &file_name, bool compare)
+{
+    const std::string REPORT_PATH = file_dir + file_name + "_report.txt";
+    const std::string MESH_PATH = file_dir + file_name + ".msh";
+
+    std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
+    std::ofstream fout(REPORT_PATH);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open report file.");
+
+    std::cout << CASTE_SEP << "Reading ..." << std::endl;
+    XF::MESH msh(MESH_PATH, fout);
+    fout.close();
+
+    std::cout << CASTE_SEP << "Computing wall distance with " << COMMON::num_of_thread() << " threads ..." << std::endl;
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<double> d;
+    msh.wall_distance(d);
+    const auto t1 = std::chrono::steady_clock::now();
+    std::cout << CASTE_SEP << CASTE_SEP << std::chrono::duration<double>(t1 - t0).count() << "s for " << msh.numOfCell() << " cells" << std::endl;
+
+    if (compare)
+    {
+        std::cout << CASTE_SEP << "Comparing with brute force ..." << std::endl;
+        std::vector<double> ref;
+        brute_force(msh, ref);
+        const auto t2 = std::chrono::steady_clock::now();
+        std::cout << CASTE_SEP << CASTE_SEP << std::chrono::duration<double>(t2 - t1).count() << "s" << std::endl;
+
+        for (size_t i = 0; i < d.size(); ++i)
+            if (std::fabs(d[i] - ref[i]) > 1e-12)
+                throw std::runtime_error("Inconsistent wall distance at cell " + std::to_string(i + 1) + ".");
+    }
+
+    std::cout << CASTE_SEP << "Done!" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << "Testing wall distance of \"FLUENT\" unstructured mesh ..." << std::endl;
+
+    test("Cavity1", "a 32 x 32 x 32 cube", "../../case/Cavity/FLUENT/", "grid32", true);
+    test("Cavity2", "a 64 x 64 x 64 cube", "../../case/Cavity/FLUENT/", "grid64", false);
+    test("Cavity3", "a 128 x 128 x 128 cube", "../../case/Cavity/FLUENT/", "grid128", false);
+    test("Cavity4", "a 256 x 256 x 256 cube", "../../case/Cavity/FLUENT/", "grid256", false);
+
+    return 0;
+}
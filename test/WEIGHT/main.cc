@@ -0,0 +1,46 @@
+#include <iostream>
+#include "../../inc/xf.h"
+
+using namespace GridTool;
+
+static const std::string CASTE_SEP = "  ";
+
+void test(const std::string &case_name, const std::string &case_desc, const std::string &file_dir, const std::string &file_name)
+{
+    const std::string REPORT_PATH = file_dir + file_name + "_report.txt";
+    const std::string MESH_PATH = file_dir + file_name + ".msh";
+    const std::string WEIGHT_PATH = file_dir + file_name + ".wgt";
+
+    std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
+    std::ofstream fout(REPORT_PATH);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open report file.");
+
+    std::cout << CASTE_SEP << "Reading ..." << std::endl;
+    XF::MESH msh(MESH_PATH, fout);
+    fout.close();
+
+    std::cout << CASTE_SEP << "Computing weights ..." << std::endl;
+    XF::WEIGHT w;
+    msh.compute_weight(w);
+
+    std::cout << CASTE_SEP << "Writing ..." << std::endl;
+    w.writeToFile(WEIGHT_PATH);
+
+    XF::WEIGHT q;
+    q.readFromFile(WEIGHT_PATH);
+    if (q.lsqInv != w.lsqInv || q.faceWeight != w.faceWeight)
+        throw std::runtime_error("Inconsistent weight file: \"" + WEIGHT_PATH + "\".");
+
+    std::cout << CASTE_SEP << "Done!" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << "Testing precomputed weights of \"FLUENT\" unstructured mesh ..." << std::endl;
+
+    test("Cavity1", "a 32 x 32 x 32 cube", "../../case/Cavity/FLUENT/", "grid32");
+    test("Cavity2", "a 64 x 64 x 64 cube", "../../case/Cavity/FLUENT/", "grid64");
+
+    return 0;
+}